@@ -0,0 +1,343 @@
+/**
+ *  \file compressedText.c (definition file)
+ *  \brief Text files read compressed with gzip.
+ *
+ *  A gzip file is read as a stream, through a FILE opened by open_text(), so get_chunk() cuts it in chunks
+ *  like a plain file while it is decompressed. The stream keeps the last decompressed bytes, as get_chunk()
+ *  seeks back to the start of a word cut by the end of a chunk.
+ *
+ *  A BGZF file (written by bgzip) is a series of gzip members, each one with its compressed size in its
+ *  header: index_text_blocks() finds the blocks without decompressing them, and read_text_block()
+ *  decompresses any of them on its own, so the blocks of a file can be decompressed in parallel.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "compressedText.h"
+
+/** \brief decompressed bytes kept by a gzip stream */
+#define STREAM_WINDOW (4 * MAX_BGZF_BLOCK)
+
+/** \brief decompressed bytes before the read position kept when the window slides, for the seeks back */
+#define STREAM_HISTORY (2 * MAX_BGZF_BLOCK)
+
+/** \brief size of the header of a BGZF block, with its BC extra subfield */
+#define BGZF_HEADER 18
+
+/** \brief gzip stream read through a FILE */
+typedef struct GzipStream
+{
+    gzFile gz;
+    unsigned char window[STREAM_WINDOW];
+    long start;     /* position in the text of the first byte of the window */
+    int length;     /* bytes in the window */
+    long position;  /* read position in the text */
+    bool end;       /* the whole text was decompressed */
+} GzipStream;
+
+/**
+ * \brief Decompresses more of a gzip stream into its window, sliding it when it is full.
+ *
+ * \param stream The stream.
+ *
+ * \return true if bytes were added, false at the end of the text or on error.
+ */
+static bool fill_window(GzipStream *stream) {
+    int bytes;
+
+    if (stream->end) {
+        return false;
+    }
+    if (stream->length == STREAM_WINDOW) {
+        long keep = stream->start + stream->length - stream->position + STREAM_HISTORY;
+        int drop = (keep >= stream->length) ? 0 : stream->length - (int) keep;
+        if (drop == 0) {
+            return false;
+        }
+        memmove(stream->window, stream->window + drop, stream->length - drop);
+        stream->start += drop;
+        stream->length -= drop;
+    }
+    bytes = gzread(stream->gz, stream->window + stream->length, STREAM_WINDOW - stream->length);
+    if (bytes <= 0) {
+        stream->end = true;
+        return false;
+    }
+    stream->length += bytes;
+    return true;
+}
+
+/**
+ * \brief Reads from a gzip stream, for fopencookie().
+ */
+static ssize_t read_stream(void *cookie, char *buffer, size_t size) {
+    GzipStream *stream = (GzipStream *) cookie;
+    size_t available;
+
+    while (stream->position >= stream->start + stream->length) {
+        if (!fill_window(stream)) {
+            return 0;
+        }
+    }
+    available = (size_t) (stream->start + stream->length - stream->position);
+    if (size > available) {
+        size = available;
+    }
+    memcpy(buffer, stream->window + (stream->position - stream->start), size);
+    stream->position += (long) size;
+    return (ssize_t) size;
+}
+
+/**
+ * \brief Moves the read position of a gzip stream, for fopencookie(). The position cannot go back further
+ *        than the bytes kept by the window, nor be given from the end of the text.
+ */
+static int seek_stream(void *cookie, off64_t *offset, int whence) {
+    GzipStream *stream = (GzipStream *) cookie;
+    long position;
+
+    if (whence == SEEK_SET) {
+        position = (long) *offset;
+    } else if (whence == SEEK_CUR) {
+        position = stream->position + (long) *offset;
+    } else {
+        return -1;
+    }
+    if (position < stream->start) {
+        return -1;
+    }
+    stream->position = position;
+    *offset = position;
+    return 0;
+}
+
+/**
+ * \brief Closes a gzip stream, for fopencookie().
+ */
+static int close_stream(void *cookie) {
+    GzipStream *stream = (GzipStream *) cookie;
+
+    gzclose(stream->gz);
+    free(stream);
+    return 0;
+}
+
+/**
+ * \brief Reads the header of a BGZF block.
+ *
+ * \param header The first BGZF_HEADER bytes of the block.
+ *
+ * \return the compressed size of the block, or -1 if it is not a BGZF block.
+ */
+static int get_bgzf_length(const unsigned char *header) {
+    if (header[0] != 0x1F || header[1] != 0x8B || header[2] != 8 || (header[3] & 0x04) == 0 ||
+        header[10] != 6 || header[11] != 0 || header[12] != 'B' || header[13] != 'C' || header[14] != 2 ||
+        header[15] != 0) {
+        return -1;
+    }
+    return (header[16] | (header[17] << 8)) + 1;
+}
+
+/**
+ * \brief Gets the format of a text file from its first bytes.
+ *
+ * \param path The path to the file.
+ *
+ * \return TEXT_PLAIN, TEXT_GZIP, TEXT_BGZF or TEXT_ZSTD, or -1 if the file cannot be open.
+ */
+int get_text_format(char *path) {
+    unsigned char header[BGZF_HEADER];
+    size_t bytes;
+    FILE *fp;
+
+    if ((fp = fopen(path, "rb")) == NULL) {
+        return -1;
+    }
+    bytes = fread(header, 1, BGZF_HEADER, fp);
+    fclose(fp);
+    if (bytes >= 4 && header[0] == 0x28 && header[1] == 0xB5 && header[2] == 0x2F && header[3] == 0xFD) {
+        return TEXT_ZSTD;
+    }
+    if (bytes >= 2 && header[0] == 0x1F && header[1] == 0x8B) {
+        return (bytes == BGZF_HEADER && get_bgzf_length(header) > 0) ? TEXT_BGZF : TEXT_GZIP;
+    }
+    return TEXT_PLAIN;
+}
+
+/**
+ * \brief Gets the number of bytes of the text of a file, decompressed.
+ *
+ * \param path The path to the file.
+ *
+ * \return the size of the text, or -1 if the file cannot be read or decompressed.
+ */
+long get_text_size(char *path) {
+    int format = get_text_format(path);
+    long size = 0;
+
+    if (format == TEXT_PLAIN) {
+        FILE *fp = fopen(path, "rb");
+        fseek(fp, 0L, SEEK_END);
+        size = ftell(fp);
+        fclose(fp);
+    } else if (format == TEXT_BGZF) {
+        TextBlock *blocks;
+        int nBlocks = index_text_blocks(path, &blocks);
+        if (nBlocks < 0) {
+            return -1;
+        }
+        for (int i = 0; i < nBlocks; i++) {
+            size += blocks[i].size;
+        }
+        free(blocks);
+    } else if (format == TEXT_GZIP) {
+        static char buffer[MAX_BGZF_BLOCK];
+        gzFile gz = gzopen(path, "rb");
+        int bytes;
+        if (gz == NULL) {
+            return -1;
+        }
+        int error;
+        while ((bytes = gzread(gz, buffer, sizeof(buffer))) > 0) {
+            size += bytes;
+        }
+        (void) gzerror(gz, &error); /* a truncated stream only sets the error */
+        gzclose(gz);
+        if (bytes < 0 || error != Z_OK) {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+    return size;
+}
+
+/**
+ * \brief Opens the text of a file for reading, decompressed on the fly if the file is compressed with gzip.
+ *
+ * \param path The path to the file.
+ *
+ * \return the open text, to be closed with fclose(), or NULL if the file cannot be open.
+ */
+FILE *open_text(char *path) {
+    cookie_io_functions_t functions = {read_stream, NULL, seek_stream, close_stream};
+    GzipStream *stream;
+    FILE *fp;
+    int format = get_text_format(path);
+
+    if (format == TEXT_PLAIN) {
+        return fopen(path, "rb");
+    }
+    if ((format != TEXT_GZIP && format != TEXT_BGZF) || (stream = malloc(sizeof(GzipStream))) == NULL) {
+        return NULL;
+    }
+    if ((stream->gz = gzopen(path, "rb")) == NULL) {
+        free(stream);
+        return NULL;
+    }
+    gzbuffer(stream->gz, MAX_BGZF_BLOCK);
+    stream->start = 0;
+    stream->length = 0;
+    stream->position = 0;
+    stream->end = false;
+    if ((fp = fopencookie(stream, "rb", functions)) == NULL) {
+        close_stream(stream);
+    }
+    return fp;
+}
+
+/**
+ * \brief Finds the blocks of a BGZF file from their headers and trailers, without decompressing them.
+ *
+ * \param path The path to the file.
+ * \param blocks Where the blocks are written, to be freed by the caller.
+ *
+ * \return the number of blocks, or -1 if the file is not a well formed BGZF file.
+ */
+int index_text_blocks(char *path, TextBlock **blocks) {
+    unsigned char header[BGZF_HEADER], trailer[4];
+    int nBlocks = 0, capacity = 0;
+    long offset = 0;
+    FILE *fp;
+
+    *blocks = NULL;
+    if ((fp = fopen(path, "rb")) == NULL) {
+        return -1;
+    }
+    while (fread(header, 1, BGZF_HEADER, fp) == BGZF_HEADER) {
+        int length = get_bgzf_length(header);
+        if (length < BGZF_HEADER + 8 || fseek(fp, offset + length - 4, SEEK_SET) != 0 ||
+            fread(trailer, 1, 4, fp) != 4) {
+            break;
+        }
+        if (nBlocks == capacity) {
+            capacity = (capacity > 0) ? 2 * capacity : 16;
+            if ((*blocks = realloc(*blocks, capacity * sizeof(TextBlock))) == NULL) {
+                fprintf(stderr, "index_text_blocks(): error while allocating memory for the blocks\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        (*blocks)[nBlocks].offset = offset;
+        (*blocks)[nBlocks].length = length;
+        (*blocks)[nBlocks].size = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | (trailer[3] << 24);
+        if ((*blocks)[nBlocks].size > MAX_BGZF_BLOCK) {
+            break;
+        }
+        nBlocks++;
+        offset += length;
+    }
+    if (fseek(fp, 0L, SEEK_END) != 0 || ftell(fp) != offset) { /* the file does not end at a block */
+        fclose(fp);
+        free(*blocks);
+        *blocks = NULL;
+        return -1;
+    }
+    fclose(fp);
+    return nBlocks;
+}
+
+/**
+ * \brief Decompresses a block of a BGZF file.
+ *
+ * \param path The path to the file.
+ * \param block The block.
+ * \param text Where the text of the block is written, with room for MAX_BGZF_BLOCK bytes.
+ *
+ * \return the number of bytes of the text, or -1 if the block cannot be read or decompressed.
+ */
+int read_text_block(char *path, TextBlock block, unsigned char *text) {
+    unsigned char compressed[MAX_BGZF_BLOCK];
+    z_stream strm;
+    FILE *fp;
+    int status;
+
+    if (block.length > MAX_BGZF_BLOCK || (fp = fopen(path, "rb")) == NULL) {
+        return -1;
+    }
+    if (fseek(fp, block.offset, SEEK_SET) != 0 || fread(compressed, 1, block.length, fp) != (size_t) block.length) {
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK) { /* gzip wrapper */
+        return -1;
+    }
+    strm.next_in = compressed;
+    strm.avail_in = (uInt) block.length;
+    strm.next_out = text;
+    strm.avail_out = MAX_BGZF_BLOCK;
+    status = inflate(&strm, Z_FINISH);
+    inflateEnd(&strm);
+    if (status != Z_STREAM_END || (int) strm.total_out != block.size) {
+        return -1;
+    }
+    return (int) strm.total_out;
+}
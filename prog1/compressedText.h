@@ -0,0 +1,34 @@
+/**
+ *  \file compressedText.h (definition file)
+ *  \brief Header file containing the declarations for the text files read compressed.
+ */
+#ifndef COMPRESSED_TEXT_H
+#define COMPRESSED_TEXT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** \brief formats of a text file */
+#define TEXT_PLAIN 0
+#define TEXT_GZIP  1   /* gzip, read as a single stream */
+#define TEXT_BGZF  2   /* gzip made of independent blocks with their size in the header (bgzip) */
+#define TEXT_ZSTD  3   /* recognised, but not supported */
+
+/** \brief maximum number of bytes of a BGZF block, compressed or not */
+#define MAX_BGZF_BLOCK 65536
+
+/** \brief BGZF block of a file, which can be decompressed on its own */
+typedef struct TextBlock
+{
+    long offset;    /* position of the block in the file */
+    int length;     /* compressed bytes */
+    int size;       /* decompressed bytes */
+} TextBlock;
+
+extern int get_text_format(char *path);
+extern long get_text_size(char *path);
+extern FILE *open_text(char *path);
+extern int index_text_blocks(char *path, TextBlock **blocks);
+extern int read_text_block(char *path, TextBlock block, unsigned char *text);
+
+#endif /* COMPRESSED_TEXT_H */
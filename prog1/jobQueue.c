@@ -0,0 +1,228 @@
+/**
+ *  \file jobQueue.c (definition file)
+ *  \brief Spool directory through which jobs are submitted to the service mode.
+ *
+ *  A client submits a job by creating name.job in the spool directory, with the path to one text file
+ *  per line (empty lines and lines starting with # are skipped). The file should be written under another
+ *  name and renamed, so it is never seen half written. The dispatcher claims the job by renaming it to
+ *  name.run, and once every file is processed it writes the results to name.out, again through a rename,
+ *  and removes name.run. Jobs left claimed by a service that did not stop cleanly are submitted again by
+ *  the next one.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "jobQueue.h"
+
+/**
+ * \brief Builds the path to a file of the spool directory.
+ *
+ * \param path Where the path is written, with room for PATH_MAX characters.
+ * \param spoolDir The spool directory.
+ * \param name The name of the file, without its extension.
+ * \param extension The extension of the file.
+ */
+static void get_spool_path(char *path, char *spoolDir, char *name, char *extension) {
+    snprintf(path, PATH_MAX, "%s/%s%s", spoolDir, name, extension);
+}
+
+/**
+ * \brief Gets the name of a job from the name of a file of the spool directory.
+ *
+ * \param entry The name of the file.
+ * \param extension The extension of the files of interest.
+ * \param name Where the name without the extension is written, with room for MAX_JOB_NAME characters.
+ *
+ * \return true if the file has the extension and its name fits, false otherwise.
+ */
+static bool get_job_name(char *entry, char *extension, char *name) {
+    size_t length = strlen(entry), extensionLength = strlen(extension);
+
+    if (length <= extensionLength || length - extensionLength >= MAX_JOB_NAME ||
+        strcmp(entry + length - extensionLength, extension) != 0) {
+        return false;
+    }
+    memcpy(name, entry, length - extensionLength);
+    name[length - extensionLength] = '\0';
+    return true;
+}
+
+/**
+ * \brief Orders the names of the jobs, so they are claimed in the order of their names.
+ */
+static int compare_names(const void *a, const void *b) {
+    return strcmp((const char *) a, (const char *) b);
+}
+
+/**
+ * \brief Submits again the jobs claimed by a previous service that did not finish them.
+ *
+ * \param spoolDir The spool directory.
+ *
+ * \return the number of jobs submitted again, or -1 if the spool directory cannot be read.
+ */
+int requeue_jobs(char *spoolDir) {
+    DIR *dir;
+    struct dirent *entry;
+    char name[MAX_JOB_NAME], from[PATH_MAX], to[PATH_MAX];
+    int nJobs = 0;
+
+    if ((dir = opendir(spoolDir)) == NULL) {
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (get_job_name(entry->d_name, RUN_EXTENSION, name)) {
+            get_spool_path(from, spoolDir, name, RUN_EXTENSION);
+            get_spool_path(to, spoolDir, name, JOB_EXTENSION);
+            if (rename(from, to) == 0) {
+                nJobs++;
+            }
+        }
+    }
+    closedir(dir);
+    return nJobs;
+}
+
+/**
+ * \brief Claims the jobs waiting in the spool directory, in the order of their names.
+ *
+ * \param spoolDir The spool directory.
+ * \param names Where the names of the claimed jobs are written.
+ * \param maxJobs The maximum number of jobs to claim.
+ *
+ * \return the number of jobs claimed.
+ */
+int claim_jobs(char *spoolDir, char names[][MAX_JOB_NAME], int maxJobs) {
+    DIR *dir;
+    struct dirent *entry;
+    char (*waiting)[MAX_JOB_NAME] = NULL, from[PATH_MAX], to[PATH_MAX];
+    int nWaiting = 0, capacity = 0, nClaimed = 0;
+
+    if (maxJobs <= 0 || (dir = opendir(spoolDir)) == NULL) {
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        if (nWaiting == capacity) {
+            capacity = (capacity > 0) ? 2 * capacity : 16;
+            if ((waiting = realloc(waiting, capacity * sizeof(*waiting))) == NULL) {
+                fprintf(stderr, "claim_jobs(): error while allocating memory for the names of the jobs\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (get_job_name(entry->d_name, JOB_EXTENSION, waiting[nWaiting])) {
+            nWaiting++;
+        }
+    }
+    closedir(dir);
+
+    qsort(waiting, nWaiting, sizeof(*waiting), compare_names);
+    for (int i = 0; i < nWaiting && nClaimed < maxJobs; i++) {
+        get_spool_path(from, spoolDir, waiting[i], JOB_EXTENSION);
+        get_spool_path(to, spoolDir, waiting[i], RUN_EXTENSION);
+        if (rename(from, to) == 0) {
+            strcpy(names[nClaimed++], waiting[i]);
+        }
+    }
+    free(waiting);
+    return nClaimed;
+}
+
+/**
+ * \brief Reads the paths to the text files of a claimed job.
+ *
+ * \param spoolDir The spool directory.
+ * \param name The name of the job.
+ * \param files Where the paths are written, to be freed by the caller.
+ * \param maxFiles The maximum number of files of a job.
+ *
+ * \return the number of files, -1 if the job cannot be read, or -2 if it has more than maxFiles files (none
+ * is kept).
+ */
+int read_job(char *spoolDir, char *name, char **files, int maxFiles) {
+    FILE *fp;
+    char path[PATH_MAX], line[PATH_MAX];
+    int nFiles = 0;
+
+    get_spool_path(path, spoolDir, name, RUN_EXTENSION);
+    if ((fp = fopen(path, "r")) == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        if (nFiles == maxFiles) {
+            for (int i = 0; i < nFiles; i++) {
+                free(files[i]);
+            }
+            fclose(fp);
+            return -2;
+        }
+        if ((files[nFiles++] = strdup(line)) == NULL) {
+            fprintf(stderr, "read_job(): error while allocating memory for the files of the job\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    fclose(fp);
+    return nFiles;
+}
+
+/**
+ * \brief Opens the file where the results of a job are written.
+ *
+ * \param spoolDir The spool directory.
+ * \param name The name of the job.
+ *
+ * \return the open file, or NULL if it cannot be created.
+ */
+FILE *open_job_result(char *spoolDir, char *name) {
+    char path[PATH_MAX];
+
+    get_spool_path(path, spoolDir, name, RESULT_EXTENSION ".tmp");
+    return fopen(path, "w");
+}
+
+/**
+ * \brief Publishes the results of a job and removes it from the spool directory.
+ *
+ * \param spoolDir The spool directory.
+ * \param name The name of the job.
+ * \param fp The file of the results, as returned by open_job_result(), or NULL.
+ */
+void close_job_result(char *spoolDir, char *name, FILE *fp) {
+    char from[PATH_MAX], to[PATH_MAX];
+
+    if (fp != NULL) {
+        fclose(fp);
+        get_spool_path(from, spoolDir, name, RESULT_EXTENSION ".tmp");
+        get_spool_path(to, spoolDir, name, RESULT_EXTENSION);
+        if (rename(from, to) != 0) {
+            fprintf(stderr, "Error while writing the results of job %s\n", name);
+        }
+    }
+    get_spool_path(from, spoolDir, name, RUN_EXTENSION);
+    unlink(from);
+}
+
+/**
+ * \brief Checks whether the service was asked to stop. The shutdown file is removed, so the next service
+ * starts normally.
+ *
+ * \param spoolDir The spool directory.
+ *
+ * \return true if the shutdown file was in the spool directory, false otherwise.
+ */
+bool is_shutdown_requested(char *spoolDir) {
+    char path[PATH_MAX];
+
+    get_spool_path(path, spoolDir, SHUTDOWN_FILE, "");
+    return unlink(path) == 0;
+}
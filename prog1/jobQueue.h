@@ -0,0 +1,31 @@
+/**
+ *  \file jobQueue.h (definition file)
+ *  \brief Header file containing the declarations for the spool directory of the service mode.
+ */
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/** \brief maximum length of the name of a job, without its extension */
+#define MAX_JOB_NAME 256
+
+/** \brief extension of a job waiting in the spool directory */
+#define JOB_EXTENSION ".job"
+/** \brief extension of a job claimed by the dispatcher */
+#define RUN_EXTENSION ".run"
+/** \brief extension of the results of a job */
+#define RESULT_EXTENSION ".out"
+
+/** \brief file whose presence in the spool directory stops the service */
+#define SHUTDOWN_FILE "shutdown"
+
+extern int requeue_jobs(char *spoolDir);
+extern int claim_jobs(char *spoolDir, char names[][MAX_JOB_NAME], int maxJobs);
+extern int read_job(char *spoolDir, char *name, char **files, int maxFiles);
+extern FILE *open_job_result(char *spoolDir, char *name);
+extern void close_job_result(char *spoolDir, char *name, FILE *fp);
+extern bool is_shutdown_requested(char *spoolDir);
+
+#endif /* JOB_QUEUE_H */
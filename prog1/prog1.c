@@ -1,12 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <getopt.h>
 #include <mpi.h>
 #include <libgen.h>
+#include <limits.h>
 
 #include "textProcessing.h"
+#include "textChunks.h"
+#include "prog1Utils.h"
+#include "jobQueue.h"
+#include "sharedChunks.h"
+#include "compressedText.h"
 
 /** \brief maximum number of worker processes */
 #define MAX_WORKERS 9
@@ -17,6 +24,15 @@
 /** \brief maximum file size */
 #define MAX_FILE_SIZE  100000
 
+/** \brief maximum number of jobs sharing the workers in the service mode */
+#define MAX_JOBS 8
+
+/** \brief interval between two scans of the spool directory in the service mode, in milliseconds */
+#define SPOOL_POLL_MS 50
+
+/** \brief maximum number of chunks of a block handed to a node by the two-level dispatching */
+#define MAX_BLOCK_CHUNKS 64
+
 typedef struct TextStruct
 {
     char *path;
@@ -37,25 +53,111 @@ typedef struct WorkerResult
     TextResult results;
 } WorkerResult;
 
+/** \brief block of a BGZF file, which the worker reads and decompresses itself */
+typedef struct BlockTask
+{
+    int id;
+    char path[PATH_MAX];
+    TextBlock block;
+} BlockTask;
+
+/** \brief results of a block between its first and last word boundaries, with the text around them */
+typedef struct BlockResult
+{
+    int id;
+    TextResult results;
+    int headLength;     /* bytes up to the first boundary, the whole block if it has none */
+    int tailLength;     /* bytes after the last boundary */
+    bool boundary;      /* the block has a word boundary */
+    unsigned char fragments[2 * MAX_BGZF_BLOCK]; /* the head, then the tail; only these bytes are sent */
+} BlockResult;
+
+/** \brief file read by the streamed dispatching, in chunks or, for a BGZF file, in blocks */
+typedef struct StreamFile
+{
+    bool inBlocks;          /* the file is a BGZF file, sent in blocks */
+    bool cut;               /* the whole text of the file was sent */
+    FILE *fp;               /* text being cut in chunks, or NULL */
+    TextBlock *blocks;      /* blocks of a BGZF file */
+    int nBlocks;
+    int blockPointer;       /* next block to send */
+    int joinPointer;        /* next block whose head is joined to the text left by the previous ones */
+    BlockResult **pieces;   /* results of the blocks received and not yet joined */
+    unsigned char *carry;   /* text left by the blocks joined, since their last boundary */
+    int carryLength;
+    int carryCapacity;
+} StreamFile;
+
+/** \brief results of a node since its last report, which also asks for the next block unless final */
+typedef struct NodeReport
+{
+    bool final;
+    TextResult results[MAX_FILES];
+} NodeReport;
+
+typedef struct ServiceJob
+{
+    bool active;
+    char name[MAX_JOB_NAME];
+    int nFiles;
+    char *files[MAX_FILES];
+    TextResult results[MAX_FILES];
+    int filePointer;    /* next file to cut in chunks */
+    FILE *fp;           /* file being cut in chunks, or NULL */
+    int pending;        /* chunks sent and not yet processed */
+    bool failed;        /* a file could not be read any more */
+    double start;
+} ServiceJob;
+
 static const unsigned int WORK_TO_DO = 0;
 static const unsigned int NO_MORE_WORK = 1;
 static const unsigned int EXECUTE_ERROR = 2;
+static const unsigned int SHARE_CHUNKS = 3;
+static const unsigned int SPLIT_NODES = 4;
+static const unsigned int SET_ANALYZERS = 5;
+static const unsigned int BLOCK_TO_DO = 6;
 
 /** \brief print proper use of the program parameters and arguments */
 static void printUsage(char *cmdName);
 
+/** \brief serve the jobs of a spool directory with the workers, until the service is asked to stop */
+static void run_service(char *spoolDir, int maxChunkBytes, int *workers, int nWorkers);
+
+/** \brief cut the files in chunks and blocks while the workers process them, for compressed files */
+static void run_stream_dispatcher(TextStruct *fileSpace, int nFiles, int maxChunkBytes, int *workers,
+                                  int nWorkers);
+
+/** \brief split the processes by node, for the two-level dispatching */
+static void split_nodes(int rank, MPI_Comm *localComm, MPI_Comm *leaderComm);
+
+/** \brief hand the tasks in blocks to the sub-dispatcher of every node and reduce their results */
+static void run_global_dispatcher(WorkerTask *taskSpace, int nTasks, int blockChunks, TextStruct *fileSpace,
+                                  int nFiles, MPI_Comm leaderComm);
+
+/** \brief hand the chunks of the blocks of a node to its workers and report their results */
+static void run_node_dispatcher(MPI_Comm localComm, MPI_Comm leaderComm);
+
+/** \brief process the tasks of a dispatcher until there is no more work */
+static unsigned int run_worker(MPI_Comm comm);
+
 /**
  *  \brief Process execution.
  *
  *  Design and flow of the dispatcher:
  *
- *  1 - Process the arguments from the command line.
+ *  1 - Process the arguments from the command line, and send the workers the analyzers to run.
  *
  *  2 - Initialize the shared region with the necessary structures.
  *
- *  3 - Create tasks.
+ *  3 - Create tasks. With -z, the files are read once into a shared memory window of the node, and
+ *  the tasks are the positions of their chunks in it. Compressed files are decompressed as they are read;
+ *  unless -z or -d is given, they are cut in tasks only as the workers ask for them instead, and the blocks
+ *  of a BGZF file are sent to be decompressed by the workers.
  *
- *  4 - Send tasks to worker process and wait to receive results.
+ *  4 - Send tasks to worker process and wait to receive results. A worker of the node of the dispatcher
+ *  gets the position of its chunk in the window when -z is given, any other worker the bytes of the chunk.
+ *  With -d, the tasks are handed in blocks to a sub-dispatcher per node instead, which sends their chunks
+ *  to the workers of its node and reports their results once per block.
  *
  *  5 - Sign workers the execution finished.
  *
@@ -63,11 +165,13 @@ static void printUsage(char *cmdName);
  *
  *  Design and flow of the worker:
  *
- *  1 - Wait for work status from dispatcher.
+ *  1 - Wait for work status from dispatcher; if the chunks are shared, map the window of the node; if the
+ *  dispatching has two levels, either become the sub-dispatcher of the node or work for it.
  *
  *  2 - If there is work to do, wait to receive task.
  *
- *  3 - Process task.
+ *  3 - Process task, in place in the window when the worker shares the node of the dispatcher. A block of
+ *  a BGZF file is read and decompressed first, and only the text between its word boundaries is processed.
  *
  *  4 - Send results.
  *
@@ -92,24 +196,27 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    if (nProcesses - 1 > MAX_WORKERS) /* This program cannot have more than <MAX_WORKERS> workers processes */
-    {
-        fprintf(stderr, "The program cannot have more than %d workers \n", MAX_WORKERS);
-        MPI_Finalize();
-        exit(EXIT_FAILURE);
-    }
-
     if (rank == 0) /* Dispatcher */
     {
         /* Set program variables */
         int nFiles = 0;                      /* number of text files (maximum=MAX_FILES) */
         char *files[MAX_FILES];              /* text file array (maximum=MAX_FILES)*/
+        long fileSizes[MAX_FILES];           /* number of bytes of the text of every file, decompressed */
         int maxChunkBytes = MAX_CHUNK_BYTES; /* maximum number of bytes per chunk */
-        int maxNumTasks = 0; /* maximum number of tasks */
+        int taskCapacity = 0; /* number of tasks the array has room for */
         int nTasks;                          /* number of tasks */
         unsigned int workStatus;             /* work status flag variable */
         int filePointer = 0; /* file pointer to the fileSpace data structure */
         int tasksPointer; /* pointer variable to the next worker to send a task */
+        char *spoolDir = NULL; /* spool directory of the service mode */
+        bool zeroCopy = false; /* share the chunks through a shared memory window */
+        MPI_Aint totalBytes = 0; /* number of bytes of the files */
+        SharedChunks shared;   /* window of the files, with -z */
+        ChunkRef *chunkSpace = NULL; /* chunks in the window, with -z */
+        bool localWorker[nProcesses]; /* the worker shares the window, with -z */
+        int blockChunks = 0;   /* chunks per block of the two-level dispatching, 0 if disabled */
+        bool streamed = false; /* compressed files are decompressed while the workers process them */
+        unsigned int analyzerFlags = 0; /* analyzers run with the vowel counts */
 
         WorkerTask *taskSpace;                        /* array of tasks */
         TextStruct *fileSpace;                        /* file data array structure */
@@ -120,9 +227,11 @@ int main(int argc, char *argv[]) {
 
         /* MPI variables */
         MPI_Request reqSend[nWorkers], reqRec[nWorkers];
-        bool allMsgRec, recVal;
+        bool allMsgRec;
+        int recVal;
         bool msgRec[nWorkers];
         WorkerTask *sendStruct;
+        ChunkRef *sendRef;
         WorkerResult *recStruct;
 
         /* Reference handlers */
@@ -133,7 +242,7 @@ int main(int argc, char *argv[]) {
         /* process command line options */
         int opt; /* selected option */
         do {
-            switch ((opt = getopt(argc, argv, "f:w:b:h"))) {
+            switch ((opt = getopt(argc, argv, "f:w:b:s:zd:a:h"))) {
                 case 'f':                 /* file */
                     if (optarg[0] == '-') /* filename is missing */
                     {
@@ -141,7 +250,7 @@ int main(int argc, char *argv[]) {
                         printUsage(basename(argv[0]));
                         workStatus = EXECUTE_ERROR;
                         for (int i = 0; i < nWorkers; i++) {
-                            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                      workers[i], 0, MPI_COMM_WORLD);
                         }
                         MPI_Finalize();
@@ -152,7 +261,7 @@ int main(int argc, char *argv[]) {
                         fprintf(stderr, "%s: maximum number of files is %d\n", basename(argv[0]), MAX_FILES);
                         workStatus = EXECUTE_ERROR;
                         for (int i = 0; i < nWorkers; i++) {
-                            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                      workers[i], 0, MPI_COMM_WORLD);
                         }
                         MPI_Finalize();
@@ -162,18 +271,40 @@ int main(int argc, char *argv[]) {
                         fprintf(stderr, "%s: file %s cannot be open.\n", basename(argv[0]), optarg);
                         workStatus = EXECUTE_ERROR;
                         for (int i = 0; i < nWorkers; i++) {
-                            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                                     workers[i], 0, MPI_COMM_WORLD);
+                        }
+                        MPI_Finalize();
+                        exit(EXIT_FAILURE);
+                    }
+                    if (get_text_format(optarg) == TEXT_ZSTD) { /* zstd frames are not supported */
+                        fprintf(stderr, "%s: file %s is compressed with zstd, which this build does not support.\n",
+                                basename(argv[0]), optarg);
+                        workStatus = EXECUTE_ERROR;
+                        for (int i = 0; i < nWorkers; i++) {
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                                     workers[i], 0, MPI_COMM_WORLD);
+                        }
+                        MPI_Finalize();
+                        exit(EXIT_FAILURE);
+                    }
+                    fileSizes[nFiles] = get_text_size(optarg); /* decompresses the file, once */
+                    if (fileSizes[nFiles] < 0) { /* Corrupted compressed file */
+                        fprintf(stderr, "%s: file %s cannot be decompressed.\n", basename(argv[0]), optarg);
+                        workStatus = EXECUTE_ERROR;
+                        for (int i = 0; i < nWorkers; i++) {
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                      workers[i], 0, MPI_COMM_WORLD);
                         }
                         MPI_Finalize();
                         exit(EXIT_FAILURE);
                     }
-                    if (get_file_size(optarg) > MAX_FILE_SIZE) { /* Exceeding maximum file size */
+                    if (fileSizes[nFiles] > MAX_FILE_SIZE) { /* Exceeding maximum file size, decompressed */
                         fprintf(stderr, "%s: file %s is too big maximum file size is %d.\n",
                                 basename(argv[0]), optarg, MAX_FILE_SIZE);
                         workStatus = EXECUTE_ERROR;
                         for (int i = 0; i < nWorkers; i++) {
-                            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                      workers[i], 0, MPI_COMM_WORLD);
                         }
                         MPI_Finalize();
@@ -187,7 +318,7 @@ int main(int argc, char *argv[]) {
                         printUsage(basename(argv[0]));
                         workStatus = EXECUTE_ERROR;
                         for (int i = 0; i < nWorkers; i++) {
-                            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                      workers[i], 0, MPI_COMM_WORLD);
                         }
                         MPI_Finalize();
@@ -199,7 +330,7 @@ int main(int argc, char *argv[]) {
                         printUsage(basename(argv[0]));
                         workStatus = EXECUTE_ERROR;
                         for (int i = 0; i < nWorkers; i++) {
-                            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                      workers[i], 0, MPI_COMM_WORLD);
                         }
                         MPI_Finalize();
@@ -207,11 +338,45 @@ int main(int argc, char *argv[]) {
                     }
                     maxChunkBytes = (int) atoi(optarg);
                     break;
+                case 's': /* spool directory of the service mode */
+                    spoolDir = optarg;
+                    break;
+                case 'z': /* zero-copy chunks */
+                    zeroCopy = true;
+                    break;
+                case 'd': /* two-level dispatching */
+                    if (atoi(optarg) <= 0 || atoi(optarg) > MAX_BLOCK_CHUNKS) {
+                        fprintf(stderr, "%s: the number of chunks per block should be between 1 and %d\n",
+                                basename(argv[0]), MAX_BLOCK_CHUNKS);
+                        printUsage(basename(argv[0]));
+                        workStatus = EXECUTE_ERROR;
+                        for (int i = 0; i < nWorkers; i++) {
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                                     workers[i], 0, MPI_COMM_WORLD);
+                        }
+                        MPI_Finalize();
+                        exit(EXIT_FAILURE);
+                    }
+                    blockChunks = atoi(optarg);
+                    break;
+                case 'a': /* analyzers */
+                    if (!parse_analyzers(optarg, &analyzerFlags)) {
+                        fprintf(stderr, "%s: unknown analyzer\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                        workStatus = EXECUTE_ERROR;
+                        for (int i = 0; i < nWorkers; i++) {
+                            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                                     workers[i], 0, MPI_COMM_WORLD);
+                        }
+                        MPI_Finalize();
+                        exit(EXIT_FAILURE);
+                    }
+                    break;
                 case 'h': /* help mode */
                     printUsage(basename(argv[0]));
                     workStatus = NO_MORE_WORK;
                     for (int i = 0; i < nWorkers; i++) {
-                        MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                        MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                  workers[i], 0, MPI_COMM_WORLD);
                     }
                     MPI_Finalize();
@@ -221,7 +386,7 @@ int main(int argc, char *argv[]) {
                     printUsage(basename(argv[0]));
                     workStatus = EXECUTE_ERROR;
                     for (int i = 0; i < nWorkers; i++) {
-                        MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                        MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                                  workers[i], 0, MPI_COMM_WORLD);
                     }
                     MPI_Finalize();
@@ -230,24 +395,76 @@ int main(int argc, char *argv[]) {
                     break;
             }
         } while (opt != -1);
-        if (optind < argc) {
-            fprintf(stderr, "%s: invalid format\n", basename(argv[0]));
+        if (optind < argc || (blockChunks > 0 && (zeroCopy || spoolDir != NULL))) {
+            if (optind < argc) {
+                fprintf(stderr, "%s: invalid format\n", basename(argv[0]));
+            } else {
+                fprintf(stderr, "%s: the two-level dispatching cannot be combined with -z or -s\n",
+                        basename(argv[0]));
+            }
             printUsage(basename(argv[0]));
             workStatus = EXECUTE_ERROR;
             for (int i = 0; i < nWorkers; i++) {
-                MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                         workers[i], 0, MPI_COMM_WORLD);
+            }
+            MPI_Finalize();
+            exit(EXIT_FAILURE);
+        }
+        /* This program cannot have more than <MAX_WORKERS> workers processes per dispatcher */
+        if (blockChunks == 0 && nWorkers > MAX_WORKERS) {
+            fprintf(stderr, "The program cannot have more than %d workers, unless the dispatching has two levels "
+                            "(-d)\n", MAX_WORKERS);
+            workStatus = EXECUTE_ERROR;
+            for (int i = 0; i < nWorkers; i++) {
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                          workers[i], 0, MPI_COMM_WORLD);
             }
             MPI_Finalize();
             exit(EXIT_FAILURE);
         }
+        if (analyzerFlags != 0) { /* every process runs the same analyzers */
+            use_analyzers(analyzerFlags);
+            workStatus = SET_ANALYZERS;
+            for (int i = 0; i < nWorkers; i++) {
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                         workers[i], 0, MPI_COMM_WORLD);
+                MPI_Send(&analyzerFlags, 1, MPI_UNSIGNED,
+                         workers[i], 0, MPI_COMM_WORLD);
+            }
+        }
+
+        if (spoolDir != NULL) { /* service mode: the jobs come from the spool directory */
+            if (nFiles > 0 || zeroCopy || requeue_jobs(spoolDir) < 0) {
+                if (nFiles > 0) {
+                    fprintf(stderr, "%s: the files of the service mode are given by its jobs\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                } else if (zeroCopy) {
+                    fprintf(stderr, "%s: the service mode sends the chunks by message, -z is not supported\n",
+                            basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                } else {
+                    fprintf(stderr, "%s: spool directory %s cannot be open.\n", basename(argv[0]), spoolDir);
+                }
+                workStatus = EXECUTE_ERROR;
+                for (int i = 0; i < nWorkers; i++) {
+                    MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                             workers[i], 0, MPI_COMM_WORLD);
+                }
+                MPI_Finalize();
+                exit(EXIT_FAILURE);
+            }
+            run_service(spoolDir, maxChunkBytes, workers, nWorkers);
+            MPI_Finalize();
+            exit(EXIT_SUCCESS);
+        }
 
         /* initialise fileSpace */
         if ((fileSpace = (TextStruct *) malloc(nFiles * sizeof(TextStruct))) == NULL) {
             fprintf(stderr, "error on allocating space to the file data array\n");
             workStatus = EXECUTE_ERROR;
             for (int i = 0; i < nWorkers; i++) {
-                MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                          workers[i], 0, MPI_COMM_WORLD);
             }
             MPI_Finalize();
@@ -259,62 +476,106 @@ int main(int argc, char *argv[]) {
             file->id = i;
             file->results = get_initial_result();
 
-            maxNumTasks += ((int) (get_file_size(file->path)) / maxChunkBytes) + 1;
+            totalBytes += fileSizes[i];
+            streamed = streamed || (!zeroCopy && blockChunks == 0 && get_text_format(file->path) != TEXT_PLAIN);
         }
 
         /* Generate tasks */
-        if ((tmpTaskSpace = (WorkerTask *) malloc(maxNumTasks * sizeof(WorkerTask))) == NULL) {
-            fprintf(stderr, "error on allocating space to the tasks data array\n");
-            workStatus = EXECUTE_ERROR;
+        if (zeroCopy) { /* load the files into the window of the node, once */
+            workStatus = SHARE_CHUNKS;
             for (int i = 0; i < nWorkers; i++) {
-                MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                          workers[i], 0, MPI_COMM_WORLD);
             }
-            MPI_Finalize();
-            exit(EXIT_FAILURE);
-        }
-        nTasks = 0;
-        while (filePointer < nFiles) {
-            file = (fileSpace + filePointer);
-            FILE *fp = fopen(file->path, "rb");
-            while (!feof(fp)) {
-                task.id = file->id;
-                task.chunk = get_chunk(fp, maxChunkBytes);
-                tmpTaskSpace[nTasks++] = task;
-            }
-            filePointer++;
-        }
-        if ((taskSpace = (WorkerTask *) malloc(nTasks * sizeof(WorkerTask))) == NULL) {
-            fprintf(stderr, "error on allocating space to the tasks data array\n");
-            workStatus = EXECUTE_ERROR;
+            open_shared_chunks(&shared, totalBytes, rank);
+            nTasks = load_shared_chunks(&shared, files, fileSizes, nFiles, maxChunkBytes, &chunkSpace);
+            sync_shared_chunks(&shared);
             for (int i = 0; i < nWorkers; i++) {
-                MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
-                         workers[i], 0, MPI_COMM_WORLD);
+                localWorker[i] = is_on_dispatcher_node(&shared, workers[i]);
             }
-            MPI_Finalize();
-            exit(EXIT_FAILURE);
-        }
-        for (int i = 0; i < nTasks; i++) {
-            taskSpace[i] = tmpTaskSpace[i];
+            taskSpace = NULL;
+        } else if (streamed) { /* the chunks and the blocks are cut while the workers process them */
+            nTasks = 0;
+            taskSpace = NULL;
+        } else {
+            /* the chunks are cut back to the start of a word, so their number is only known at the end */
+            tmpTaskSpace = NULL;
+            nTasks = 0;
+            while (filePointer < nFiles) {
+                file = (fileSpace + filePointer);
+                FILE *fp = open_text(file->path);
+                while (!feof(fp)) {
+                    task.id = file->id;
+                    task.chunk = get_chunk(fp, maxChunkBytes);
+                    if (nTasks == taskCapacity) {
+                        taskCapacity = (taskCapacity > 0) ? 2 * taskCapacity : 64;
+                        if ((tmpTaskSpace = (WorkerTask *) realloc(tmpTaskSpace,
+                                                                   taskCapacity * sizeof(WorkerTask))) == NULL) {
+                            fprintf(stderr, "error on allocating space to the tasks data array\n");
+                            workStatus = EXECUTE_ERROR;
+                            for (int i = 0; i < nWorkers; i++) {
+                                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                                         workers[i], 0, MPI_COMM_WORLD);
+                            }
+                            MPI_Finalize();
+                            exit(EXIT_FAILURE);
+                        }
+                    }
+                    tmpTaskSpace[nTasks++] = task;
+                }
+                fclose(fp);
+                filePointer++;
+            }
+            if ((taskSpace = (WorkerTask *) malloc(nTasks * sizeof(WorkerTask))) == NULL) {
+                fprintf(stderr, "error on allocating space to the tasks data array\n");
+                workStatus = EXECUTE_ERROR;
+                for (int i = 0; i < nWorkers; i++) {
+                    MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                             workers[i], 0, MPI_COMM_WORLD);
+                }
+                MPI_Finalize();
+                exit(EXIT_FAILURE);
+            }
+            for (int i = 0; i < nTasks; i++) {
+                taskSpace[i] = tmpTaskSpace[i];
+            }
+            free(tmpTaskSpace);
         }
-        free(tmpTaskSpace);
 
         /* distribute tasks */
         tasksPointer = 0;
         (void) get_delta_time();
 
         if (((sendStruct = malloc(nWorkers * sizeof(WorkerTask))) == NULL) ||
+            ((sendRef = malloc(nWorkers * sizeof(ChunkRef))) == NULL) ||
             ((recStruct = malloc(nWorkers * sizeof(WorkerResult))) == NULL)) {
             fprintf(stderr, "error on message box memory allocation \n");
             workStatus = EXECUTE_ERROR;
             for (int i = 0; i < nWorkers; i++) {
-                MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                          workers[i], 0, MPI_COMM_WORLD);
             }
             MPI_Finalize();
             exit(EXIT_FAILURE);
         }
 
+        if (blockChunks > 0) { /* two-level dispatching: the nodes dispatch every task */
+            MPI_Comm localComm, leaderComm;
+
+            workStatus = SPLIT_NODES;
+            for (int i = 0; i < nWorkers; i++) {
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                         workers[i], 0, MPI_COMM_WORLD);
+            }
+            split_nodes(rank, &localComm, &leaderComm);
+            run_global_dispatcher(taskSpace, nTasks, blockChunks, fileSpace, nFiles, leaderComm);
+            MPI_Comm_free(&leaderComm);
+            tasksPointer = nTasks;
+        }
+        if (streamed) {
+            run_stream_dispatcher(fileSpace, nFiles, maxChunkBytes, workers, nWorkers);
+        }
+
         while (tasksPointer < nTasks) /* process tasks cycle. */
         {
             if (tasksPointer + nWorkers > nTasks) {
@@ -324,9 +585,23 @@ int main(int argc, char *argv[]) {
             }
             workStatus = WORK_TO_DO;
             for (int i = 0; i < nWorkersNow; i++) {
-                MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                          workers[i], 0, MPI_COMM_WORLD);
-                sendStruct[i] = taskSpace[tasksPointer++];
+                if (zeroCopy && localWorker[i]) { /* the worker reads the chunk from the window */
+                    sendRef[i] = chunkSpace[tasksPointer++];
+                    MPI_Isend(&sendRef[i], sizeof(ChunkRef), MPI_BYTE,
+                              workers[i], 0, MPI_COMM_WORLD, &reqSend[i]);
+                    continue;
+                }
+                if (zeroCopy) { /* worker of another node: copy the chunk out of the window */
+                    sendStruct[i].id = chunkSpace[tasksPointer].id;
+                    sendStruct[i].chunk.length = chunkSpace[tasksPointer].length;
+                    memcpy(sendStruct[i].chunk.bytes, shared.bytes + chunkSpace[tasksPointer].offset,
+                           chunkSpace[tasksPointer].length);
+                    tasksPointer++;
+                } else {
+                    sendStruct[i] = taskSpace[tasksPointer++];
+                }
                 MPI_Isend(&sendStruct[i], sizeof(WorkerTask), MPI_BYTE,
                           workers[i], 0, MPI_COMM_WORLD, &reqSend[i]);
             }
@@ -340,7 +615,7 @@ int main(int argc, char *argv[]) {
                 for (int i = 0; i < nWorkersNow; i++) {
                     if (!msgRec[i]) {
                         recVal = false;
-                        MPI_Test(&reqRec[i], (int *) &recVal, MPI_STATUS_IGNORE);
+                        MPI_Test(&reqRec[i], &recVal, MPI_STATUS_IGNORE);
                         if (recVal) {
                             msgRec[i] = true;
                             result = recStruct[i];
@@ -356,9 +631,13 @@ int main(int argc, char *argv[]) {
 
         workStatus = NO_MORE_WORK; /* Sign workers execution finished */
         for (int i = 0; i < nWorkers; i++) {
-            MPI_Send(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
+            MPI_Send(&workStatus, 1, MPI_UNSIGNED,
                      workers[i], 0, MPI_COMM_WORLD);
         }
+        if (zeroCopy) {
+            close_shared_chunks(&shared);
+            free(chunkSpace);
+        }
 
         printf("\nElapsed time multi thread = %.6fs\n\n", get_delta_time());
         for (int i = 0; i < nFiles; i++) { /* print results */
@@ -367,22 +646,7 @@ int main(int argc, char *argv[]) {
             printf("\n");
         }
     } else { /* Worker */
-        unsigned int workStatus; /* work status flag variable */
-        /* reference handlers */
-        WorkerTask task;
-        WorkerResult result;
-        while (true) { /* work cycle */
-            MPI_Recv(&workStatus, sizeof(unsigned int), MPI_UNSIGNED,
-                     0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            if (workStatus != WORK_TO_DO) {
-                break;
-            }
-            MPI_Recv((char *) &task, sizeof(WorkerTask), MPI_BYTE, 0, 0, MPI_COMM_WORLD,
-                     MPI_STATUS_IGNORE);
-            result.id = task.id;
-            result.results = process_chunk(task.chunk);
-            MPI_Send((char *) &result, sizeof(WorkerResult), MPI_BYTE, 0, 0, MPI_COMM_WORLD);
-        }
+        unsigned int workStatus = run_worker(MPI_COMM_WORLD); /* work status flag variable */
         if (workStatus == NO_MORE_WORK) {
             MPI_Finalize();
             exit(EXIT_SUCCESS);
@@ -395,6 +659,712 @@ int main(int argc, char *argv[]) {
     exit(EXIT_SUCCESS);
 }
 
+/**
+ *  \brief Claims the jobs waiting in the spool directory, while there are free job slots.
+ *
+ *  A job whose files cannot all be processed is answered with an error at once.
+ *
+ *  \param spoolDir the spool directory
+ *  \param jobs the job slots
+ */
+static void admit_jobs(char *spoolDir, ServiceJob *jobs) {
+    char names[MAX_JOBS][MAX_JOB_NAME];
+    int nFree = 0, nClaimed, slot = 0;
+
+    for (int i = 0; i < MAX_JOBS; i++) {
+        if (!jobs[i].active) {
+            nFree++;
+        }
+    }
+    nClaimed = claim_jobs(spoolDir, names, nFree);
+    for (int i = 0; i < nClaimed; i++) {
+        ServiceJob *job;
+        char *error = NULL;
+
+        while (jobs[slot].active) {
+            slot++;
+        }
+        job = &jobs[slot];
+        strcpy(job->name, names[i]);
+        job->nFiles = read_job(spoolDir, job->name, job->files, MAX_FILES);
+        if (job->nFiles == -1) {
+            error = "the job cannot be read";
+        } else if (job->nFiles == -2) {
+            error = "too many files";
+        }
+        for (int j = 0; error == NULL && j < job->nFiles; j++) {
+            long size;
+            if (!is_file_open(job->files[j])) {
+                error = "a file cannot be open";
+            } else if (get_text_format(job->files[j]) == TEXT_ZSTD) {
+                error = "a file is compressed with zstd, which is not supported";
+            } else if ((size = get_text_size(job->files[j])) < 0) {
+                error = "a file cannot be decompressed";
+            } else if (size > MAX_FILE_SIZE) {
+                error = "a file is too big";
+            }
+        }
+        if (error != NULL) {
+            FILE *fp = open_job_result(spoolDir, job->name);
+            if (fp != NULL) {
+                fprintf(fp, "error: %s\n", error);
+            }
+            close_job_result(spoolDir, job->name, fp);
+            for (int j = 0; j < job->nFiles; j++) {
+                free(job->files[j]);
+            }
+            printf("job %s: %s\n", job->name, error);
+            continue;
+        }
+        for (int j = 0; j < job->nFiles; j++) {
+            job->results[j] = get_initial_result();
+        }
+        job->filePointer = 0;
+        job->fp = NULL;
+        job->pending = 0;
+        job->failed = false;
+        job->start = MPI_Wtime();
+        job->active = true;
+    }
+}
+
+/**
+ *  \brief Cuts the next chunk of a job.
+ *
+ *  \param job the job, which must have files left
+ *  \param maxChunkBytes maximum number of bytes per chunk
+ *  \param task the task where the chunk is written
+ *
+ *  \return true if a chunk was cut, false if the file could not be open
+ */
+static bool next_chunk(ServiceJob *job, int maxChunkBytes, WorkerTask *task) {
+    if (job->fp == NULL && (job->fp = open_text(job->files[job->filePointer])) == NULL) {
+        job->failed = true;
+        job->filePointer = job->nFiles;
+        return false;
+    }
+    task->id = job->filePointer;
+    task->chunk = get_chunk(job->fp, maxChunkBytes);
+    if (feof(job->fp)) {
+        fclose(job->fp);
+        job->fp = NULL;
+        job->filePointer++;
+    }
+    return true;
+}
+
+/**
+ *  \brief Writes the results of a job whose chunks were all processed, and frees its slot.
+ *
+ *  \param spoolDir the spool directory
+ *  \param job the job
+ */
+static void finish_job(char *spoolDir, ServiceJob *job) {
+    double elapsed = MPI_Wtime() - job->start;
+    FILE *fp = open_job_result(spoolDir, job->name);
+
+    if (fp != NULL) {
+        if (job->failed) {
+            fprintf(fp, "error: a file cannot be open\n");
+        } else {
+            fprintf(fp, "\nElapsed time multi thread = %.6fs\n\n", elapsed);
+            for (int i = 0; i < job->nFiles; i++) {
+                fprintf(fp, "id: %d\n", i);
+                fprint_results(fp, job->files[i], job->results[i]);
+                fprintf(fp, "\n");
+            }
+        }
+    } else {
+        fprintf(stderr, "Error while writing the results of job %s\n", job->name);
+    }
+    close_job_result(spoolDir, job->name, fp);
+    printf("job %s: %d files in %.6fs\n", job->name, job->nFiles, elapsed);
+    fflush(stdout);
+    for (int i = 0; i < job->nFiles; i++) {
+        free(job->files[i]);
+    }
+    job->active = false;
+}
+
+/**
+ *  \brief Serve the jobs of a spool directory with the workers, until the service is asked to stop.
+ *
+ *  The workers are started once and kept busy with chunks of every claimed job: each idle worker gets a
+ *  chunk of the next job in turn, so a large job does not hold back the small ones submitted after it.
+ *  Every worker has one chunk at most in flight, and the next one is sent as soon as its result arrives.
+ *
+ *  Once the shutdown file appears, no more jobs are claimed; the claimed ones are finished and the workers
+ *  are signed the execution finished. The jobs still waiting are left for the next service.
+ *
+ *  \param spoolDir the spool directory
+ *  \param maxChunkBytes maximum number of bytes per chunk
+ *  \param workers ranks of the workers
+ *  \param nWorkers number of workers
+ */
+static void run_service(char *spoolDir, int maxChunkBytes, int *workers, int nWorkers) {
+    ServiceJob jobs[MAX_JOBS];
+    int workerJob[nWorkers]; /* job of the chunk held by every worker, -1 if idle */
+    int nBusy = 0, turn = 0;
+    bool stopping = false;
+    double lastScan = -1.0;
+    unsigned int workStatus;
+    struct timespec pause = {0, SPOOL_POLL_MS * 1000000L};
+    MPI_Request reqSend[nWorkers], reqRec[nWorkers];
+    WorkerTask *sendStruct;
+    WorkerResult *recStruct;
+
+    if (((sendStruct = malloc(nWorkers * sizeof(WorkerTask))) == NULL) ||
+        ((recStruct = malloc(nWorkers * sizeof(WorkerResult))) == NULL)) {
+        fprintf(stderr, "error on message box memory allocation \n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for (int i = 0; i < MAX_JOBS; i++) {
+        jobs[i].active = false;
+    }
+    for (int i = 0; i < nWorkers; i++) {
+        workerJob[i] = -1;
+        reqRec[i] = MPI_REQUEST_NULL;
+    }
+    printf("Serving the jobs of %s\n", spoolDir);
+    fflush(stdout);
+
+    while (true) {
+        bool anyActive = false;
+
+        if (!stopping && MPI_Wtime() - lastScan >= SPOOL_POLL_MS / 1000.0) {
+            lastScan = MPI_Wtime();
+            if (is_shutdown_requested(spoolDir)) {
+                stopping = true;
+            } else {
+                admit_jobs(spoolDir, jobs);
+            }
+        }
+
+        /* hand a chunk to every idle worker, from the jobs in turn */
+        for (int i = 0; i < nWorkers; i++) {
+            int job = -1;
+            if (workerJob[i] >= 0) {
+                continue;
+            }
+            for (int j = 0; j < MAX_JOBS && job < 0; j++) {
+                int candidate = (turn + j) % MAX_JOBS;
+                if (jobs[candidate].active && jobs[candidate].filePointer < jobs[candidate].nFiles &&
+                    next_chunk(&jobs[candidate], maxChunkBytes, &sendStruct[i])) {
+                    job = candidate;
+                }
+            }
+            if (job < 0) {
+                break;
+            }
+            turn = (job + 1) % MAX_JOBS;
+            workStatus = WORK_TO_DO;
+            MPI_Send(&workStatus, 1, MPI_UNSIGNED, workers[i], 0, MPI_COMM_WORLD);
+            MPI_Isend(&sendStruct[i], sizeof(WorkerTask), MPI_BYTE, workers[i], 0, MPI_COMM_WORLD, &reqSend[i]);
+            MPI_Irecv(&recStruct[i], sizeof(WorkerResult), MPI_BYTE, workers[i], 0, MPI_COMM_WORLD, &reqRec[i]);
+            workerJob[i] = job;
+            jobs[job].pending++;
+            nBusy++;
+        }
+
+        for (int i = 0; i < MAX_JOBS; i++) { /* publish the jobs done */
+            if (jobs[i].active && jobs[i].filePointer == jobs[i].nFiles && jobs[i].pending == 0) {
+                finish_job(spoolDir, &jobs[i]);
+            }
+            anyActive = anyActive || jobs[i].active;
+        }
+
+        if (nBusy == 0) { /* nothing in flight: wait for new jobs */
+            if (stopping && !anyActive) {
+                break;
+            }
+            nanosleep(&pause, NULL);
+            continue;
+        }
+
+        int worker;
+        MPI_Waitany(nWorkers, reqRec, &worker, MPI_STATUS_IGNORE);
+        MPI_Wait(&reqSend[worker], MPI_STATUS_IGNORE);
+        ServiceJob *job = &jobs[workerJob[worker]];
+        job->results[recStruct[worker].id] = reduce(job->results[recStruct[worker].id],
+                                                    recStruct[worker].results);
+        job->pending--;
+        workerJob[worker] = -1;
+        nBusy--;
+    }
+
+    workStatus = NO_MORE_WORK; /* Sign workers execution finished */
+    for (int i = 0; i < nWorkers; i++) {
+        MPI_Send(&workStatus, 1, MPI_UNSIGNED,
+                 workers[i], 0, MPI_COMM_WORLD);
+    }
+    printf("Service stopped\n");
+    free(sendStruct);
+    free(recStruct);
+}
+
+/**
+ *  \brief Appends text to the text left by the blocks of a BGZF file joined so far.
+ *
+ *  \param stream the file
+ *  \param bytes the text
+ *  \param length number of bytes of the text
+ */
+static void append_carry(StreamFile *stream, const unsigned char *bytes, int length) {
+    if (stream->carryLength + length > stream->carryCapacity) {
+        stream->carryCapacity = 2 * (stream->carryLength + length);
+        if ((stream->carry = realloc(stream->carry, stream->carryCapacity)) == NULL) {
+            fprintf(stderr, "error on allocating space to the text between blocks\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    memcpy(stream->carry + stream->carryLength, bytes, length);
+    stream->carryLength += length;
+}
+
+/**
+ *  \brief Joins the blocks of a BGZF file received so far, in order, from the next one to join.
+ *
+ *  The text left by the blocks joined, since their last word boundary, is followed by the head of the next
+ *  block: if the head ends at a boundary, the text is whole and processed here, and the tail of the block is
+ *  left for the next one. The text left by the last block is processed once it is joined.
+ *
+ *  \param stream the file
+ *  \param file the results of the file
+ */
+static void join_blocks(StreamFile *stream, TextStruct *file) {
+    while (stream->joinPointer < stream->nBlocks && stream->pieces[stream->joinPointer] != NULL) {
+        BlockResult *piece = stream->pieces[stream->joinPointer];
+
+        append_carry(stream, piece->fragments, piece->headLength);
+        if (piece->boundary) {
+            file->results = reduce(file->results, process_bytes(stream->carry, stream->carryLength));
+            file->results = reduce(file->results, piece->results);
+            stream->carryLength = 0;
+            append_carry(stream, piece->fragments + piece->headLength, piece->tailLength);
+        }
+        free(piece);
+        stream->pieces[stream->joinPointer++] = NULL;
+    }
+    if (stream->joinPointer == stream->nBlocks && stream->carryLength > 0) {
+        file->results = reduce(file->results, process_bytes(stream->carry, stream->carryLength));
+        stream->carryLength = 0;
+    }
+}
+
+/**
+ *  \brief Cut the files in chunks and blocks while the workers process them, for compressed files.
+ *
+ *  The files are sent in order, one task to every idle worker. A BGZF file is sent block by block, from the
+ *  index of its blocks: the worker reads and decompresses its block itself, and sends back the results of
+ *  the text between the first and the last word boundary of the block, with the text around them, which is
+ *  joined here in the order of the blocks. Any other file, gzip or plain, is decompressed here and cut in
+ *  chunks only as the workers ask for more, so the decompression overlaps the processing of the chunks sent.
+ *
+ *  \param fileSpace the files, where the results are reduced
+ *  \param nFiles number of files
+ *  \param maxChunkBytes maximum number of bytes per chunk
+ *  \param workers ranks of the workers
+ *  \param nWorkers number of workers
+ */
+static void run_stream_dispatcher(TextStruct *fileSpace, int nFiles, int maxChunkBytes, int *workers,
+                                  int nWorkers) {
+    StreamFile streams[nFiles];
+    int workerBlock[nWorkers]; /* block of the task held by every worker, -1 for a chunk */
+    bool busy[nWorkers];
+    int filePointer = 0, nBusy = 0, worker;
+    unsigned int workStatus;
+    MPI_Request reqSend[nWorkers], reqRec[nWorkers];
+    WorkerTask *sendStruct;
+    BlockTask *sendBlock;
+    WorkerResult *recStruct;
+    BlockResult *recBlock;
+
+    if (((sendStruct = malloc(nWorkers * sizeof(WorkerTask))) == NULL) ||
+        ((sendBlock = malloc(nWorkers * sizeof(BlockTask))) == NULL) ||
+        ((recStruct = malloc(nWorkers * sizeof(WorkerResult))) == NULL) ||
+        ((recBlock = malloc(nWorkers * sizeof(BlockResult))) == NULL)) {
+        fprintf(stderr, "error on message box memory allocation \n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for (int i = 0; i < nFiles; i++) {
+        StreamFile *stream = &streams[i];
+
+        memset(stream, 0, sizeof(StreamFile));
+        stream->inBlocks = (get_text_format(fileSpace[i].path) == TEXT_BGZF);
+        if (stream->inBlocks) {
+            if ((stream->nBlocks = index_text_blocks(fileSpace[i].path, &stream->blocks)) < 0 ||
+                (stream->pieces = calloc(stream->nBlocks + 1, sizeof(BlockResult *))) == NULL) {
+                fprintf(stderr, "error while indexing the blocks of %s\n", fileSpace[i].path);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            stream->cut = (stream->nBlocks == 0);
+        }
+    }
+    for (int i = 0; i < nWorkers; i++) {
+        busy[i] = false;
+        reqRec[i] = MPI_REQUEST_NULL;
+    }
+
+    while (true) {
+        /* hand the next chunk or block to every idle worker */
+        for (int i = 0; i < nWorkers; i++) {
+            StreamFile *stream;
+
+            while (filePointer < nFiles && streams[filePointer].cut) {
+                filePointer++;
+            }
+            if (filePointer == nFiles) {
+                break;
+            }
+            if (busy[i]) {
+                continue;
+            }
+            stream = &streams[filePointer];
+            if (stream->inBlocks) {
+                sendBlock[i].id = filePointer;
+                strncpy(sendBlock[i].path, fileSpace[filePointer].path, PATH_MAX - 1);
+                sendBlock[i].path[PATH_MAX - 1] = '\0';
+                sendBlock[i].block = stream->blocks[stream->blockPointer];
+                workerBlock[i] = stream->blockPointer++;
+                stream->cut = (stream->blockPointer == stream->nBlocks);
+                workStatus = BLOCK_TO_DO;
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED, workers[i], 0, MPI_COMM_WORLD);
+                MPI_Isend(&sendBlock[i], sizeof(BlockTask), MPI_BYTE, workers[i], 0, MPI_COMM_WORLD,
+                          &reqSend[i]);
+                MPI_Irecv(&recBlock[i], sizeof(BlockResult), MPI_BYTE, workers[i], 0, MPI_COMM_WORLD,
+                          &reqRec[i]);
+            } else {
+                if (stream->fp == NULL && (stream->fp = open_text(fileSpace[filePointer].path)) == NULL) {
+                    fprintf(stderr, "file %s cannot be open.\n", fileSpace[filePointer].path);
+                    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                }
+                sendStruct[i].id = filePointer;
+                sendStruct[i].chunk = get_chunk(stream->fp, maxChunkBytes);
+                if (feof(stream->fp)) {
+                    fclose(stream->fp);
+                    stream->fp = NULL;
+                    stream->cut = true;
+                }
+                workerBlock[i] = -1;
+                workStatus = WORK_TO_DO;
+                MPI_Send(&workStatus, 1, MPI_UNSIGNED, workers[i], 0, MPI_COMM_WORLD);
+                MPI_Isend(&sendStruct[i], sizeof(WorkerTask), MPI_BYTE, workers[i], 0, MPI_COMM_WORLD,
+                          &reqSend[i]);
+                MPI_Irecv(&recStruct[i], sizeof(WorkerResult), MPI_BYTE, workers[i], 0, MPI_COMM_WORLD,
+                          &reqRec[i]);
+            }
+            busy[i] = true;
+            nBusy++;
+        }
+        if (nBusy == 0) {
+            break;
+        }
+
+        MPI_Waitany(nWorkers, reqRec, &worker, MPI_STATUS_IGNORE);
+        MPI_Wait(&reqSend[worker], MPI_STATUS_IGNORE);
+        if (workerBlock[worker] < 0) {
+            TextStruct *file = &fileSpace[recStruct[worker].id];
+            file->results = reduce(file->results, recStruct[worker].results);
+        } else { /* keep the block until the blocks before it are joined */
+            BlockResult *piece = &recBlock[worker];
+            size_t length = offsetof(BlockResult, fragments) + piece->headLength + piece->tailLength;
+            StreamFile *stream = &streams[piece->id];
+
+            if ((stream->pieces[workerBlock[worker]] = malloc(length)) == NULL) {
+                fprintf(stderr, "error on allocating space to the results of a block\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            memcpy(stream->pieces[workerBlock[worker]], piece, length);
+            join_blocks(stream, &fileSpace[piece->id]);
+        }
+        busy[worker] = false;
+        nBusy--;
+    }
+
+    for (int i = 0; i < nFiles; i++) {
+        free(streams[i].blocks);
+        free(streams[i].pieces);
+        free(streams[i].carry);
+    }
+    free(sendStruct);
+    free(sendBlock);
+    free(recStruct);
+    free(recBlock);
+}
+
+/**
+ *  \brief Split the processes by node, for the two-level dispatching. Collective over MPI_COMM_WORLD.
+ *
+ *  The processes of a node, but the global dispatcher, share a local communicator whose first process is
+ *  the sub-dispatcher of the node. The global dispatcher and the sub-dispatchers share the communicator of
+ *  the leaders, where the global dispatcher is the first process.
+ *
+ *  \param rank rank of the process in MPI_COMM_WORLD
+ *  \param localComm where the communicator of the node is written, MPI_COMM_NULL for the global dispatcher
+ *  \param leaderComm where the communicator of the leaders is written, MPI_COMM_NULL for a worker
+ */
+static void split_nodes(int rank, MPI_Comm *localComm, MPI_Comm *leaderComm) {
+    MPI_Comm nodeComm;
+    int localRank = 0;
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+    MPI_Comm_split(nodeComm, (rank == 0) ? MPI_UNDEFINED : 0, rank, localComm);
+    MPI_Comm_free(&nodeComm);
+    if (*localComm != MPI_COMM_NULL) {
+        MPI_Comm_rank(*localComm, &localRank);
+    }
+    MPI_Comm_split(MPI_COMM_WORLD, (localRank == 0) ? 0 : MPI_UNDEFINED, rank, leaderComm);
+}
+
+/**
+ *  \brief Hand the tasks in blocks to the sub-dispatcher of every node and reduce their results.
+ *
+ *  Every report of a node carries the results of its chunks processed since the previous one, and asks for
+ *  the next block, which is sent straight from the task array. The blocks shrink to a share of the tasks
+ *  left per node, so the nodes finish together; once there are no tasks left, a node gets an empty block
+ *  and sends its final report after its workers are done.
+ *
+ *  \param taskSpace the tasks
+ *  \param nTasks number of tasks
+ *  \param blockChunks maximum number of chunks per block
+ *  \param fileSpace the files, where the results are reduced
+ *  \param nFiles number of files
+ *  \param leaderComm communicator of the leaders
+ */
+static void run_global_dispatcher(WorkerTask *taskSpace, int nTasks, int blockChunks, TextStruct *fileSpace,
+                                  int nFiles, MPI_Comm leaderComm) {
+    int nNodes, active, node, length, tasksPointer = 0;
+
+    MPI_Comm_size(leaderComm, &nNodes);
+    nNodes--;
+    NodeReport reports[nNodes];
+    MPI_Request reqRec[nNodes];
+
+    for (int i = 0; i < nNodes; i++) {
+        MPI_Irecv(&reports[i], sizeof(NodeReport), MPI_BYTE, i + 1, 0, leaderComm, &reqRec[i]);
+    }
+    active = nNodes;
+    while (active > 0) {
+        MPI_Waitany(nNodes, reqRec, &node, MPI_STATUS_IGNORE);
+        for (int i = 0; i < nFiles; i++) {
+            fileSpace[i].results = reduce(fileSpace[i].results, reports[node].results[i]);
+        }
+        if (reports[node].final) {
+            active--;
+            continue;
+        }
+        length = (nTasks - tasksPointer + 2 * nNodes - 1) / (2 * nNodes);
+        if (length > blockChunks) {
+            length = blockChunks;
+        }
+        MPI_Send(taskSpace + tasksPointer, length * (int) sizeof(WorkerTask), MPI_BYTE, node + 1, 0, leaderComm);
+        tasksPointer += length;
+        MPI_Irecv(&reports[node], sizeof(NodeReport), MPI_BYTE, node + 1, 0, leaderComm, &reqRec[node]);
+    }
+}
+
+/**
+ *  \brief Hand the chunks of the blocks of a node to its workers and report their results.
+ *
+ *  Every idle worker gets the next chunk of the block. As soon as the last chunk of a block is handed out,
+ *  the results gathered since the previous report are sent with the request of the next block, which
+ *  arrives while the workers process the last chunks. A node without workers processes its chunks itself.
+ *
+ *  \param localComm communicator of the node, where the sub-dispatcher is the first process
+ *  \param leaderComm communicator of the leaders
+ */
+static void run_node_dispatcher(MPI_Comm localComm, MPI_Comm leaderComm) {
+    int nWorkers, length = 0, pointer = 0, nBusy = 0, index;
+    bool requested = false, noMoreWork = false;
+    unsigned int workStatus;
+    NodeReport report;
+    WorkerTask *block;
+    MPI_Status status;
+
+    MPI_Comm_size(localComm, &nWorkers);
+    nWorkers--;
+    if (nWorkers > MAX_WORKERS) {
+        fprintf(stderr, "A node cannot have more than %d workers \n", MAX_WORKERS);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    bool busy[nWorkers + 1];
+    MPI_Request reqSend[nWorkers + 1], reqRec[nWorkers + 1]; /* reqRec[nWorkers]: the next block */
+    WorkerTask *sendStruct;
+    WorkerResult *recStruct;
+
+    if (((block = malloc(MAX_BLOCK_CHUNKS * sizeof(WorkerTask))) == NULL) ||
+        ((sendStruct = malloc((nWorkers + 1) * sizeof(WorkerTask))) == NULL) ||
+        ((recStruct = malloc((nWorkers + 1) * sizeof(WorkerResult))) == NULL)) {
+        fprintf(stderr, "error on message box memory allocation \n");
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+    for (int i = 0; i < MAX_FILES; i++) {
+        report.results[i] = get_initial_result();
+    }
+    for (int i = 0; i <= nWorkers; i++) {
+        busy[i] = false;
+        reqRec[i] = MPI_REQUEST_NULL;
+    }
+
+    while (true) {
+        /* hand the chunks of the block to the idle workers */
+        for (int i = 0; i < nWorkers && pointer < length; i++) {
+            if (busy[i]) {
+                continue;
+            }
+            workStatus = WORK_TO_DO;
+            MPI_Send(&workStatus, 1, MPI_UNSIGNED, i + 1, 0, localComm);
+            sendStruct[i] = block[pointer++];
+            MPI_Isend(&sendStruct[i], sizeof(WorkerTask), MPI_BYTE, i + 1, 0, localComm, &reqSend[i]);
+            MPI_Irecv(&recStruct[i], sizeof(WorkerResult), MPI_BYTE, i + 1, 0, localComm, &reqRec[i]);
+            busy[i] = true;
+            nBusy++;
+        }
+        for (; nWorkers == 0 && pointer < length; pointer++) { /* no workers: process the block here */
+            report.results[block[pointer].id] = reduce(report.results[block[pointer].id],
+                                                       process_chunk(block[pointer].chunk));
+        }
+
+        /* report and ask for the next block, once this one is handed out */
+        if (pointer == length && !requested && !noMoreWork) {
+            report.final = false;
+            MPI_Send(&report, sizeof(NodeReport), MPI_BYTE, 0, 0, leaderComm);
+            for (int i = 0; i < MAX_FILES; i++) {
+                report.results[i] = get_initial_result();
+            }
+            MPI_Irecv(block, MAX_BLOCK_CHUNKS * sizeof(WorkerTask), MPI_BYTE, 0, 0, leaderComm,
+                      &reqRec[nWorkers]);
+            requested = true;
+        }
+        if (nBusy == 0 && !requested) {
+            break;
+        }
+
+        MPI_Waitany(nWorkers + 1, reqRec, &index, &status);
+        if (index == nWorkers) { /* the next block */
+            MPI_Get_count(&status, MPI_BYTE, &length);
+            length /= (int) sizeof(WorkerTask);
+            pointer = 0;
+            requested = false;
+            noMoreWork = (length == 0);
+        } else {
+            MPI_Wait(&reqSend[index], MPI_STATUS_IGNORE);
+            report.results[recStruct[index].id] = reduce(report.results[recStruct[index].id],
+                                                         recStruct[index].results);
+            busy[index] = false;
+            nBusy--;
+        }
+    }
+
+    report.final = true;
+    MPI_Send(&report, sizeof(NodeReport), MPI_BYTE, 0, 0, leaderComm);
+    workStatus = NO_MORE_WORK; /* Sign workers of the node execution finished */
+    for (int i = 0; i < nWorkers; i++) {
+        MPI_Send(&workStatus, 1, MPI_UNSIGNED, i + 1, 0, localComm);
+    }
+    free(block);
+    free(sendStruct);
+    free(recStruct);
+}
+
+/**
+ *  \brief Process the tasks of a dispatcher until there is no more work.
+ *
+ *  \param comm communicator of the dispatcher, which is its first process
+ *
+ *  \return the work status that ended the work cycle
+ */
+static unsigned int run_worker(MPI_Comm comm) {
+    unsigned int workStatus; /* work status flag variable */
+    int rank;
+    /* reference handlers */
+    WorkerTask task;
+    ChunkRef ref;
+    WorkerResult result;
+    SharedChunks shared;
+    bool zeroCopy = false; /* the chunks are in a shared memory window */
+    unsigned int analyzerFlags;
+    BlockTask blockTask;
+    BlockResult *blockResult = NULL; /* allocated with the first block */
+    unsigned char *text = NULL;      /* text of the block, decompressed */
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    while (true) { /* work cycle */
+        MPI_Recv(&workStatus, 1, MPI_UNSIGNED,
+                 0, 0, comm, MPI_STATUS_IGNORE);
+        if (workStatus == SET_ANALYZERS) {
+            MPI_Recv(&analyzerFlags, 1, MPI_UNSIGNED, 0, 0, comm, MPI_STATUS_IGNORE);
+            use_analyzers(analyzerFlags);
+            continue;
+        }
+        if (workStatus == SHARE_CHUNKS) { /* map the window, once the dispatcher has loaded the files */
+            open_shared_chunks(&shared, 0, 0);
+            sync_shared_chunks(&shared);
+            zeroCopy = true;
+            continue;
+        }
+        if (workStatus == SPLIT_NODES) { /* dispatch the blocks of the node, or work for its sub-dispatcher */
+            MPI_Comm localComm, leaderComm;
+
+            split_nodes(rank, &localComm, &leaderComm);
+            if (leaderComm != MPI_COMM_NULL) {
+                run_node_dispatcher(localComm, leaderComm);
+                MPI_Comm_free(&leaderComm);
+            } else {
+                (void) run_worker(localComm);
+            }
+            MPI_Comm_free(&localComm);
+            continue;
+        }
+        if (workStatus == BLOCK_TO_DO) { /* decompress a block of a BGZF file and process it */
+            int length, tailStart;
+
+            if (blockResult == NULL && (((blockResult = malloc(sizeof(BlockResult))) == NULL) ||
+                                        ((text = malloc(MAX_BGZF_BLOCK)) == NULL))) {
+                fprintf(stderr, "error on allocating space to the blocks\n");
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            MPI_Recv((char *) &blockTask, sizeof(BlockTask), MPI_BYTE, 0, 0, comm, MPI_STATUS_IGNORE);
+            if ((length = read_text_block(blockTask.path, blockTask.block, text)) < 0) {
+                fprintf(stderr, "The block at %ld of %s cannot be decompressed\n", blockTask.block.offset,
+                        blockTask.path);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            blockResult->id = blockTask.id;
+            blockResult->results = process_block(text, length, &blockResult->headLength, &tailStart);
+            blockResult->boundary = (blockResult->headLength < length);
+            blockResult->tailLength = length - tailStart;
+            memcpy(blockResult->fragments, text, blockResult->headLength);
+            memcpy(blockResult->fragments + blockResult->headLength, text + tailStart, blockResult->tailLength);
+            MPI_Send((char *) blockResult,
+                     (int) offsetof(BlockResult, fragments) + blockResult->headLength + blockResult->tailLength,
+                     MPI_BYTE, 0, 0, comm);
+            continue;
+        }
+        if (workStatus != WORK_TO_DO) {
+            break;
+        }
+        if (zeroCopy && shared.dispatcherNode) {
+            MPI_Recv((char *) &ref, sizeof(ChunkRef), MPI_BYTE, 0, 0, comm,
+                     MPI_STATUS_IGNORE);
+            result.id = ref.id;
+            result.results = process_bytes(shared.bytes + ref.offset, ref.length);
+        } else {
+            MPI_Recv((char *) &task, sizeof(WorkerTask), MPI_BYTE, 0, 0, comm,
+                     MPI_STATUS_IGNORE);
+            result.id = task.id;
+            result.results = process_chunk(task.chunk);
+        }
+        MPI_Send((char *) &result, sizeof(WorkerResult), MPI_BYTE, 0, 0, comm);
+    }
+    if (zeroCopy) {
+        close_shared_chunks(&shared);
+    }
+    free(blockResult);
+    free(text);
+    return workStatus;
+}
+
 /**
  *  \brief Print command usage.
  *
@@ -404,11 +1374,21 @@ int main(int argc, char *argv[]) {
  */
 static void printUsage(char *cmdName) {
     fprintf(stderr,
-            "\nSynopsis: %s OPTIONS [-f filename / -w number of workers / -b maximum number of bytes per chunk / -h help]\n"
+            "\nSynopsis: %s OPTIONS [-f filename / -w number of workers / -b maximum number of bytes per chunk /\n"
+            "         -s spool directory / -z zero-copy chunks / -d chunks per block / -a analyzers / -h help]\n"
             "  OPTIONS:\n"
-            "  -f      --- filename to process\n"
+            "  -f      --- filename to process, plain or compressed with gzip; the blocks of a file compressed with\n"
+            "              bgzip are decompressed in parallel by the workers\n"
             "  -w      --- number of workers\n"
             "  -b      --- maximum number of bytes per chunk\n"
+            "  -s      --- serve the jobs submitted to the spool directory until its shutdown file appears:\n"
+            "              name.job lists one file per line, its results are written to name.out\n"
+            "  -z      --- load the files once into a shared memory window of the node of the dispatcher, and\n"
+            "              send its workers the position of their chunks instead of the chunks\n"
+            "  -d      --- two-level dispatching: hand blocks of up to this number of chunks to a sub-dispatcher\n"
+            "              per node, which serves the workers of its node (up to %d chunks, %d workers per node)\n"
+            "  -a      --- analyzers run with the vowel counts, separated by commas: lengths (word lengths),\n"
+            "              letters (letter frequencies), sentences, average (average word length) or all\n"
             "  -h      --- print this help\n",
-            cmdName);
+            cmdName, MAX_BLOCK_CHUNKS, MAX_WORKERS);
 }
\ No newline at end of file
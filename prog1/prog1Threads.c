@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "textProcessing.h"
+#include "textChunks.h"
+#include "prog1Utils.h"
+#include "compressedText.h"
+
+/** \brief maximum number of worker threads */
+#define MAX_WORKERS 9
+
+/** \brief maximum number of files */
+#define MAX_FILES   6
+
+/** \brief maximum file size */
+#define MAX_FILE_SIZE  100000
+
+typedef struct TextStruct
+{
+    char *path;
+    int id;
+    TextResult results;
+
+} TextStruct;
+
+typedef struct WorkerTask
+{
+    int id;
+    Chunk chunk;
+} WorkerTask;
+
+/** \brief tasks shared by the worker threads, claimed in order without locks */
+typedef struct TaskQueue
+{
+    WorkerTask *tasks;
+    int nTasks;
+    atomic_int next;    /* next task to claim */
+} TaskQueue;
+
+typedef struct WorkerThread
+{
+    pthread_t thread;
+    TaskQueue *queue;
+    TextResult results[MAX_FILES]; /* results of the chunks processed by the thread, per file */
+} WorkerThread;
+
+/** \brief print proper use of the program parameters and arguments */
+static void printUsage(char *cmdName);
+
+/** \brief life cycle of a worker thread */
+static void *worker(void *arg);
+
+/**
+ *  \brief Process execution, with threads in a single process instead of MPI processes.
+ *
+ *  Same command line and output as prog1, so the times of both builds can be compared.
+ *
+ *  1 - Process the arguments from the command line.
+ *
+ *  2 - Create tasks.
+ *
+ *  3 - Start the worker threads, which claim the tasks from the shared queue until it is empty, and
+ *  wait for them.
+ *
+ *  4 - Reduce the results of every worker and print them.
+ *
+ *  \param argc number of arguments in the command line
+ *  \param argv list of arguments in the command line
+ *
+ *  \return status of operation
+ */
+int main(int argc, char *argv[]) {
+    /* Set program variables */
+    int nFiles = 0;                      /* number of text files (maximum=MAX_FILES) */
+    char *files[MAX_FILES];              /* text file array (maximum=MAX_FILES)*/
+    int maxChunkBytes = MAX_CHUNK_BYTES; /* maximum number of bytes per chunk */
+    int taskCapacity = 0; /* number of tasks the array has room for */
+    long fileSize;        /* number of bytes of the text of a file, decompressed */
+    int nTasks;                          /* number of tasks */
+    int filePointer = 0; /* file pointer to the fileSpace data structure */
+    long nWorkers = sysconf(_SC_NPROCESSORS_ONLN); /* number of worker threads */
+    unsigned int analyzerFlags = 0; /* analyzers run with the vowel counts */
+
+    WorkerTask *taskSpace;                        /* array of tasks */
+    TextStruct *fileSpace;                        /* file data array structure */
+    WorkerThread *workers;                        /* worker threads */
+    TaskQueue queue;
+
+    /* Reference handlers */
+    TextStruct *file;
+    WorkerTask task;
+
+    if (nWorkers < 1 || nWorkers > MAX_WORKERS) {
+        nWorkers = (nWorkers < 1) ? 1 : MAX_WORKERS;
+    }
+
+    /* process command line options */
+    int opt; /* selected option */
+    do {
+        switch ((opt = getopt(argc, argv, "f:w:b:s:a:h"))) {
+            case 'f':                 /* file */
+                if (optarg[0] == '-') /* filename is missing */
+                {
+                    fprintf(stderr, "%s: filename is missing\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                if (nFiles + 1 > MAX_FILES) /* Exceeding number of files allowed */
+                {
+                    fprintf(stderr, "%s: maximum number of files is %d\n", basename(argv[0]), MAX_FILES);
+                    exit(EXIT_FAILURE);
+                }
+                if (!is_file_open(optarg)) { /* Error while opening file */
+                    fprintf(stderr, "%s: file %s cannot be open.\n", basename(argv[0]), optarg);
+                    exit(EXIT_FAILURE);
+                }
+                if (get_text_format(optarg) == TEXT_ZSTD) { /* zstd frames are not supported */
+                    fprintf(stderr, "%s: file %s is compressed with zstd, which this build does not support.\n",
+                            basename(argv[0]), optarg);
+                    exit(EXIT_FAILURE);
+                }
+                if ((fileSize = get_text_size(optarg)) < 0) { /* Corrupted compressed file, decompressed once */
+                    fprintf(stderr, "%s: file %s cannot be decompressed.\n", basename(argv[0]), optarg);
+                    exit(EXIT_FAILURE);
+                }
+                if (fileSize > MAX_FILE_SIZE) { /* Exceeding maximum file size, decompressed */
+                    fprintf(stderr, "%s: file %s is too big maximum file size is %d.\n",
+                            basename(argv[0]), optarg, MAX_FILE_SIZE);
+                    exit(EXIT_FAILURE);
+                }
+                files[nFiles++] = optarg;
+                break;
+            case 'w': /* number of worker threads */
+                if (atoi(optarg) <= 0 || atoi(optarg) > MAX_WORKERS) {
+                    fprintf(stderr, "%s: the number of workers should be between 1 and %d\n", basename(argv[0]),
+                            MAX_WORKERS);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                nWorkers = atoi(optarg);
+                break;
+            case 'b': /* maximum number of bytes per chunk */
+                if (atoi(optarg) <= 0) { /* non-positive number */
+                    fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                if (atoi(optarg) > MAX_CHUNK_BYTES) { /* Exceeding maximum number of bytes per chunk */
+                    fprintf(stderr, "%s: chunk size cannot be greater than %d\n", basename(argv[0]),
+                            MAX_CHUNK_BYTES);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                maxChunkBytes = (int) atoi(optarg);
+                break;
+            case 'a': /* analyzers */
+                if (!parse_analyzers(optarg, &analyzerFlags)) {
+                    fprintf(stderr, "%s: unknown analyzer\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 's': /* service mode */
+                fprintf(stderr, "%s: the service mode is only available in the MPI build\n", basename(argv[0]));
+                exit(EXIT_FAILURE);
+            case 'h': /* help mode */
+                printUsage(basename(argv[0]));
+                exit(EXIT_SUCCESS);
+            case '?': /* invalid option */
+                fprintf(stderr, "%s: invalid option\n", basename(argv[0]));
+                printUsage(basename(argv[0]));
+                exit(EXIT_FAILURE);
+            case -1:
+                break;
+        }
+    } while (opt != -1);
+    if (optind < argc) {
+        fprintf(stderr, "%s: invalid format\n", basename(argv[0]));
+        printUsage(basename(argv[0]));
+        exit(EXIT_FAILURE);
+    }
+    use_analyzers(analyzerFlags);
+
+    /* initialise fileSpace */
+    if ((fileSpace = (TextStruct *) malloc(nFiles * sizeof(TextStruct))) == NULL) {
+        fprintf(stderr, "error on allocating space to the file data array\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < nFiles; i++) {
+        file = (fileSpace + i);
+        file->path = files[i];
+        file->id = i;
+        file->results = get_initial_result();
+    }
+
+    /* Generate tasks, the chunks are cut back to the start of a word so their number is only known at the end */
+    taskSpace = NULL;
+    nTasks = 0;
+    while (filePointer < nFiles) {
+        file = (fileSpace + filePointer);
+        FILE *fp = open_text(file->path);
+        if (fp == NULL) {
+            fprintf(stderr, "file %s cannot be open.\n", file->path);
+            exit(EXIT_FAILURE);
+        }
+        while (!feof(fp)) {
+            task.id = file->id;
+            task.chunk = get_chunk(fp, maxChunkBytes);
+            if (nTasks == taskCapacity) {
+                taskCapacity = (taskCapacity > 0) ? 2 * taskCapacity : 64;
+                if ((taskSpace = (WorkerTask *) realloc(taskSpace, taskCapacity * sizeof(WorkerTask))) == NULL) {
+                    fprintf(stderr, "error on allocating space to the tasks data array\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+            taskSpace[nTasks++] = task;
+        }
+        fclose(fp);
+        filePointer++;
+    }
+
+    /* process tasks */
+    queue.tasks = taskSpace;
+    queue.nTasks = nTasks;
+    atomic_init(&queue.next, 0);
+    if ((workers = (WorkerThread *) malloc(nWorkers * sizeof(WorkerThread))) == NULL) {
+        fprintf(stderr, "error on allocating space to the workers\n");
+        exit(EXIT_FAILURE);
+    }
+    (void) get_delta_time();
+    for (int i = 0; i < nWorkers; i++) {
+        workers[i].queue = &queue;
+        if (pthread_create(&workers[i].thread, NULL, worker, &workers[i]) != 0) {
+            perror("error on creating the worker threads");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (int i = 0; i < nWorkers; i++) {
+        pthread_join(workers[i].thread, NULL);
+        for (int j = 0; j < nFiles; j++) {
+            fileSpace[j].results = reduce(fileSpace[j].results, workers[i].results[j]);
+        }
+    }
+
+    printf("\nElapsed time multi thread = %.6fs\n\n", get_delta_time());
+    for (int i = 0; i < nFiles; i++) { /* print results */
+        printf("id: %d\n", fileSpace[i].id);
+        print_results(files[i], fileSpace[i].results);
+        printf("\n");
+    }
+    free(workers);
+    free(taskSpace);
+    free(fileSpace);
+    exit(EXIT_SUCCESS);
+}
+
+/**
+ *  \brief Life cycle of a worker thread.
+ *
+ *  The thread claims the next task with an atomic increment of the head of the queue, processes its chunk
+ *  and adds the result to its own results of the file, until every task is claimed.
+ *
+ *  \param arg the WorkerThread of the thread
+ */
+static void *worker(void *arg) {
+    WorkerThread *self = (WorkerThread *) arg;
+    TaskQueue *queue = self->queue;
+    int taskId;
+
+    for (int i = 0; i < MAX_FILES; i++) {
+        self->results[i] = get_initial_result();
+    }
+    while ((taskId = atomic_fetch_add_explicit(&queue->next, 1, memory_order_relaxed)) < queue->nTasks) {
+        WorkerTask *task = &queue->tasks[taskId];
+        self->results[task->id] = reduce(self->results[task->id], process_chunk(task->chunk));
+    }
+    return NULL;
+}
+
+/**
+ *  \brief Print command usage.
+ *
+ *  A message specifying how the program should be called is printed.
+ *
+ *  \param cmdName string with the name of the command
+ */
+static void printUsage(char *cmdName) {
+    fprintf(stderr,
+            "\nSynopsis: %s OPTIONS [-f filename / -w number of workers / -b maximum number of bytes per chunk /\n"
+            "         -a analyzers / -h help]\n"
+            "  OPTIONS:\n"
+            "  -f      --- filename to process, plain or compressed with gzip\n"
+            "  -w      --- number of worker threads (default: number of processors, up to %d)\n"
+            "  -b      --- maximum number of bytes per chunk\n"
+            "  -a      --- analyzers run with the vowel counts, separated by commas: lengths (word lengths),\n"
+            "              letters (letter frequencies), sentences, average (average word length) or all\n"
+            "  -h      --- print this help\n",
+            cmdName, MAX_WORKERS);
+}
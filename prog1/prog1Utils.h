@@ -0,0 +1,15 @@
+/**
+ *  \file prog1Utils.h (definition file)
+ *  \brief Header file containing the declarations for the helpers of prog1.
+ */
+#ifndef PROG1_UTILS_H
+#define PROG1_UTILS_H
+
+#include <stdbool.h>
+
+extern double get_delta_time(void);
+extern long get_file_size(char *path);
+extern bool is_file_open(char *path);
+extern int *get_workers(int size, int rank_dispatcher);
+
+#endif /* PROG1_UTILS_H */
@@ -0,0 +1,146 @@
+/**
+ *  \file sharedChunks.c (definition file)
+ *  \brief Chunks handed to the workers through an MPI shared memory window.
+ *
+ *  The dispatcher reads every file once into a window allocated with MPI_Win_allocate_shared, and the
+ *  workers of its node map the same memory: a task is then sent as the position of its chunk in the window,
+ *  and the worker processes the bytes where they are. Workers of other nodes cannot see the window, so the
+ *  dispatcher still sends them the bytes of their chunks.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sharedChunks.h"
+#include "textChunks.h"
+#include "compressedText.h"
+
+/**
+ * \brief Creates the shared window. Collective over MPI_COMM_WORLD.
+ *
+ * The window is split by node; the dispatcher is the first process of its node and owns the whole
+ * window, the other processes allocate nothing and map the memory of the first process of their node.
+ *
+ * \param shared The window to create.
+ * \param size The number of bytes of the files, only significant in the dispatcher.
+ * \param dispatcher The rank of the dispatcher in MPI_COMM_WORLD.
+ */
+void open_shared_chunks(SharedChunks *shared, MPI_Aint size, int dispatcher) {
+    int rank, dispUnit;
+    MPI_Aint ownSize;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, (rank == dispatcher) ? 0 : 1, MPI_INFO_NULL,
+                        &shared->nodeComm);
+    ownSize = (rank == dispatcher) ? ((size > 0) ? size : 1) : 0;
+    MPI_Win_allocate_shared(ownSize, 1, MPI_INFO_NULL, shared->nodeComm, &shared->bytes, &shared->win);
+    MPI_Win_shared_query(shared->win, 0, &shared->size, &dispUnit, &shared->bytes);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, shared->win);
+    shared->dispatcherNode = is_on_dispatcher_node(shared, dispatcher);
+}
+
+/**
+ * \brief Checks whether a process shares the node, and so the window, of this process.
+ *
+ * \param shared The window.
+ * \param rank The rank of the process in MPI_COMM_WORLD.
+ *
+ * \return true if the process belongs to the node of this process, false otherwise.
+ */
+bool is_on_dispatcher_node(SharedChunks *shared, int rank) {
+    MPI_Group worldGroup, nodeGroup;
+    int nodeRank;
+
+    MPI_Comm_group(MPI_COMM_WORLD, &worldGroup);
+    MPI_Comm_group(shared->nodeComm, &nodeGroup);
+    MPI_Group_translate_ranks(worldGroup, 1, &rank, nodeGroup, &nodeRank);
+    MPI_Group_free(&worldGroup);
+    MPI_Group_free(&nodeGroup);
+    return nodeRank != MPI_UNDEFINED;
+}
+
+/**
+ * \brief Reads the files into the window and cuts them in chunks. Only called by the dispatcher.
+ *
+ * The chunks are cut by get_chunk(), over the copy of the file in the window, so they end at the same
+ * word boundaries as the chunks sent by message. A compressed file is decompressed into the window.
+ *
+ * \param shared The window, with room for every file.
+ * \param files The paths to the files.
+ * \param sizes The number of bytes of the text of every file, decompressed.
+ * \param nFiles The number of files.
+ * \param maxChunkBytes The maximum number of bytes per chunk.
+ * \param chunks Where the chunks are written, to be freed by the caller.
+ *
+ * \return the number of chunks.
+ */
+int load_shared_chunks(SharedChunks *shared, char **files, long *sizes, int nFiles, int maxChunkBytes,
+                       ChunkRef **chunks) {
+    MPI_Aint offset = 0;
+    int nChunks = 0, capacity = 0;
+
+    *chunks = NULL;
+    for (int i = 0; i < nFiles; i++) {
+        long size = sizes[i];
+        FILE *fp;
+
+        if (size == 0) {
+            continue;
+        }
+        if (offset + size > shared->size || (fp = open_text(files[i])) == NULL ||
+            fread(shared->bytes + offset, 1, (size_t) size, fp) != (size_t) size) {
+            fprintf(stderr, "load_shared_chunks(): error while reading %s into the shared window\n", files[i]);
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        fclose(fp);
+        if ((fp = fmemopen(shared->bytes + offset, (size_t) size, "rb")) == NULL) {
+            perror("load_shared_chunks(): fmemopen");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+        while (!feof(fp)) {
+            long start = ftell(fp);
+            Chunk chunk = get_chunk(fp, maxChunkBytes);
+
+            if (nChunks == capacity) {
+                capacity = (capacity > 0) ? 2 * capacity : 64;
+                if ((*chunks = realloc(*chunks, capacity * sizeof(ChunkRef))) == NULL) {
+                    fprintf(stderr, "load_shared_chunks(): error while allocating memory for the chunks\n");
+                    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                }
+            }
+            (*chunks)[nChunks].id = i;
+            (*chunks)[nChunks].length = chunk.length;
+            (*chunks)[nChunks].offset = offset + start;
+            nChunks++;
+        }
+        fclose(fp);
+        offset += size;
+    }
+    return nChunks;
+}
+
+/**
+ * \brief Makes the files loaded by the dispatcher visible to the processes of its node. Collective over
+ * every node.
+ *
+ * \param shared The window.
+ */
+void sync_shared_chunks(SharedChunks *shared) {
+    MPI_Win_sync(shared->win);
+    MPI_Barrier(shared->nodeComm);
+    MPI_Win_sync(shared->win);
+}
+
+/**
+ * \brief Frees the window. Collective over every node.
+ *
+ * \param shared The window.
+ */
+void close_shared_chunks(SharedChunks *shared) {
+    MPI_Win_unlock_all(shared->win);
+    MPI_Win_free(&shared->win);
+    MPI_Comm_free(&shared->nodeComm);
+}
@@ -0,0 +1,36 @@
+/**
+ *  \file sharedChunks.h (definition file)
+ *  \brief Header file containing the declarations for the chunks shared through an MPI shared memory window.
+ */
+#ifndef SHARED_CHUNKS_H
+#define SHARED_CHUNKS_H
+
+#include <stdbool.h>
+#include <mpi.h>
+
+/** \brief chunk of a file held in the shared window, sent instead of its bytes */
+typedef struct ChunkRef
+{
+    int id;          /* file of the chunk */
+    int length;      /* number of bytes of the chunk */
+    MPI_Aint offset; /* position of the chunk in the window */
+} ChunkRef;
+
+/** \brief window where the dispatcher loads the files, shared with the processes of its node */
+typedef struct SharedChunks
+{
+    MPI_Comm nodeComm;      /* processes of the node */
+    MPI_Win win;
+    unsigned char *bytes;   /* the files, one after the other, as seen by this process */
+    MPI_Aint size;
+    bool dispatcherNode;    /* the process shares the node of the dispatcher */
+} SharedChunks;
+
+extern void open_shared_chunks(SharedChunks *shared, MPI_Aint size, int dispatcher);
+extern bool is_on_dispatcher_node(SharedChunks *shared, int rank);
+extern int load_shared_chunks(SharedChunks *shared, char **files, long *sizes, int nFiles, int maxChunkBytes,
+                              ChunkRef **chunks);
+extern void sync_shared_chunks(SharedChunks *shared);
+extern void close_shared_chunks(SharedChunks *shared);
+
+#endif /* SHARED_CHUNKS_H */
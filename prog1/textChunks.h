@@ -0,0 +1,30 @@
+/**
+ *  \file textChunks.h (definition file)
+ *  \brief Header file containing the declarations for the analysis of a text cut in chunks, used by prog1.
+ *
+ *  These functions end the process on a text that is not valid UTF-8, so they are not part of the library,
+ *  which analyzes a text with text_stats_feed() and reports the error instead.
+ */
+#ifndef TEXT_CHUNKS_H
+#define TEXT_CHUNKS_H
+
+#include <stdio.h>
+
+#include "textProcessing.h"
+
+/** \brief maximum number of bytes per chunk */
+#define MAX_CHUNK_BYTES 8000
+
+typedef struct Chunk
+{
+    int length;
+    int position;
+    unsigned char bytes[MAX_CHUNK_BYTES];
+} Chunk;
+
+extern Chunk get_chunk(FILE *fp, int maxChunkBytes);
+extern TextResult process_chunk(Chunk chunk);
+extern TextResult process_bytes(const unsigned char *bytes, int length);
+extern TextResult process_block(const unsigned char *bytes, int length, int *headLength, int *tailStart);
+
+#endif /* TEXT_CHUNKS_H */
@@ -5,21 +5,34 @@
  * Author:  Renan Ferreira
  *          João Reis
  */
+#include <string.h>
+
 #include "textProcessing.h"
+#include "textChunks.h"
 
 typedef struct UTF8Character {
     unsigned char character[MAX_UTF8_CHAR_SIZE];
     short length;
 } UTF8Character;
 
-typedef struct TextPartialResult {
-    TextResult results;
-    bool inWord;
-    bool vowelPresence[TOTAL_VOWELS];
-} TextPartialResult;
+/**
+ * \brief An analyzer run in the same pass as the vowel counts. It keeps its own result in TextResult, and
+ *        only the hooks it needs are set.
+ */
+typedef struct Analyzer {
+    char *name;
+    unsigned int flag;
+    /** called for every character but the mergers; afterWord tells whether it follows a word character */
+    void (*on_char)(UTF8Character character, bool afterWord, TextResult *result);
+    /** called at the end of every word, with its number of characters */
+    void (*on_word)(int length, TextResult *result);
+    void (*reduce)(TextResult *into, const TextResult *from);
+    void (*print)(FILE *fp, const TextResult *result);
+} Analyzer;
+
+typedef struct AnalyzerHooks AnalyzerHooks;
 
 static bool isWordCharacter(UTF8Character character);
-static bool isVowel(UTF8Character character);
 static bool isVowelA(UTF8Character character);
 static bool isVowelE(UTF8Character character);
 static bool isVowelI(UTF8Character character);
@@ -35,8 +48,46 @@ static int getCharSize(unsigned char first_byte);
 
 static TextPartialResult get_initial_partial_result();
 static int get_vowel_idx(UTF8Character character);
-static UTF8Character get_char(Chunk *chunk);
-static void process_char(UTF8Character character, TextPartialResult *results);
+static UTF8Character get_char(const unsigned char *bytes, int length, int *position);
+static void process_char(UTF8Character character, TextPartialResult *results, const AnalyzerHooks *hooks);
+static void end_word(TextPartialResult *results, const AnalyzerHooks *hooks);
+static void select_hooks(unsigned int flags, AnalyzerHooks *hooks);
+
+static int get_letter_idx(UTF8Character character);
+static void count_length(int length, TextResult *result);
+static void reduce_lengths(TextResult *into, const TextResult *from);
+static void print_lengths(FILE *fp, const TextResult *result);
+static void count_letter(UTF8Character character, bool afterWord, TextResult *result);
+static void reduce_letters(TextResult *into, const TextResult *from);
+static void print_letters(FILE *fp, const TextResult *result);
+static void count_sentence(UTF8Character character, bool afterWord, TextResult *result);
+static void reduce_sentences(TextResult *into, const TextResult *from);
+static void print_sentences(FILE *fp, const TextResult *result);
+static void count_average(int length, TextResult *result);
+static void reduce_average(TextResult *into, const TextResult *from);
+static void print_average(FILE *fp, const TextResult *result);
+
+/** \brief every analyzer, in the order their results are printed */
+static const Analyzer analyzers[] = {
+    {"lengths", ANALYZER_LENGTHS, NULL, count_length, reduce_lengths, print_lengths},
+    {"letters", ANALYZER_LETTERS, count_letter, NULL, reduce_letters, print_letters},
+    {"sentences", ANALYZER_SENTENCES, count_sentence, NULL, reduce_sentences, print_sentences},
+    {"average", ANALYZER_AVERAGE, NULL, count_average, reduce_average, print_average},
+};
+
+#define TOTAL_ANALYZERS ((int) (sizeof(analyzers) / sizeof(analyzers[0])))
+
+/** \brief the analyzers of a selection with a hook for every character or every word */
+struct AnalyzerHooks {
+    const Analyzer *charAnalyzers[TOTAL_ANALYZERS];
+    const Analyzer *wordAnalyzers[TOTAL_ANALYZERS];
+    int nCharAnalyzers;
+    int nWordAnalyzers;
+};
+
+/** \brief the analyzers selected with use_analyzers(), run by the analyses that are not given a selection */
+static unsigned int defaultFlags = 0;
+static AnalyzerHooks defaultHooks;
 
 /**
 * \brief Checks if the given UTF8 character is a word character.
@@ -62,30 +113,6 @@ bool isWordCharacter(UTF8Character character) {
     return true;
 }
 
-/**
-* \brief Checks if the given UTF8 character is a vowel.
-*
-* \param character The UTF8 character to be checked.
-*
-* \return true if the given character is a vowel, false otherwise.
-*/
-bool isVowel(UTF8Character character) {
-    if (isVowelA(character))
-        return true;
-    if (isVowelE(character))
-        return true;
-    if (isVowelI(character))
-        return true;
-    if (isVowelO(character))
-        return true;
-    if (isVowelU(character))
-        return true;
-    if (isVowelY(character))
-        return true;
-
-    return false;
-}
-
 /**
 * \brief Checks if the given UTF8 character is a vowel A.
 *
@@ -467,7 +494,7 @@ int getCharSize(unsigned char first_byte) {
         if ((1 << 6) & first_byte) {
             if ((1 << 5) & first_byte) {
                 if ((1 << 4) & first_byte) {
-                    if ((1 << 3) & first_byte) { // 11110xxx
+                    if (!((1 << 3) & first_byte)) { // 11110xxx
                         return 4;
                     }
                 } else { // 1110xxxx
@@ -491,10 +518,7 @@ int getCharSize(unsigned char first_byte) {
  */
 TextResult get_initial_result() {
     TextResult result;
-    result.nWords = 0;
-    for (int i = 0; i < TOTAL_VOWELS; i++) {
-        result.nWordsVowel[i] = 0;
-    }
+    memset(&result, 0, sizeof(TextResult)); /* the counts of every analyzer too */
     return result;
 }
 
@@ -507,6 +531,7 @@ TextResult get_initial_result() {
 TextPartialResult get_initial_partial_result() {
     TextPartialResult partialResult;
     partialResult.inWord = false;
+    partialResult.wordLength = 0;
     for (int i = 0; i < TOTAL_VOWELS; i++) {
         partialResult.vowelPresence[i] = false;
     }
@@ -536,8 +561,7 @@ int get_vowel_idx(UTF8Character character) {
     if (isVowelY(character))
         return Y_IDX;
 
-    fprintf(stderr, "Error! character is not a vowel!\n");
-    exit(EXIT_FAILURE);
+    return -1;
 }
 
 /**
@@ -548,21 +572,37 @@ int get_vowel_idx(UTF8Character character) {
  * \param results The results of the text analysis.
  */
 void print_results(char *filename, TextResult results) {
-    printf("File name: %s\n", filename);
-    printf("Total number of words = %d\n", results.nWords);
-    printf("N. of words with an:\n");
-    printf("A\tE\tI\tO\tU\tY\n");
+    fprint_results(stdout, filename, results);
+}
+
+/**
+ * \brief Prints the results of a text analysis to a file, in the format of print_results().
+ *
+ * \param fp The file where the results are printed.
+ * \param filename The name of the file being analyzed.
+ * \param results The results of the text analysis.
+ */
+void fprint_results(FILE *fp, char *filename, TextResult results) {
+    fprintf(fp, "File name: %s\n", filename);
+    fprintf(fp, "Total number of words = %d\n", results.nWords);
+    fprintf(fp, "N. of words with an:\n");
+    fprintf(fp, "A\tE\tI\tO\tU\tY\n");
 
-    printf("%d", results.nWordsVowel[0]);
+    fprintf(fp, "%d", results.nWordsVowel[0]);
     for (int i = 1; i < TOTAL_VOWELS; i++) {
-        printf("\t%d", results.nWordsVowel[i]);
+        fprintf(fp, "\t%d", results.nWordsVowel[i]);
+    }
+    fprintf(fp, "\n");
+    for (int i = 0; i < TOTAL_ANALYZERS; i++) {
+        if ((defaultFlags & analyzers[i].flag) != 0) {
+            analyzers[i].print(fp, &results);
+        }
     }
-    printf("\n");
 }
 
 /**
  * \brief Combines information from two TextResult objects to create a new one that represents the
- *        combined analysis of a larger text.
+ *        combined analysis of a larger text, with the analyzers selected with use_analyzers().
  *
  * \param first The first TextResult object to be combined.
  * \param second The second TextResult object to be combined.
@@ -570,11 +610,29 @@ void print_results(char *filename, TextResult results) {
  * \return A new TextResult object that contains the combined analysis of the input objects.
  */
 TextResult reduce(TextResult first, TextResult second) {
-    TextResult result;
+    return reduce_analyzers(first, second, defaultFlags);
+}
+
+/**
+ * \brief Combines two TextResult objects like reduce(), for the results of a given selection of analyzers.
+ *
+ * \param first The first TextResult object to be combined.
+ * \param second The second TextResult object to be combined.
+ * \param flags The flags of the analyzers that produced the results.
+ *
+ * \return A new TextResult object that contains the combined analysis of the input objects.
+ */
+TextResult reduce_analyzers(TextResult first, TextResult second, unsigned int flags) {
+    TextResult result = first;
     result.nWords = first.nWords + second.nWords;
     for (int i = 0; i < TOTAL_VOWELS; i++) {
         result.nWordsVowel[i] = first.nWordsVowel[i] + second.nWordsVowel[i];
     }
+    for (int i = 0; i < TOTAL_ANALYZERS; i++) {
+        if ((flags & analyzers[i].flag) != 0) {
+            analyzers[i].reduce(&result, &second);
+        }
+    }
     return result;
 }
 
@@ -586,56 +644,216 @@ TextResult reduce(TextResult first, TextResult second) {
  * \return The result of the analysis on the given text chunk.
  */ 
 TextResult process_chunk(Chunk chunk) {
+    return process_bytes(chunk.bytes, chunk.length);
+}
+
+/**
+ * \brief Processes the bytes of a chunk of text where they are, without copying them into a Chunk.
+ *
+ * \param bytes The bytes of the chunk, which must end at a character boundary.
+ * \param length The number of bytes of the chunk.
+ *
+ * \return The result of the analysis on the given bytes.
+ */
+TextResult process_bytes(const unsigned char *bytes, int length) {
     UTF8Character character;
     TextPartialResult result = get_initial_partial_result();
+    int position = 0;
 
-    chunk.position = 0;
     while (true) {
-        character = get_char(&chunk);
+        character = get_char(bytes, length, &position);
         if (character.length == -1) {
             break;
         }
-        process_char(character, &result);
+        process_char(character, &result, &defaultHooks);
+    }
+    if (result.inWord) { /* the text ends with a word */
+        end_word(&result, &defaultHooks);
     }
     return result.results;
 }
 
 /**
- * \brief Gets the next UTF-8 character from a Chunk structure and returns it as a UTF8Character struct.
+ * \brief Starts the incremental analysis of a text, fed to text_stats_feed() in spans.
+ *
+ * The selection of analyzers belongs to the context, so the analyses of a process may run different ones,
+ * and their results are merged with reduce_analyzers() and the same selection.
+ *
+ * \param stats The context of the analysis.
+ * \param flags The flags of the analyzers run with the vowel counts, 0 for the vowel counts only.
+ */
+void text_stats_init(TextStats *stats, unsigned int flags) {
+    stats->analyzers = flags;
+    stats->state = get_initial_partial_result();
+    stats->nPending = 0;
+    stats->failed = false;
+}
+
+/**
+ * \brief Analyzes the next span of a text, where the bytes are. A span may start and end anywhere, in the
+ *        middle of a word or of a character: the word is carried on, and the bytes of the character are kept
+ *        in the context until the next span completes it.
+ *
+ * \param stats The context of the analysis.
+ * \param bytes The bytes of the span.
+ * \param length The number of bytes of the span.
+ *
+ * \return true on success, false if the text is not valid UTF-8; the analysis then ignores any later span.
+ */
+bool text_stats_feed(TextStats *stats, const unsigned char *bytes, size_t length) {
+    UTF8Character character;
+    AnalyzerHooks hooks;
+    size_t position = 0;
+    int charLength;
+
+    if (stats->failed) {
+        return false;
+    }
+    select_hooks(stats->analyzers, &hooks);
+    while (position < length) {
+        if (stats->nPending > 0) { /* complete the character cut by the end of the last span */
+            charLength = getCharSize(stats->pending[0]);
+            while (stats->nPending < charLength && position < length) {
+                stats->pending[stats->nPending++] = bytes[position++];
+            }
+            if (stats->nPending < charLength) {
+                return true;
+            }
+            memcpy(character.character, stats->pending, charLength);
+            stats->nPending = 0;
+        } else {
+            charLength = getCharSize(bytes[position]);
+            if (charLength == -1) {
+                stats->failed = true;
+                return false;
+            }
+            if (position + charLength > length) { /* the character ends in the next span */
+                stats->nPending = (int) (length - position);
+                memcpy(stats->pending, bytes + position, stats->nPending);
+                return true;
+            }
+            memcpy(character.character, bytes + position, charLength);
+            position += charLength;
+        }
+        character.length = (short) charLength;
+        process_char(character, &stats->state, &hooks);
+    }
+    return true;
+}
+
+/**
+ * \brief Ends the incremental analysis of a text, and gets its results. The results of the parts of a text
+ *        analyzed apart are merged with reduce_analyzers(), as long as the parts are cut between words.
+ *
+ * \param stats The context of the analysis, which may be started again with text_stats_init().
+ * \param result Where the results of the text are written.
+ *
+ * \return true on success, false if the text is not valid UTF-8 or ends in the middle of a character; the
+ *         results then cover the text before the error.
+ */
+bool text_stats_finish(TextStats *stats, TextResult *result) {
+    if (stats->state.inWord) { /* the text ends with a word */
+        AnalyzerHooks hooks;
+        select_hooks(stats->analyzers, &hooks);
+        end_word(&stats->state, &hooks);
+        stats->state.inWord = false;
+    }
+    *result = stats->state.results;
+    return !stats->failed && stats->nPending == 0;
+}
+
+/**
+ * \brief Processes the text of a block cut at any byte, such as a block of a compressed file, between its
+ *        first and its last word boundary.
+ *
+ * A boundary is a character that ends any word, so the text after it can be processed on its own. The bytes
+ * up to the first boundary (the head) and after the last one (the tail) are left to the caller, which joins
+ * the tail of a block with the head of the next one; the block may start and end in the middle of a
+ * character.
+ *
+ * \param bytes The bytes of the block.
+ * \param length The number of bytes of the block.
+ * \param headLength Where the number of bytes of the head is written, the boundary included; the length of
+ *        the block if it has no boundary.
+ * \param tailStart Where the position of the tail is written; the length of the block if it has no boundary.
+ *
+ * \return The result of the analysis of the text between the head and the tail.
+ */
+TextResult process_block(const unsigned char *bytes, int length, int *headLength, int *tailStart) {
+    UTF8Character character;
+    int position = 0, first = -1, last = -1;
+
+    while (position < length && (bytes[position] & 0xC0) == 0x80) { /* end of a character of the last block */
+        position++;
+    }
+    while (position < length) {
+        int charLength = getCharSize(bytes[position]);
+        if (charLength == -1) {
+            fprintf(stderr, "process_block(): Character is defected. byte 0x%x. block position %d\n",
+                    bytes[position], position);
+            exit(EXIT_FAILURE);
+        }
+        if (position + charLength > length) { /* the character ends in the next block */
+            break;
+        }
+        character.length = (short) charLength;
+        memcpy(character.character, bytes + position, charLength);
+        position += charLength;
+        if (!isWordCharacter(character) && !isMerger(character)) {
+            if (first == -1) {
+                first = position;
+            }
+            last = position;
+        }
+    }
+    if (first == -1) {
+        *headLength = length;
+        *tailStart = length;
+        return get_initial_result();
+    }
+    *headLength = first;
+    *tailStart = last;
+    return process_bytes(bytes + first, last - first);
+}
+
+/**
+ * \brief Gets the next UTF-8 character from the bytes of a chunk and returns it as a UTF8Character struct.
  *
- * \param chunk A pointer to a Chunk structure from which to get the next character.
+ * \param bytes The bytes of the chunk from which to get the next character.
+ * \param length The number of bytes of the chunk.
+ * \param position A pointer to the position of the next character, advanced past it.
  *
- * \return A UTF8Character struct representing the next UTF-8 character in the Chunk structure.
+ * \return A UTF8Character struct representing the next UTF-8 character in the chunk.
  *         Returns NULL_CHAR if there are no more characters to get.
  */ 
-UTF8Character get_char(Chunk *chunk) {
+UTF8Character get_char(const unsigned char *bytes, int length, int *position) {
     UTF8Character character;
 
-    if (chunk->position == chunk->length) {
+    if (*position == length) {
         character.length = -1;
         return character;
     }
 
-    if (chunk->position > chunk->length) {
-        fprintf(stderr, "Cannot get character by position %d, above chunk length%d\n", chunk->position, chunk->length);
+    if (*position > length) {
+        fprintf(stderr, "Cannot get character by position %d, above chunk length%d\n", *position, length);
         exit(EXIT_FAILURE);
     }
 
-    int length = getCharSize(chunk->bytes[chunk->position]);
-    if (length == -1) {
+    int charLength = getCharSize(bytes[*position]);
+    if (charLength == -1) {
         fprintf(stderr, "get_char(): Character is defected. byte 0x%x. chunk length %d. chunk position %d\n",
-                chunk->bytes[chunk->position], chunk->length, chunk->position);
+                bytes[*position], length, *position);
         exit(EXIT_FAILURE);
     }
-    if (chunk->position + length > chunk->length) {
+    if (*position + charLength > length) {
         fprintf(stderr, "Chunk is defected. character to read has size above chunk length.\n");
         exit(EXIT_FAILURE);
     }
 
 
-    character.length = (short)length;
+    character.length = (short)charLength;
     for (int i = 0; i < character.length; i++) {
-        character.character[i] = chunk->bytes[chunk->position++];
+        character.character[i] = bytes[(*position)++];
     }
     return character;
 }
@@ -645,17 +863,21 @@ UTF8Character get_char(Chunk *chunk) {
  *
  * \param character The UTF-8 character to be processed.
  * \param results A pointer to a TextPartialResult structure to be updated.
+ * \param hooks The analyzers run with the vowel counts.
  */ 
-void process_char(UTF8Character character, TextPartialResult *results) {
+void process_char(UTF8Character character, TextPartialResult *results, const AnalyzerHooks *hooks) {
     if(isMerger(character)) {
         return;
     }
+    for (int i = 0; i < hooks->nCharAnalyzers; i++) {
+        hooks->charAnalyzers[i]->on_char(character, results->inWord, &results->results);
+    }
 
     int vowelIdx;
     if (results->inWord) {
         if (isWordCharacter(character)) {
-            if (isVowel(character)) {
-                vowelIdx = get_vowel_idx(character);
+            results->wordLength++;
+            if ((vowelIdx = get_vowel_idx(character)) != -1) {
                 if (!results->vowelPresence[vowelIdx]) {
                     results->results.nWordsVowel[vowelIdx]++;
                     results->vowelPresence[vowelIdx] = true;
@@ -663,16 +885,17 @@ void process_char(UTF8Character character, TextPartialResult *results) {
             }
         } else {
             results->inWord = false;
+            end_word(results, hooks);
         }
     } else {
         if (isWordCharacter(character)) {
             results->inWord = true;
+            results->wordLength = 1;
             results->results.nWords++;
             for (int i = 0; i < TOTAL_VOWELS; i++) {
                 results->vowelPresence[i] = false;
             }
-            if (isVowel(character)) {
-                vowelIdx = get_vowel_idx(character);
+            if ((vowelIdx = get_vowel_idx(character)) != -1) {
                 results->results.nWordsVowel[vowelIdx]++;
                 results->vowelPresence[vowelIdx] = true;
             }
@@ -680,6 +903,232 @@ void process_char(UTF8Character character, TextPartialResult *results) {
     }
 }
 
+/**
+ * \brief Ends the current word, for the analyzers counting words.
+ *
+ * \param results A pointer to the TextPartialResult structure of the text.
+ * \param hooks The analyzers run with the vowel counts.
+ */
+void end_word(TextPartialResult *results, const AnalyzerHooks *hooks) {
+    for (int i = 0; i < hooks->nWordAnalyzers; i++) {
+        hooks->wordAnalyzers[i]->on_word(results->wordLength, &results->results);
+    }
+}
+
+/**
+ * \brief Reads the names of the analyzers given on the command line.
+ *
+ * \param names The names of the analyzers separated by commas, or all. The string is modified.
+ * \param flags Where the flags of the analyzers are written.
+ *
+ * \return true if every name is known, false otherwise.
+ */
+bool parse_analyzers(char *names, unsigned int *flags) {
+    char *name, *state;
+
+    *flags = 0;
+    for (name = strtok_r(names, ",", &state); name != NULL; name = strtok_r(NULL, ",", &state)) {
+        int i;
+        if (strcmp(name, "all") == 0) {
+            for (i = 0; i < TOTAL_ANALYZERS; i++) {
+                *flags |= analyzers[i].flag;
+            }
+            continue;
+        }
+        for (i = 0; i < TOTAL_ANALYZERS && strcmp(name, analyzers[i].name) != 0; i++) {
+        }
+        if (i == TOTAL_ANALYZERS) {
+            return false;
+        }
+        *flags |= analyzers[i].flag;
+    }
+    return true;
+}
+
+/**
+ * \brief Gets the analyzers of a selection with a hook, so the others are not called at all.
+ *
+ * \param flags The flags of the analyzers.
+ * \param hooks Where the analyzers are written.
+ */
+void select_hooks(unsigned int flags, AnalyzerHooks *hooks) {
+    hooks->nCharAnalyzers = hooks->nWordAnalyzers = 0;
+    for (int i = 0; i < TOTAL_ANALYZERS; i++) {
+        if ((flags & analyzers[i].flag) == 0) {
+            continue;
+        }
+        if (analyzers[i].on_char != NULL) {
+            hooks->charAnalyzers[hooks->nCharAnalyzers++] = &analyzers[i];
+        }
+        if (analyzers[i].on_word != NULL) {
+            hooks->wordAnalyzers[hooks->nWordAnalyzers++] = &analyzers[i];
+        }
+    }
+}
+
+/**
+ * \brief Selects the default analyzers, run with the vowel counts by process_chunk(), merged by reduce() and
+ *        printed by print_results(). The others are not called at all. Every process of a run must select the
+ *        same analyzers, before any analysis starts; text_stats_init() is given its own selection instead.
+ *
+ * \param flags The flags of the analyzers, 0 for the vowel counts only.
+ */
+void use_analyzers(unsigned int flags) {
+    defaultFlags = flags;
+    select_hooks(flags, &defaultHooks);
+}
+
+/**
+ * \brief Counts a word by its number of characters.
+ */
+void count_length(int length, TextResult *result) {
+    result->lengths.nWords[(length < MAX_WORD_LENGTH) ? length - 1 : MAX_WORD_LENGTH - 1]++;
+}
+
+/**
+ * \brief Merges the word lengths of two parts of a text.
+ */
+void reduce_lengths(TextResult *into, const TextResult *from) {
+    for (int i = 0; i < MAX_WORD_LENGTH; i++) {
+        into->lengths.nWords[i] += from->lengths.nWords[i];
+    }
+}
+
+/**
+ * \brief Prints the word lengths, the last one counting the longer words too.
+ */
+void print_lengths(FILE *fp, const TextResult *result) {
+    fprintf(fp, "N. of words with a length of:\n1");
+    for (int i = 1; i < MAX_WORD_LENGTH; i++) {
+        fprintf(fp, (i < MAX_WORD_LENGTH - 1) ? "\t%d" : "\t%d+", i + 1);
+    }
+    fprintf(fp, "\n%d", result->lengths.nWords[0]);
+    for (int i = 1; i < MAX_WORD_LENGTH; i++) {
+        fprintf(fp, "\t%d", result->lengths.nWords[i]);
+    }
+    fprintf(fp, "\n");
+}
+
+/**
+ * \brief Gets the letter of a character, without its accent.
+ *
+ * \param character The UTF8Character to analyze.
+ *
+ * \return The index of the letter from A, or -1 if the character is not a letter.
+ */
+int get_letter_idx(UTF8Character character) {
+    static const int vowelLetters[TOTAL_VOWELS] = {'A' - 'A', 'E' - 'A', 'I' - 'A', 'O' - 'A', 'U' - 'A', 'Y' - 'A'};
+
+    if (character.length == 1) {
+        if ('A' <= character.character[0] && character.character[0] <= 'Z')
+            return character.character[0] - 'A';
+        if ('a' <= character.character[0] && character.character[0] <= 'z')
+            return character.character[0] - 'a';
+        return -1;
+    }
+    int vowelIdx = get_vowel_idx(character);
+    if (vowelIdx != -1)
+        return vowelLetters[vowelIdx];
+    if (character.length == 2 && character.character[0] == 0xC3) {
+        if (character.character[1] == 0x87 || character.character[1] == 0xA7) // C with cedilla
+            return 'C' - 'A';
+        if (character.character[1] == 0x91 || character.character[1] == 0xB1) // N with tilde
+            return 'N' - 'A';
+    }
+    return -1;
+}
+
+/**
+ * \brief Counts the letter of a character.
+ */
+void count_letter(UTF8Character character, bool afterWord, TextResult *result) {
+    int letterIdx = get_letter_idx(character);
+
+    (void) afterWord;
+    if (letterIdx >= 0) {
+        result->letters.nLetters[letterIdx]++;
+    }
+}
+
+/**
+ * \brief Merges the letters of two parts of a text.
+ */
+void reduce_letters(TextResult *into, const TextResult *from) {
+    for (int i = 0; i < TOTAL_LETTERS; i++) {
+        into->letters.nLetters[i] += from->letters.nLetters[i];
+    }
+}
+
+/**
+ * \brief Prints the occurrences of every letter.
+ */
+void print_letters(FILE *fp, const TextResult *result) {
+    fprintf(fp, "N. of letters:\nA");
+    for (int i = 1; i < TOTAL_LETTERS; i++) {
+        fprintf(fp, "\t%c", 'A' + i);
+    }
+    fprintf(fp, "\n%d", result->letters.nLetters[0]);
+    for (int i = 1; i < TOTAL_LETTERS; i++) {
+        fprintf(fp, "\t%d", result->letters.nLetters[i]);
+    }
+    fprintf(fp, "\n");
+}
+
+/**
+ * \brief Counts a sentence at a full point, exclamation mark, question mark or ellipsis right after a word,
+ *        so "?!" or "..." end a single sentence. A chunk never ends with a word character, so a sentence is
+ *        counted by the chunk of its word.
+ */
+void count_sentence(UTF8Character character, bool afterWord, TextResult *result) {
+    if (!afterWord) {
+        return;
+    }
+    if ((character.length == 1 && (character.character[0] == 0x2E || character.character[0] == 0x21 ||
+                                   character.character[0] == 0x3F)) ||
+        (character.length == 3 && character.character[0] == 0xE2 && character.character[1] == 0x80 &&
+         character.character[2] == 0xA6)) {
+        result->sentences.nSentences++;
+    }
+}
+
+/**
+ * \brief Merges the sentences of two parts of a text.
+ */
+void reduce_sentences(TextResult *into, const TextResult *from) {
+    into->sentences.nSentences += from->sentences.nSentences;
+}
+
+/**
+ * \brief Prints the number of sentences.
+ */
+void print_sentences(FILE *fp, const TextResult *result) {
+    fprintf(fp, "Total number of sentences = %d\n", result->sentences.nSentences);
+}
+
+/**
+ * \brief Adds a word to the average word length.
+ */
+void count_average(int length, TextResult *result) {
+    result->average.nWords++;
+    result->average.nCharacters += length;
+}
+
+/**
+ * \brief Merges the average word lengths of two parts of a text.
+ */
+void reduce_average(TextResult *into, const TextResult *from) {
+    into->average.nWords += from->average.nWords;
+    into->average.nCharacters += from->average.nCharacters;
+}
+
+/**
+ * \brief Prints the average word length, in characters.
+ */
+void print_average(FILE *fp, const TextResult *result) {
+    fprintf(fp, "Average word length = %.2f\n",
+            (result->average.nWords > 0) ? (double) result->average.nCharacters / result->average.nWords : 0.0);
+}
+
 /**
  * \brief Reads data from a file and returns a Chunk structure containing the bytes read.
  *
@@ -762,83 +1211,3 @@ Chunk get_chunk(FILE *fp, int maxChunkBytes) {
     }
     return chunk;
 }
-
-/**
- *  \brief Get the process time that has elapsed since last call of this time.
- *
- *  \return process elapsed time
- */
-double get_delta_time(void)
-{
-    static struct timespec t0, t1;
-
-    t0 = t1;
-    if (clock_gettime(CLOCK_MONOTONIC, &t1) != 0)
-    {
-        perror("clock_gettime");
-        exit(1);
-    }
-    return (double)(t1.tv_sec - t0.tv_sec) + 1.0e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
-}
-
-/**
- *  \brief Get the size of a file in bytes.
- *
- *  \param path The path to the file to be checked.
- *  \return The size of the file in bytes as a long integer.
- */
-long get_file_size(char *path)
-{
-    FILE *fp;
-    long size;
-    fp = fopen(path, "rb");
-    fseek(fp, 0L, SEEK_END);
-    size = ftell(fp);
-    fseek(fp, 0L, SEEK_SET);
-    fclose(fp);
-    return size;
-}
-
-/**
- *  \brief Check if a file can be opened for reading.
- *
- *  \param path The name of the file to be checked.
- *  \return true if the file can be opened for reading, false otherwise.
- */
-bool is_file_open(char *path)
-{
-    FILE *fp = fopen(path, "rb");
-    if (NULL == fp)
-    {
-        return false;
-    }
-    fclose(fp);
-    return true;
-}
-
-/**
- *  \brief Get an array of worker ranks for a given number of processes and a rank of a dispatcher process.
- *
- *  \param size The total number of processes in the job.
- *  \param rank_dispatcher The rank of the dispatcher process.
- *  \return A dynamically allocated integer array containing the ranks of all worker processes.
- *          This array must be freed by the caller after use.
- */
-int *get_workers(int size, int rank_dispatcher)
-{
-    int *workers;
-    if((workers = (int *)malloc((size-1) * sizeof(int))) == NULL)
-    {
-        fprintf(stderr, "get_workers(): error while allocating memory in array structure");
-        exit(EXIT_FAILURE);
-    }
-    int head = 0;
-    for(int i = 0; i < size; i++)
-    {
-        if(i != rank_dispatcher)
-        {
-            workers[head++] = i;
-        }
-    }
-    return workers;
-}
\ No newline at end of file
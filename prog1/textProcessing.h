@@ -7,9 +7,6 @@
 #include <time.h>
 #include <math.h>
 
-/** \brief maximum number of bytes per chunk */
-#define MAX_CHUNK_BYTES 8000
-
 #define MAX_UTF8_CHAR_SIZE 4
 
 /** \brief define the total number of vowels */
@@ -28,29 +25,82 @@
 /** \brief Y vowel index */
 #define Y_IDX 5
 
+/** \brief longest word length counted on its own, longer words are counted with it */
+#define MAX_WORD_LENGTH 20
+
+/** \brief define the total number of letters, A to Z */
+#define TOTAL_LETTERS 26
+
+/** \brief analyzers run in the same pass as the vowel counts, selected with use_analyzers() */
+#define ANALYZER_LENGTHS   0x1
+#define ANALYZER_LETTERS   0x2
+#define ANALYZER_SENTENCES 0x4
+#define ANALYZER_AVERAGE   0x8
+
+/** \brief result of the word length analyzer: words per number of characters, from 1 */
+typedef struct LengthResult
+{
+    int nWords[MAX_WORD_LENGTH];
+} LengthResult;
+
+/** \brief result of the letter analyzer: occurrences of every letter, accents ignored */
+typedef struct LetterResult
+{
+    int nLetters[TOTAL_LETTERS];
+} LetterResult;
+
+/** \brief result of the sentence analyzer */
+typedef struct SentenceResult
+{
+    int nSentences;
+} SentenceResult;
+
+/** \brief result of the average word length analyzer */
+typedef struct AverageResult
+{
+    int nWords;
+    int nCharacters;
+} AverageResult;
+
 typedef struct TextResult
 {
     int nWords;
     int nWordsVowel[TOTAL_VOWELS];
+    LengthResult lengths;       /* results of the analyzers, only kept up to date when selected */
+    LetterResult letters;
+    SentenceResult sentences;
+    AverageResult average;
 
 } TextResult;
 
-typedef struct Chunk
+/** \brief state of the analysis at a given point of a text */
+typedef struct TextPartialResult
+{
+    TextResult results;
+    bool inWord;
+    int wordLength;     /* characters of the current word */
+    bool vowelPresence[TOTAL_VOWELS];
+} TextPartialResult;
+
+/** \brief incremental analysis of a text fed in spans cut at any byte */
+typedef struct TextStats
 {
-    int length;
-    int position;
-    unsigned char bytes[MAX_CHUNK_BYTES];
-} Chunk;
+    TextPartialResult state;
+    unsigned int analyzers;     /* flags of the analyzers run with the vowel counts */
+    unsigned char pending[MAX_UTF8_CHAR_SIZE];  /* first bytes of a character cut by the end of a span */
+    int nPending;
+    bool failed;        /* the text is not valid UTF-8 */
+} TextStats;
 
 extern TextResult get_initial_result();
-extern Chunk get_chunk(FILE *fp, int maxChunkBytes);
-extern TextResult process_chunk(Chunk chunk);
 extern TextResult reduce(TextResult result01, TextResult result02);
+extern TextResult reduce_analyzers(TextResult result01, TextResult result02, unsigned int flags);
+extern void text_stats_init(TextStats *stats, unsigned int flags);
+extern bool text_stats_feed(TextStats *stats, const unsigned char *bytes, size_t length);
+extern bool text_stats_finish(TextStats *stats, TextResult *result);
 extern void print_results(char *path, TextResult results);
-
-long get_file_size(char *path);
-bool is_file_open(char *path);
-double get_delta_time(void);
-int *get_workers(int size, int rank_dispatcher);
+extern void fprint_results(FILE *fp, char *path, TextResult results);
+extern bool parse_analyzers(char *names, unsigned int *flags);
+extern void use_analyzers(unsigned int flags);
 
 #endif /* TEXT_PROCESSING_H */
@@ -0,0 +1,132 @@
+/**
+ *  \file argsort.c (definition file)
+ *  \brief (key, index) pairs used to compute the sorting permutation of a list.
+ *
+ *  Every element is packed with its position in the input list into a 16-byte record, whose 64-bit key
+ *  orders the pairs as the elements: integer keys are widened, and the bits of floating point keys are
+ *  mapped to integers of the same order. The pairs are then sorted by the record engine and exchanged as
+ *  any other record, and the permutation is read back from the payloads of the sorted pairs.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+
+#include "argsort.h"
+
+/**
+ * \brief Maps the key of an element to a 64-bit integer of the same order.
+ *
+ * \param typeId The element type (one of TYPE_*).
+ * \param element The element.
+ *
+ * \return the integer key.
+ */
+static int64_t encode_key(int typeId, const void *element) {
+    int32_t bits32;
+    int64_t bits64;
+
+    switch (typeId) {
+        case TYPE_INT32:
+            memcpy(&bits32, element, sizeof(bits32));
+            return bits32;
+        case TYPE_FLOAT: /* negative numbers get their magnitude bits flipped, so they order backwards */
+            memcpy(&bits32, element, sizeof(bits32));
+            return bits32 ^ ((bits32 >> 31) & INT32_MAX);
+        case TYPE_DOUBLE:
+            memcpy(&bits64, element, sizeof(bits64));
+            return bits64 ^ ((bits64 >> 63) & INT64_MAX);
+        default: /* 64-bit integers and the keys of the records */
+            memcpy(&bits64, element, sizeof(bits64));
+            return bits64;
+    }
+}
+
+/**
+ * \brief Restores the key of an element from its integer key (records get only their key back).
+ *
+ * \param typeId The element type (one of TYPE_*).
+ * \param key The integer key.
+ * \param element The element where the key is written.
+ */
+static void decode_key(int typeId, int64_t key, void *element) {
+    int32_t bits32;
+
+    switch (typeId) {
+        case TYPE_INT32:
+            bits32 = (int32_t) key;
+            memcpy(element, &bits32, sizeof(bits32));
+            break;
+        case TYPE_FLOAT:
+            bits32 = (int32_t) key;
+            bits32 ^= (bits32 >> 31) & INT32_MAX;
+            memcpy(element, &bits32, sizeof(bits32));
+            break;
+        case TYPE_DOUBLE:
+            key ^= (key >> 63) & INT64_MAX;
+            memcpy(element, &key, sizeof(key));
+            break;
+        default:
+            memcpy(element, &key, sizeof(key));
+            break;
+    }
+}
+
+/**
+ * \brief Packs every element of a list with its position in the input list.
+ *
+ * The pairs may be written over the list itself, if it has room for them: elements smaller than a pair
+ * are packed from the back and larger ones from the front, so no element is overwritten before it is
+ * read.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param list The elements.
+ * \param length The number of elements.
+ * \param firstIndex The position of the first element in the input list.
+ * \param pairs The pairs, in the order of the elements.
+ */
+void make_index_pairs(int typeId, void *list, long length, long firstIndex, Record16 *pairs) {
+    size_t size = get_sort_type(typeId)->size;
+    const char *elements = (const char *) list;
+
+    if (size <= sizeof(Record16)) {
+        for (long i = length - 1; i >= 0; i--) {
+            Record16 pair;
+            int64_t index = firstIndex + i;
+            pair.key = encode_key(typeId, elements + i * size);
+            memcpy(pair.payload, &index, sizeof(index));
+            pairs[i] = pair;
+        }
+    } else {
+        for (long i = 0; i < length; i++) {
+            Record16 pair;
+            int64_t index = firstIndex + i;
+            pair.key = encode_key(typeId, elements + i * size);
+            memcpy(pair.payload, &index, sizeof(index));
+            pairs[i] = pair;
+        }
+    }
+}
+
+/**
+ * \brief Unpacks the keys and the positions in the input list of sorted pairs.
+ *
+ * \param typeId The element type of the input list (one of TYPE_*). Records get only their key back.
+ * \param pairs The pairs.
+ * \param length The number of pairs.
+ * \param keys Where the keys are written as elements of the input type, or NULL.
+ * \param indices Where the positions in the input list are written, or NULL.
+ */
+void split_index_pairs(int typeId, const Record16 *pairs, long length, void *keys, int64_t *indices) {
+    size_t size = get_sort_type(typeId)->size;
+
+    for (long i = 0; i < length; i++) {
+        if (keys != NULL) {
+            decode_key(typeId, pairs[i].key, (char *) keys + i * size);
+        }
+        if (indices != NULL) {
+            memcpy(&indices[i], pairs[i].payload, sizeof(int64_t));
+        }
+    }
+}
@@ -0,0 +1,19 @@
+/**
+ *  \file argsort.h (definition file)
+ *  \brief Header file containing the declarations for the (key, index) pairs used to compute the sorting
+ *  permutation of a list.
+ */
+#ifndef ARGSORT_H
+#define ARGSORT_H
+
+#include <stdint.h>
+
+#include "sorting.h"
+
+/** \brief element type of the (key, index) pairs: the key in the key field, the index in the payload */
+#define TYPE_PAIR TYPE_REC16
+
+extern void make_index_pairs(int typeId, void *list, long length, long firstIndex, Record16 *pairs);
+extern void split_index_pairs(int typeId, const Record16 *pairs, long length, void *keys, int64_t *indices);
+
+#endif /* ARGSORT_H */
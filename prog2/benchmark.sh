@@ -0,0 +1,136 @@
+#!/bin/sh
+#
+#  Benchmark suite of prog2.
+#
+#  Generates the input lists with genList and runs prog2 over every combination of list size, key
+#  distribution, algorithm and number of processes, repeating every run and keeping the fastest one.
+#  One CSV row is written per combination, with the throughput, the strong and weak scaling efficiency
+#  and the time of every phase (load, sort, store, verify).
+#
+#  Every algorithm is also run by the threads-only build (prog2_threads, "make threads") with as many
+#  threads as the MPI run has processes, reported as <algorithm>-threads: the baseline of a single node.
+#
+#  Strong scaling efficiency of a run with P processes: T(n, 1) / (P * T(n, P)).
+#  Weak scaling efficiency of a run with P processes: T(n / P, 1) / T(n, P).
+#  Efficiencies are left empty when the reference run is not part of the benchmark.
+#
+#  Every setting can be overridden from the environment, e.g.
+#      SIZES="20 24 28" PROCESSES="1 2 4 8" ALGORITHMS=sample ./benchmark.sh
+#
+#  Author:  Renan Ferreira
+#           João Reis
+
+SIZES=${SIZES:-"10 12 14 16 18 20"}                  # list sizes, as powers of 2 (up to 30, 32 for external)
+DISTRIBUTIONS=${DISTRIBUTIONS:-"uniform sorted reverse equal few zipf sawtooth"}
+ALGORITHMS=${ALGORITHMS:-"bitonic sample"}           # external needs MEMORY and SCRATCH
+PROCESSES=${PROCESSES:-"1 2 4 8"}
+TYPE=${TYPE:-int32}
+THREADS=${THREADS:-1}
+SEGMENTS=${SEGMENTS:-1}
+REPEAT=${REPEAT:-3}
+MEMORY=${MEMORY:-512}                                # memory budget of the external sort, in MiB
+SCRATCH=${SCRATCH:-/tmp}
+DATA_DIR=${DATA_DIR:-bench-data}
+OUTPUT=${OUTPUT:-benchmark.csv}
+MPIRUN=${MPIRUN:-mpirun}
+ENGINES=${ENGINES:-"mpi threads"}                    # threads: the threads-only build, as a baseline
+
+RAW=$(mktemp)
+trap 'rm -f "$RAW"' EXIT
+
+mkdir -p "$DATA_DIR" || exit 1
+
+for size in $SIZES; do
+    for dist in $DISTRIBUTIONS; do
+        file="$DATA_DIR/$TYPE-$dist-$size.bin"
+        for alg in $ALGORITHMS; do
+            for engine in $ENGINES; do
+                if [ "$engine" = threads ] && [ "$alg" = external ]; then
+                    continue
+                fi
+                if [ "$alg" != external ] && [ "$size" -gt 30 ]; then # in-memory lists are at most INT_MAX long
+                    continue
+                fi
+                if [ ! -f "$file" ]; then
+                    ./genList -e "$size" -d "$dist" -t "$TYPE" -o "$file" || exit 1
+                fi
+                for np in $PROCESSES; do
+                    best=""
+                    status=ok
+                    run=0
+                    while [ $run -lt "$REPEAT" ]; do
+                        if [ "$engine" = threads ]; then
+                            out=$(./prog2_threads -v -a "$alg" -t $((np * THREADS)) -o "$DATA_DIR/sorted.bin" \
+                                  -f "$file" 2>&1)
+                        else
+                            out=$($MPIRUN -np "$np" ./prog2 -v -a "$alg" -t "$THREADS" -n "$SEGMENTS" -m "$MEMORY" \
+                                  -s "$SCRATCH" -o "$DATA_DIR/sorted.bin" -f "$file" 2>&1)
+                        fi
+                        if ! echo "$out" | grep -q "Everything is ok!"; then
+                            status=fail
+                            break
+                        fi
+                        # elapsed, load, sort, store, verify
+                        times=$(echo "$out" | awk '/^Elapsed time/ { e = $(NF - 1) }
+                                                   /^phase/ { p[$2] = $(NF - 1) }
+                                                   END { split("load sort store verify", names)
+                                                         printf "%s", e
+                                                         for (i = 1; i <= 4; i++) {
+                                                             printf " %s", (names[i] in p) ? p[names[i]] : "-"
+                                                         }
+                                                         printf "\n" }')
+                        set -- $times
+                        if [ -z "$best" ] || awk "BEGIN { exit !($1 < $best) }"; then
+                            best=$1
+                            phases="$2 $3 $4 $5"
+                        fi
+                        run=$((run + 1))
+                    done
+                    name=$alg
+                    if [ "$engine" = threads ]; then
+                        name="$alg-threads"
+                    fi
+                    if [ "$status" = ok ] && [ -n "$best" ]; then
+                        echo "$name $dist $size $np $best $phases ok" >> "$RAW"
+                    else
+                        echo "$name $dist $size $np - - - - - fail" >> "$RAW"
+                    fi
+                done
+            done
+        done
+    done
+done
+rm -f "$DATA_DIR/sorted.bin"
+
+awk -v type="$TYPE" -v threads="$THREADS" -v segments="$SEGMENTS" '
+    { for (f = 6; f <= 9; f++) { if ($f == "-") $f = "" } # phases not reported by the algorithm
+      alg[NR] = $1; dist[NR] = $2; size[NR] = $3; np[NR] = $4; t[NR] = $5
+      load[NR] = $6; sort[NR] = $7; store[NR] = $8; verify[NR] = $9; status[NR] = $10
+      if ($10 == "ok") { ref[$1 " " $2 " " $3 " " $4] = $5 } }
+    END {
+        print "algorithm,distribution,type,elements,processes,threads,segments,seconds,keys_per_second," \
+              "strong_efficiency,weak_efficiency,load_seconds,sort_seconds,store_seconds,verify_seconds,status"
+        for (i = 1; i <= NR; i++) {
+            n = 2 ^ size[i]
+            if (status[i] != "ok") {
+                printf "%s,%s,%s,%.0f,%d,%d,%d,,,,,,,,,%s\n", alg[i], dist[i], type, n, np[i], threads, segments,
+                       status[i]
+                continue
+            }
+            strong = ""; weak = ""
+            key = alg[i] " " dist[i] " " size[i] " 1"
+            if ((key in ref) && t[i] > 0) {
+                strong = sprintf("%.4f", ref[key] / (np[i] * t[i]))
+            }
+            shift = log(np[i]) / log(2)
+            key = alg[i] " " dist[i] " " (size[i] - shift) " 1"
+            if ((key in ref) && t[i] > 0) {
+                weak = sprintf("%.4f", ref[key] / t[i])
+            }
+            printf "%s,%s,%s,%.0f,%d,%d,%d,%s,%.0f,%s,%s,%s,%s,%s,%s,%s\n", alg[i], dist[i], type, n, np[i],
+                   threads, segments, t[i], (t[i] > 0) ? n / t[i] : 0, strong, weak, load[i], sort[i], store[i],
+                   verify[i], status[i]
+        }
+    }' "$RAW" > "$OUTPUT"
+
+echo "results written to $OUTPUT"
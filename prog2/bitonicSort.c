@@ -0,0 +1,281 @@
+/**
+ *  \file bitonicSort.c (definition file)
+ *  \brief Distributed Bitonic Sort Algorithm Implementation.
+ *
+ *  Every process sorts its block, then the processes run the bitonic network with whole blocks as
+ *  elements: at each step a process exchanges its block with a partner and keeps either the lower or the
+ *  upper half of the merge of both blocks (compare-split). Every process takes part in every merge stage,
+ *  so no stage is left to a single process.
+ *
+ *  The blocks can be transferred in segments, so that sorting or merging the segments already received
+ *  overlaps the transfer of the next ones. Segments of sorted integer keys above a size threshold are sent
+ *  delta encoded and bit-packed (see wireCodec.c); encoding the next segment overlaps the transfer of the
+ *  previous one.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+
+#include "bitonicSort.h"
+#include "listIO.h"
+#include "trace.h"
+#include "wireCodec.h"
+
+/**
+ * \brief Computes the range of a segment of a block, in the order in which the receiver consumes them.
+ *
+ * A process keeping the lower half of a compare-split consumes the partner block from the front, a process
+ * keeping the upper half consumes it from the back.
+ *
+ * \param blockLength The number of elements of the block.
+ * \param nSegments The number of segments of the block.
+ * \param segment The position of the segment in the consumption order.
+ * \param fromFront Whether the block is consumed from the front.
+ * \param offset Position of the first element of the segment in the block.
+ * \param count Number of elements of the segment.
+ */
+static void get_segment_range(int blockLength, int nSegments, int segment, bool fromFront, int *offset,
+                              int *count) {
+    int first, end;
+
+    get_block_range(blockLength, nSegments, segment, &first, count);
+    end = first + *count;
+    *offset = fromFront ? first : blockLength - end;
+}
+
+/**
+ * \brief Scatters the blocks of a list from the root process and sorts them as their segments arrive.
+ *
+ * Every process of the communicator must call this function. The root (rank 0) keeps its block in place
+ * at the head of the list. Every segment is sorted as soon as it is received, while the next ones are in
+ * flight, and the sorted segments are merged at the end.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param list The whole list (significant only at the root).
+ * \param block The block of this process (the head of the list at the root).
+ * \param blockLength The number of elements of every block.
+ * \param nSegments The number of segments of every block.
+ * \param pool The thread pool used to sort the segments, or NULL to sort them with the calling thread only.
+ * \param comm The communicator of the processes sharing the list.
+ */
+void scatter_sorted_blocks(int typeId, const void *list, void *block, int blockLength, int nSegments,
+                           ThreadPool *pool, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    MPI_Datatype datatype = get_mpi_datatype(typeId);
+    size_t size = type->size;
+    int rank, nProcesses;
+    int *counts = NULL, *displs = NULL, *runOffsets = NULL;
+    MPI_Request *requests = NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    if (nSegments > blockLength) {
+        nSegments = (blockLength > 0) ? blockLength : 1;
+    }
+    if (((counts = (int *) malloc((size_t) nSegments * nProcesses * sizeof(int))) == NULL) ||
+        ((displs = (int *) malloc((size_t) nSegments * nProcesses * sizeof(int))) == NULL) ||
+        ((runOffsets = (int *) malloc(nSegments * sizeof(int))) == NULL) ||
+        ((requests = (MPI_Request *) malloc(nSegments * sizeof(MPI_Request))) == NULL)) {
+        fprintf(stderr, "scatter_sorted_blocks(): error while allocating memory for the segments\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+
+    int event = trace_begin("scatter and sort segments");
+    /* the count and displacement arrays must live until their scatter completes */
+    for (int s = 0; s < nSegments; s++) {
+        int offset, count;
+        get_segment_range(blockLength, nSegments, s, true, &offset, &count);
+        runOffsets[s] = offset;
+        for (int i = 0; i < nProcesses; i++) {
+            counts[s * nProcesses + i] = count;
+            displs[s * nProcesses + i] = i * blockLength + offset;
+        }
+        MPI_Iscatterv(list, counts + s * nProcesses, displs + s * nProcesses, datatype,
+                      (rank == 0) ? MPI_IN_PLACE : (char *) block + (size_t) offset * size, count, datatype, 0,
+                      comm, &requests[s]);
+    }
+    for (int s = 0; s < nSegments; s++) {
+        MPI_Wait(&requests[s], MPI_STATUS_IGNORE);
+        type->bitonic_sort_mt((char *) block + (size_t) runOffsets[s] * size, counts[s * nProcesses], true,
+                              pool);
+    }
+    trace_end(event);
+    event = trace_begin("merge segments");
+    if (!type->merge_runs(block, blockLength, runOffsets, nSegments)) {
+        fprintf(stderr, "scatter_sorted_blocks(): error while allocating memory for the merge of the segments\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    trace_end(event);
+
+    free(requests);
+    free(runOffsets);
+    free(displs);
+    free(counts);
+}
+
+/**
+ * \brief Merges a list distributed in sorted blocks of the same length over a power of two number of
+ * processes.
+ *
+ * Every process of the communicator must call this function. On return, the blocks hold the sorted list
+ * in rank order.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The sorted block of the list held by this process, merged in place.
+ * \param blockLength The number of elements of every block.
+ * \param nSegments The number of segments in which the blocks are exchanged (1 for a single message).
+ * \param compressThreshold The size of a segment from which it is sent encoded, in bytes (0 to never encode).
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return true on success, false on every process if any of them cannot allocate its partner block or its
+ *         encoded segments; the blocks are then left as they were.
+ */
+bool bitonic_merge_distributed(int typeId, void *block, int blockLength, int nSegments,
+                               size_t compressThreshold, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    MPI_Datatype datatype = get_mpi_datatype(typeId);
+    size_t size = type->size;
+    int rank, nProcesses;
+    char *partnerBlock, *merged, *current = (char *) block;
+    unsigned char *sendCoded = NULL, *recvCoded = NULL;
+    size_t *slots;
+    MPI_Request *requests;
+    bool allocated;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    if (nProcesses == 1) {
+        return true;
+    }
+    if (nSegments > blockLength) {
+        nSegments = (blockLength > 0) ? blockLength : 1;
+    }
+    partnerBlock = (char *) malloc(blockLength > 0 ? blockLength * size : 1);
+    merged = (char *) malloc(blockLength > 0 ? blockLength * size : 1);
+    requests = (MPI_Request *) malloc(2 * nSegments * sizeof(MPI_Request));
+    slots = (size_t *) malloc((nSegments + 1) * sizeof(size_t));
+    allocated = partnerBlock != NULL && merged != NULL && requests != NULL && slots != NULL;
+    if (allocated) {
+        /* every encoded segment has a slot of the largest encoded size in the buffers (0 if sent as it is) */
+        slots[0] = 0;
+        for (int s = 0; s < nSegments; s++) {
+            int offset, count;
+            get_segment_range(blockLength, nSegments, s, true, &offset, &count);
+            slots[s + 1] = slots[s] + (use_codec(typeId, count, compressThreshold) ? get_codec_bound(count) : 0);
+        }
+        if (slots[nSegments] > 0) {
+            sendCoded = (unsigned char *) malloc(slots[nSegments]);
+            recvCoded = (unsigned char *) malloc(slots[nSegments]);
+            allocated = sendCoded != NULL && recvCoded != NULL;
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &allocated, 1, MPI_C_BOOL, MPI_LAND, comm);
+    if (!allocated) {
+        free(recvCoded);
+        free(sendCoded);
+        free(slots);
+        free(requests);
+        free(merged);
+        free(partnerBlock);
+        return false;
+    }
+
+    /* merge stages: compare-split with the partner across the given bit of the rank */
+    for (int stage = 1; (1 << stage) <= nProcesses; stage++) {
+        bool asc = ((rank >> stage) & 1) == 0;
+        for (int bit = stage - 1; bit >= 0; bit--) {
+            int partner = rank ^ (1 << bit);
+            bool low = (rank < partner) == asc;
+            SplitCursor cursor = {0, 0, 0};
+            char name[TRACE_NAME_LENGTH];
+            int event = -1;
+
+            if (traceEnabled) {
+                snprintf(name, sizeof(name), "compare-split stage %d bit %d", stage, bit);
+                event = trace_begin(name);
+            }
+
+            /* the partner consumes this block from the opposite end */
+            for (int s = 0; s < nSegments; s++) {
+                int offset, count;
+                get_segment_range(blockLength, nSegments, s, low, &offset, &count);
+                if (slots[s + 1] > slots[s]) {
+                    MPI_Irecv(recvCoded + slots[s], (int) (slots[s + 1] - slots[s]), MPI_BYTE, partner, s, comm,
+                              &requests[s]);
+                } else {
+                    MPI_Irecv(partnerBlock + (size_t) offset * size, count, datatype, partner, s, comm,
+                              &requests[s]);
+                }
+            }
+            for (int s = 0; s < nSegments; s++) {
+                int offset, count;
+                get_segment_range(blockLength, nSegments, s, !low, &offset, &count);
+                if (slots[s + 1] > slots[s]) {
+                    size_t bytes = encode_sorted_run(typeId, current + (size_t) offset * size, count,
+                                                     sendCoded + slots[s]);
+                    MPI_Isend(sendCoded + slots[s], (int) bytes, MPI_BYTE, partner, s, comm,
+                              &requests[nSegments + s]);
+                } else {
+                    MPI_Isend(current + (size_t) offset * size, count, datatype, partner, s, comm,
+                              &requests[nSegments + s]);
+                }
+            }
+            for (int s = 0, available = 0; s < nSegments; s++) {
+                int offset, count;
+                get_segment_range(blockLength, nSegments, s, low, &offset, &count);
+                available += count;
+                MPI_Wait(&requests[s], MPI_STATUS_IGNORE);
+                if (slots[s + 1] > slots[s]) {
+                    decode_sorted_run(typeId, recvCoded + slots[s], count, partnerBlock + (size_t) offset * size);
+                }
+                type->merge_split(current, partnerBlock, blockLength, available, merged, low, &cursor);
+            }
+            MPI_Waitall(nSegments, requests + nSegments, MPI_STATUSES_IGNORE);
+            trace_end(event);
+
+            char *swap = current;
+            current = merged;
+            merged = swap;
+        }
+    }
+
+    if (current != block) {
+        memcpy(block, current, (size_t) blockLength * size);
+        merged = current;
+    }
+    free(recvCoded);
+    free(sendCoded);
+    free(slots);
+    free(requests);
+    free(merged);
+    free(partnerBlock);
+    return true;
+}
+
+/**
+ * \brief Sorts a list distributed in blocks of the same length over a power of two number of processes.
+ *
+ * Every process of the communicator must call this function. On return, the blocks hold the sorted list
+ * in rank order.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The block of the list held by this process, sorted in place.
+ * \param blockLength The number of elements of every block.
+ * \param nSegments The number of segments in which the blocks are exchanged (1 for a single message).
+ * \param compressThreshold The size of a segment from which it is sent encoded, in bytes (0 to never encode).
+ * \param pool The thread pool used to sort the block, or NULL to sort it with the calling thread only.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return true on success, false on every process if any of them runs out of memory for the merge; the
+ *         blocks are then only sorted locally.
+ */
+bool bitonic_sort_distributed(int typeId, void *block, int blockLength, int nSegments,
+                              size_t compressThreshold, ThreadPool *pool, MPI_Comm comm) {
+    /* local sort */
+    int event = trace_begin("local sort");
+    get_sort_type(typeId)->bitonic_sort_mt(block, blockLength, true, pool);
+    trace_end(event);
+    return bitonic_merge_distributed(typeId, block, blockLength, nSegments, compressThreshold, comm);
+}
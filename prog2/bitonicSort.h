@@ -0,0 +1,19 @@
+/**
+ *  \file bitonicSort.h (definition file)
+ *  \brief Header file containing the declarations for the distributed bitonic sort algorithm.
+ */
+#ifndef BITONIC_SORT_H
+#define BITONIC_SORT_H
+
+#include <mpi.h>
+
+#include "sorting.h"
+
+extern void scatter_sorted_blocks(int typeId, const void *list, void *block, int blockLength, int nSegments,
+                                  ThreadPool *pool, MPI_Comm comm);
+extern bool bitonic_merge_distributed(int typeId, void *block, int blockLength, int nSegments,
+                                      size_t compressThreshold, MPI_Comm comm);
+extern bool bitonic_sort_distributed(int typeId, void *block, int blockLength, int nSegments,
+                                     size_t compressThreshold, ThreadPool *pool, MPI_Comm comm);
+
+#endif /* BITONIC_SORT_H */
@@ -0,0 +1,447 @@
+/**
+ *  \file externalSort.c (definition file)
+ *  \brief Out-of-core sort of list files larger than the memory of the processes.
+ *
+ *  1 - Every process samples keys from its part of the input file and the splitters are chosen from them,
+ *      so every process owns one key range.
+ *
+ *  2 - Run formation: in every round each process reads as many elements as fit in its memory budget,
+ *      sorts them and sends every element to the owner of its key range. The merged elements received
+ *      are spilled as a sorted run to the scratch directory of the process; a process receiving more
+ *      than a run in a round, when the keys are skewed, gets them over several exchanges and runs.
+ *
+ *  3 - Every process merges its runs through bounded buffers and streams the result to its position in
+ *      the output file. At most MERGE_FAN_IN runs are merged at once, so the files open stay few and the
+ *      windows large: while there are more, the oldest ones are first merged into larger runs.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "externalSort.h"
+#include "sampleSort.h"
+#include "verifyList.h"
+#include "trace.h"
+
+/**
+ * \brief Builds the path of a run file in the scratch directory.
+ *
+ * \param buffer Buffer where the path is written.
+ * \param size The size of the buffer.
+ * \param scratchDir The scratch directory.
+ * \param rank The rank of the process owning the run.
+ * \param run The index of the run.
+ */
+static void get_run_path(char *buffer, size_t size, char *scratchDir, int rank, int run) {
+    snprintf(buffer, size, "%s/prog2-%d-%d-%d.run", scratchDir, (int) getpid(), rank, run);
+}
+
+/**
+ * \brief Bounds the number of elements of a buffer taken from the memory budget, so a budget larger than the
+ *        elements to hold does not allocate more than them and the counts fit in an int.
+ *
+ * \param capacity The number of elements that fit in the budget.
+ * \param limit The number of elements the buffer holds at most.
+ *
+ * \return the number of elements of the buffer, at least 1.
+ */
+static size_t clamp_capacity(size_t capacity, long limit) {
+    if (capacity < MIN_BUFFER_ELEMENTS) {
+        capacity = MIN_BUFFER_ELEMENTS;
+    }
+    if (limit < 1) {
+        limit = 1;
+    }
+    if (capacity > (size_t) limit) {
+        capacity = (size_t) limit;
+    }
+    return (capacity > INT_MAX) ? INT_MAX : capacity;
+}
+
+/**
+ * \brief Allocates a buffer, aborting every process on failure.
+ *
+ * \param size The number of bytes.
+ * \param comm The communicator to abort.
+ *
+ * \return the buffer.
+ */
+static void *alloc_buffer(size_t size, MPI_Comm comm) {
+    void *buffer;
+
+    if ((buffer = malloc(size > 0 ? size : 1)) == NULL) {
+        fprintf(stderr, "external_sort(): error while allocating memory for the buffers\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    return buffer;
+}
+
+/**
+ * \brief Records the length of a new run, growing the table of the run lengths when it is full.
+ *
+ * \param runLengths The table of the run lengths.
+ * \param runSlots The number of runs the table holds.
+ * \param nRuns The number of runs, increased by the new one.
+ * \param length The number of elements of the new run.
+ * \param comm The communicator to abort.
+ */
+static void add_run(long **runLengths, int *runSlots, int *nRuns, long length, MPI_Comm comm) {
+    if (*nRuns == *runSlots) {
+        *runSlots *= 2;
+        if ((*runLengths = (long *) realloc(*runLengths, *runSlots * sizeof(long))) == NULL) {
+            fprintf(stderr, "external_sort(): error while allocating memory for the runs\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    (*runLengths)[(*nRuns)++] = length;
+}
+
+/**
+ * \brief Opens consecutive runs of this process for a merge, each one with its window.
+ *
+ * \param scratchDir The scratch directory.
+ * \param rank The rank of the process owning the runs.
+ * \param firstRun The index of the first run.
+ * \param nMerged The number of runs.
+ * \param capacity The number of elements of every window.
+ * \param size The size of an element.
+ * \param runs Where the files of the runs are written.
+ * \param cursors Where the windows of the runs are written.
+ * \param comm The communicator to abort.
+ */
+static void open_runs(char *scratchDir, int rank, int firstRun, int nMerged, size_t capacity, size_t size,
+                      FILE **runs, RunCursor *cursors, MPI_Comm comm) {
+    char runPath[4096];
+
+    for (int r = 0; r < nMerged; r++) {
+        get_run_path(runPath, sizeof(runPath), scratchDir, rank, firstRun + r);
+        if ((runs[r] = fopen(runPath, "rb")) == NULL) {
+            fprintf(stderr, "Error while opening run file %s\n", runPath);
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        cursors[r].buffer = alloc_buffer(capacity * size, comm);
+        cursors[r].length = 0;
+        cursors[r].position = 0;
+    }
+}
+
+/**
+ * \brief Refills the windows of a merge that were used up, and closes the runs read to their end.
+ *
+ * \param runs The files of the runs, NULL once closed.
+ * \param cursors The windows of the runs.
+ * \param nMerged The number of runs.
+ * \param capacity The number of elements of every window.
+ * \param size The size of an element.
+ *
+ * \return true while any run has elements left.
+ */
+static bool refill_runs(FILE **runs, RunCursor *cursors, int nMerged, size_t capacity, size_t size) {
+    bool active = false;
+
+    for (int r = 0; r < nMerged; r++) {
+        if (cursors[r].position == cursors[r].length && runs[r] != NULL) {
+            cursors[r].length = fread(cursors[r].buffer, size, capacity, runs[r]);
+            cursors[r].position = 0;
+            if (cursors[r].length == 0) {
+                fclose(runs[r]);
+                runs[r] = NULL;
+            }
+        }
+        active = active || (cursors[r].position < cursors[r].length);
+    }
+    return active;
+}
+
+/**
+ * \brief Frees the windows of merged runs and removes their files.
+ *
+ * \param scratchDir The scratch directory.
+ * \param rank The rank of the process owning the runs.
+ * \param firstRun The index of the first run.
+ * \param nMerged The number of runs.
+ * \param cursors The windows of the runs.
+ */
+static void remove_runs(char *scratchDir, int rank, int firstRun, int nMerged, RunCursor *cursors) {
+    char runPath[4096];
+
+    for (int r = 0; r < nMerged; r++) {
+        free(cursors[r].buffer);
+        get_run_path(runPath, sizeof(runPath), scratchDir, rank, firstRun + r);
+        remove(runPath);
+    }
+}
+
+/**
+ * \brief Merges consecutive runs of this process into a new run, so that fewer runs are left to merge.
+ *
+ * \param type The element type of the runs.
+ * \param scratchDir The scratch directory.
+ * \param rank The rank of the process owning the runs.
+ * \param firstRun The index of the first run.
+ * \param nMerged The number of runs, up to MERGE_FAN_IN.
+ * \param newRun The index of the new run.
+ * \param length The number of elements of the runs.
+ * \param memoryBytes The memory budget of the process, in bytes.
+ * \param comm The communicator to abort.
+ */
+static void merge_run_group(const SortType *type, char *scratchDir, int rank, int firstRun, int nMerged, int newRun,
+                            long length, size_t memoryBytes, MPI_Comm comm) {
+    size_t size = type->size;
+    size_t capacity = clamp_capacity(memoryBytes / ((size_t) (nMerged + 1) * size), length);
+    RunCursor cursors[MERGE_FAN_IN];
+    FILE *runs[MERGE_FAN_IN], *fp;
+    char runPath[4096];
+    char *outBuffer = (char *) alloc_buffer(capacity * size, comm);
+
+    open_runs(scratchDir, rank, firstRun, nMerged, capacity, size, runs, cursors, comm);
+    get_run_path(runPath, sizeof(runPath), scratchDir, rank, newRun);
+    if ((fp = fopen(runPath, "wb")) == NULL) {
+        fprintf(stderr, "Error while writing run file %s\n", runPath);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    while (refill_runs(runs, cursors, nMerged, capacity, size)) {
+        long n = type->merge_cursors(cursors, nMerged, outBuffer, capacity);
+        if (n < 0) {
+            fprintf(stderr, "external_sort(): error while allocating memory for the merge of the runs\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        if (fwrite(outBuffer, size, n, fp) != (size_t) n) {
+            fprintf(stderr, "Error while writing run file %s\n", runPath);
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Error while writing run file %s\n", runPath);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    remove_runs(scratchDir, rank, firstRun, nMerged, cursors);
+    free(outBuffer);
+}
+
+/**
+ * \brief Sorts a list file into another list file using a bounded amount of memory per process.
+ *
+ * Every process of the communicator must call this function. The memory used by a process is about
+ * memoryBytes whatever the keys: a process receives a run at most per exchange, so a round whose keys fall
+ * in few ranges is spilled as several runs, and the runs are merged MERGE_FAN_IN at most at once.
+ *
+ * \param path The path to the input list file.
+ * \param header The header of the input list file.
+ * \param outpath The path to the output list file.
+ * \param memoryBytes The memory budget of every process, in bytes.
+ * \param scratchDir The directory where every process spills its sorted runs.
+ * \param compressThreshold The size of a run from which it is exchanged encoded, in bytes (0 to never encode).
+ * \param comm The communicator of the processes taking part in the sort.
+ *
+ * \return true if the output was checked to be sorted while it was written and to be a permutation of the
+ * input, false otherwise.
+ */
+bool external_sort(char *path, ListHeader header, char *outpath, size_t memoryBytes, char *scratchDir,
+                   size_t compressThreshold, MPI_Comm comm) {
+    const SortType *type = get_sort_type(header.typeId);
+    MPI_Datatype datatype = get_mpi_datatype(header.typeId);
+    size_t size = type->size;
+    int rank, nProcesses;
+    long offset, count;
+    size_t runCapacity;
+    int nRounds, nRuns = 0, runSlots, nSplitters, nLocalSamples;
+    int *sendCounts, *sendDispls;
+    long *runLengths;
+    char runPath[4096];
+    char *samples, *splitters, *chunk;
+    ListChecksum inputChecksum = {0, 0}, outputChecksum = {0, 0};
+    MPI_File fh;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    count = header.listLength / nProcesses;
+    offset = rank * count + ((rank < header.listLength % nProcesses) ? rank : header.listLength % nProcesses);
+    count += (rank < header.listLength % nProcesses) ? 1 : 0;
+
+    /* the chunk, the auxiliary buffer of the sort and the bucket, no larger than the part of any process */
+    runCapacity = clamp_capacity(memoryBytes / (3 * size), (header.listLength + nProcesses - 1) / nProcesses);
+    nRounds = (int) ((count + runCapacity - 1) / runCapacity);
+    MPI_Allreduce(MPI_IN_PLACE, &nRounds, 1, MPI_INT, MPI_MAX, comm);
+
+    if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        fprintf(stderr, "Error while opening file %s\n", path);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+
+    /* splitters from a regular sample of the file */
+    int event = trace_begin("sample splitters");
+    nLocalSamples = (count < EXTERNAL_SAMPLES) ? (int) count : EXTERNAL_SAMPLES;
+    samples = (char *) alloc_buffer((size_t) nLocalSamples * size, comm);
+    splitters = (char *) alloc_buffer((size_t) nProcesses * size, comm);
+    for (int i = 0; i < nLocalSamples; i++) {
+        long pos = offset + (long) ((double) i * count / nLocalSamples);
+        MPI_File_read_at(fh, (MPI_Offset) header.size + (MPI_Offset) pos * size, samples + i * size, 1, datatype,
+                         MPI_STATUS_IGNORE);
+    }
+    nSplitters = select_splitters(header.typeId, samples, nLocalSamples, splitters, comm);
+    free(samples);
+    trace_end(event);
+
+    /* run formation */
+    chunk = (char *) alloc_buffer(runCapacity * size, comm);
+    runSlots = nRounds;
+    runLengths = (long *) alloc_buffer(runSlots * sizeof(long), comm);
+    sendCounts = (int *) alloc_buffer(2 * nProcesses * sizeof(int), comm);
+    sendDispls = sendCounts + nProcesses;
+    for (int round = 0; round < nRounds; round++) {
+        long first = (long) round * runCapacity;
+        int n = (first >= count) ? 0 : (int) ((count - first < (long) runCapacity) ? count - first : runCapacity);
+        bool pending;
+
+        event = trace_begin("read run");
+        MPI_File_read_at_all(fh, (MPI_Offset) header.size + (MPI_Offset) (offset + first) * size, chunk, n, datatype,
+                             MPI_STATUS_IGNORE);
+        add_to_checksum(header.typeId, chunk, n, &inputChecksum);
+        trace_end(event);
+        event = trace_begin("sort run");
+        if (!type->merge_sort(chunk, n)) {
+            fprintf(stderr, "external_sort(): error while allocating memory for the sort of a run\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        trace_end(event);
+
+        /* a process receives a run at most per exchange, however the keys of the round are spread */
+        get_bucket_ranges(header.typeId, chunk, n, splitters, nSplitters, sendCounts, sendDispls, comm);
+        do {
+            int bucketLength;
+            void *bucket;
+            FILE *fp;
+
+            if ((bucket = exchange_bucket_ranges(header.typeId, chunk, sendCounts, sendDispls, (int) runCapacity,
+                                                 compressThreshold, &bucketLength, comm)) == NULL) {
+                fprintf(stderr, "external_sort(): error while allocating memory for the bucket of a run\n");
+                MPI_Abort(comm, EXIT_FAILURE);
+            }
+            event = trace_begin("spill run");
+            if (bucketLength > 0) {
+                get_run_path(runPath, sizeof(runPath), scratchDir, rank, nRuns);
+                if ((fp = fopen(runPath, "wb")) == NULL ||
+                    fwrite(bucket, size, bucketLength, fp) != (size_t) bucketLength || fclose(fp) != 0) {
+                    fprintf(stderr, "Error while writing run file %s\n", runPath);
+                    MPI_Abort(comm, EXIT_FAILURE);
+                }
+                add_run(&runLengths, &runSlots, &nRuns, bucketLength, comm);
+            }
+            free(bucket);
+            trace_end(event);
+            pending = false;
+            for (int i = 0; i < nProcesses; i++) {
+                pending = pending || sendCounts[i] > 0;
+            }
+            MPI_Allreduce(MPI_IN_PLACE, &pending, 1, MPI_C_BOOL, MPI_LOR, comm);
+        } while (pending);
+    }
+    free(sendCounts);
+    free(chunk);
+    free(splitters);
+    MPI_File_close(&fh);
+
+    /* merge passes: the oldest runs are merged into a new one until a single merge of them is left */
+    event = trace_begin("merge passes");
+    int firstRun = 0;
+    while (nRuns - firstRun > MERGE_FAN_IN) {
+        int nMerged = nRuns - firstRun - MERGE_FAN_IN + 1;
+        long length = 0;
+        if (nMerged > MERGE_FAN_IN) {
+            nMerged = MERGE_FAN_IN;
+        }
+        for (int r = firstRun; r < firstRun + nMerged; r++) {
+            length += runLengths[r];
+        }
+        merge_run_group(type, scratchDir, rank, firstRun, nMerged, nRuns, length, memoryBytes, comm);
+        add_run(&runLengths, &runSlots, &nRuns, length, comm);
+        firstRun += nMerged;
+    }
+    trace_end(event);
+
+    /* k-way merge of the runs, streamed to the output file */
+    event = trace_begin("merge runs");
+    int nMerged = nRuns - firstRun;
+    long localLength = 0, outOffset = 0, written = 0;
+    for (int r = firstRun; r < nRuns; r++) {
+        localLength += runLengths[r];
+    }
+    MPI_Exscan(&localLength, &outOffset, 1, MPI_LONG, MPI_SUM, comm);
+    if (rank == 0) {
+        outOffset = 0;
+    }
+
+    MPI_File out;
+    if (MPI_File_open(comm, outpath, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &out) != MPI_SUCCESS) {
+        fprintf(stderr, "Error while opening file %s\n", outpath);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    MPI_File_set_size(out, (MPI_Offset) header.size + (MPI_Offset) header.listLength * size);
+    if (rank == 0) {
+        unsigned char bytes[TYPED_HEADER_SIZE];
+        MPI_File_write_at(out, 0, bytes, encode_list_header(header, bytes), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    size_t bufferCapacity = clamp_capacity(memoryBytes / ((size_t) (nMerged + 1) * size), localLength);
+    RunCursor cursors[MERGE_FAN_IN];
+    FILE *runs[MERGE_FAN_IN];
+    char *outBuffer = (char *) alloc_buffer(bufferCapacity * size, comm);
+    char *last = (char *) alloc_buffer(2 * size, comm);
+    char *first = (char *) alloc_buffer(2 * size, comm);
+    bool sorted = true;
+
+    open_runs(scratchDir, rank, firstRun, nMerged, bufferCapacity, size, runs, cursors, comm);
+    while (refill_runs(runs, cursors, nMerged, bufferCapacity, size)) {
+        long n = type->merge_cursors(cursors, nMerged, outBuffer, bufferCapacity);
+        if (n < 0) {
+            fprintf(stderr, "external_sort(): error while allocating memory for the merge of the runs\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        add_to_checksum(header.typeId, outBuffer, (long) n, &outputChecksum);
+        if (type->find_unsorted(outBuffer, (long) n) >= 0) {
+            sorted = false;
+        }
+        if (written == 0) {
+            memcpy(first, outBuffer, size);
+        } else { /* order across consecutive output buffers */
+            memcpy(last + size, outBuffer, size);
+            if (type->find_unsorted(last, 2) >= 0) {
+                sorted = false;
+            }
+        }
+        memcpy(last, outBuffer + (n - 1) * size, size);
+        MPI_File_write_at(out, (MPI_Offset) header.size + (MPI_Offset) (outOffset + written) * size, outBuffer,
+                          (int) n, datatype, MPI_STATUS_IGNORE);
+        written += (long) n;
+    }
+    MPI_File_close(&out);
+    trace_end(event);
+
+    remove_runs(scratchDir, rank, firstRun, nMerged, cursors);
+
+    /* order across the key ranges of consecutive processes */
+    if (!check_block_boundary(header.typeId, (written > 0) ? first : NULL, (written > 0) ? last : NULL, outOffset,
+                              comm)) {
+        sorted = false;
+    }
+    free(first);
+    free(last);
+    free(outBuffer);
+    free(runLengths);
+
+    MPI_Allreduce(MPI_IN_PLACE, &sorted, 1, MPI_C_BOOL, MPI_LAND, comm);
+    reduce_checksum(&inputChecksum, comm);
+    reduce_checksum(&outputChecksum, comm);
+    if ((outputChecksum.sum != inputChecksum.sum) || (outputChecksum.xor != inputChecksum.xor)) {
+        if (rank == 0) {
+            fprintf(stderr, "The sorted list is not a permutation of the input list\n");
+        }
+        sorted = false;
+    }
+    return sorted;
+}
@@ -0,0 +1,23 @@
+/**
+ *  \file externalSort.h (definition file)
+ *  \brief Header file containing the declarations for the out-of-core sort of list files.
+ */
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <stdbool.h>
+#include <mpi.h>
+
+#include "listIO.h"
+
+/** \brief number of keys each process samples from its part of the file to choose the splitters */
+#define EXTERNAL_SAMPLES 1024
+/** \brief minimum number of elements of every buffer, whatever the memory budget */
+#define MIN_BUFFER_ELEMENTS 1024
+/** \brief maximum number of runs merged at once, bounding the files open and keeping their windows large */
+#define MERGE_FAN_IN 64
+
+extern bool external_sort(char *path, ListHeader header, char *outpath, size_t memoryBytes, char *scratchDir,
+                          size_t compressThreshold, MPI_Comm comm);
+
+#endif /* EXTERNAL_SORT_H */
@@ -0,0 +1,348 @@
+/**
+ *  \file genList.c (implementation file)
+ *  \brief Generator of list files for the benchmarks of prog2.
+ *
+ *  Writes a list file of any element type, with keys drawn from one of several distributions. The keys
+ *  of every distribution lie in a 32-bit range centred on zero, so every type can hold them, and the
+ *  payload of the records holds the position of the element, so a sort that loses or duplicates records
+ *  is caught by the checksum of prog2. The list is written in chunks, so lists larger than the memory of
+ *  the node (up to 2^32 elements and more) can be generated.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+#include <libgen.h>
+#include <math.h>
+
+#include "sorting.h"
+#include "listIO.h"
+
+/** \brief key distributions */
+#define DIST_UNIFORM  0
+#define DIST_SORTED   1
+#define DIST_REVERSE  2
+#define DIST_EQUAL    3
+#define DIST_FEW      4
+#define DIST_ZIPF     5
+#define DIST_SAWTOOTH 6
+#define NUMBER_DISTRIBUTIONS 7
+
+/** \brief number of elements generated and written at a time */
+#define CHUNK_LENGTH (1 << 20)
+
+/** \brief number of keys of the key range (keys are drawn from [-2^31, 2^31)) */
+#define KEY_RANGE (1ULL << 32)
+
+/** \brief default number of distinct keys of the few-unique, Zipf and sawtooth distributions */
+#define DEFAULT_UNIQUE 16
+/** \brief largest number of distinct keys of the Zipf distribution (size of its table) */
+#define MAX_ZIPF_KEYS (1 << 24)
+
+static const char *distributionNames[NUMBER_DISTRIBUTIONS] = {"uniform", "sorted", "reverse", "equal", "few",
+                                                             "zipf", "sawtooth"};
+
+/** \brief state of the pseudo-random generator (xorshift64*) */
+static uint64_t rngState;
+
+/** \brief print proper use of the program parameters and arguments */
+static void printUsage(char *cmdName);
+
+/**
+ * \brief Draws the next pseudo-random number.
+ *
+ * \return a uniformly distributed 64-bit number.
+ */
+static inline uint64_t next_random(void) {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * \brief Builds the cumulative distribution of the Zipf law over the distinct keys.
+ *
+ * \param nKeys The number of distinct keys.
+ * \param exponent The exponent of the law.
+ *
+ * \return the cumulative probabilities of the keys, from the most to the least frequent.
+ */
+static double *make_zipf_table(long nKeys, double exponent) {
+    double *table, total = 0.0;
+
+    if ((table = (double *) malloc(nKeys * sizeof(double))) == NULL) {
+        fprintf(stderr, "error on allocating space to the Zipf table\n");
+        exit(EXIT_FAILURE);
+    }
+    for (long r = 0; r < nKeys; r++) {
+        total += 1.0 / pow((double) (r + 1), exponent);
+        table[r] = total;
+    }
+    for (long r = 0; r < nKeys; r++) {
+        table[r] /= total;
+    }
+    return table;
+}
+
+/**
+ * \brief Draws a rank of the Zipf law by inverting its cumulative distribution.
+ *
+ * \param table The cumulative probabilities of the keys.
+ * \param nKeys The number of distinct keys.
+ *
+ * \return the rank of the key drawn (0 for the most frequent).
+ */
+static long draw_zipf(const double *table, long nKeys) {
+    double u = (double) (next_random() >> 11) * 0x1.0p-53;
+    long lo = 0, hi = nKeys - 1;
+
+    while (lo < hi) {
+        long mid = lo + ((hi - lo) >> 1);
+        if (table[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * \brief Computes the key of an element of the list.
+ *
+ * \param distribution The key distribution (one of DIST_*).
+ * \param position The position of the element in the list.
+ * \param length The number of elements of the list.
+ * \param nUnique The number of distinct keys of the few-unique, Zipf and sawtooth distributions.
+ * \param zipfTable The cumulative probabilities of the Zipf law.
+ *
+ * \return the key, in [-2^31, 2^31).
+ */
+static int64_t get_key(int distribution, uint64_t position, uint64_t length, long nUnique, const double *zipfTable) {
+    uint64_t level; /* in [0, KEY_RANGE) */
+
+    switch (distribution) {
+        case DIST_SORTED:
+            level = (uint64_t) ((long double) position * KEY_RANGE / length);
+            break;
+        case DIST_REVERSE:
+            level = (uint64_t) ((long double) (length - 1 - position) * KEY_RANGE / length);
+            break;
+        case DIST_EQUAL:
+            level = KEY_RANGE / 2;
+            break;
+        case DIST_FEW:
+            level = (next_random() % nUnique) * (KEY_RANGE / nUnique);
+            break;
+        case DIST_ZIPF: /* the frequent keys are scattered over the key range */
+            level = ((uint64_t) draw_zipf(zipfTable, nUnique) * 0x9e3779b97f4a7c15ULL) >> 32;
+            break;
+        case DIST_SAWTOOTH:
+            level = (position % nUnique) * (KEY_RANGE / nUnique);
+            break;
+        default:
+            level = next_random() >> 32;
+            break;
+    }
+    return (int64_t) level - (int64_t) (KEY_RANGE / 2);
+}
+
+/**
+ * \brief Stores a key in an element of the given type.
+ *
+ * \param typeId The element type (one of TYPE_*).
+ * \param element The element.
+ * \param key The key.
+ * \param position The position of the element, stored in the payload of the records.
+ */
+static void set_element(int typeId, char *element, int64_t key, uint64_t position) {
+    switch (typeId) {
+        case TYPE_INT32:
+            *(int32_t *) element = (int32_t) key;
+            break;
+        case TYPE_INT64:
+            *(int64_t *) element = key;
+            break;
+        case TYPE_FLOAT:
+            *(float *) element = (float) key;
+            break;
+        case TYPE_DOUBLE:
+            *(double *) element = (double) key;
+            break;
+        case TYPE_REC16: {
+            Record16 *record = (Record16 *) element;
+            record->key = key;
+            memcpy(record->payload, &position, sizeof(record->payload));
+            break;
+        }
+        default: {
+            Record32 *record = (Record32 *) element;
+            memset(record->payload, 0, sizeof(record->payload));
+            record->key = key;
+            memcpy(record->payload, &position, sizeof(position));
+            break;
+        }
+    }
+}
+
+/**
+ *  \brief Main function.
+ *
+ *  Processes the command line and writes the list file.
+ *
+ *  \param argc number of arguments in the command line
+ *  \param argv list of arguments in the command line
+ *
+ *  \return status of operation
+ */
+int main(int argc, char *argv[]) {
+    char *outpath = NULL;
+    uint64_t length = 0;
+    int distribution = DIST_UNIFORM;
+    const SortType *type = get_sort_type(TYPE_INT32);
+    long nUnique = DEFAULT_UNIQUE;
+    double exponent = 1.0;
+    double *zipfTable = NULL;
+    char *chunk;
+    FILE *fp;
+    int opt; /* selected option */
+
+    rngState = 0x9e3779b97f4a7c15ULL;
+    do {
+        switch ((opt = getopt(argc, argv, "n:e:d:t:u:z:r:o:h"))) {
+            case 'n': /* number of elements */
+                length = strtoull(optarg, NULL, 10);
+                break;
+            case 'e': /* number of elements as a power of 2 */
+                if (atoi(optarg) < 0 || atoi(optarg) > 40) {
+                    fprintf(stderr, "%s: invalid exponent\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                length = 1ULL << atoi(optarg);
+                break;
+            case 'd': /* key distribution */
+                distribution = -1;
+                for (int i = 0; i < NUMBER_DISTRIBUTIONS; i++) {
+                    if (strcmp(optarg, distributionNames[i]) == 0) {
+                        distribution = i;
+                    }
+                }
+                if (distribution < 0) {
+                    fprintf(stderr, "%s: unknown distribution %s\n", basename(argv[0]), optarg);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 't': /* element type */
+                if ((type = find_sort_type(optarg)) == NULL) {
+                    fprintf(stderr, "%s: unknown type %s\n", basename(argv[0]), optarg);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'u': /* number of distinct keys */
+                if (atol(optarg) <= 0) {
+                    fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                nUnique = atol(optarg);
+                break;
+            case 'z': /* exponent of the Zipf law */
+                exponent = atof(optarg);
+                break;
+            case 'r': /* seed */
+                rngState = strtoull(optarg, NULL, 10) * 0x9e3779b97f4a7c15ULL + 1;
+                break;
+            case 'o': /* output file */
+                outpath = optarg;
+                break;
+            case 'h': /* help mode */
+                printUsage(basename(argv[0]));
+                exit(EXIT_SUCCESS);
+            case '?': /* invalid option */
+                fprintf(stderr, "%s: invalid option\n", basename(argv[0]));
+                printUsage(basename(argv[0]));
+                exit(EXIT_FAILURE);
+            case -1:
+                break;
+        }
+    } while (opt != -1);
+    if (optind < argc || outpath == NULL || length == 0) {
+        fprintf(stderr, "%s: invalid format\n", basename(argv[0]));
+        printUsage(basename(argv[0]));
+        exit(EXIT_FAILURE);
+    }
+    if (nUnique > (long) KEY_RANGE) {
+        nUnique = (long) KEY_RANGE;
+    }
+    if (distribution == DIST_ZIPF) {
+        if (nUnique > MAX_ZIPF_KEYS) {
+            nUnique = MAX_ZIPF_KEYS;
+        }
+        zipfTable = make_zipf_table(nUnique, exponent);
+    }
+
+    if ((fp = fopen(outpath, "wb")) == NULL) {
+        fprintf(stderr, "Error while opening file %s\n", outpath);
+        exit(EXIT_FAILURE);
+    }
+    unsigned char bytes[TYPED_HEADER_SIZE];
+    int headerSize = encode_list_header(make_list_header(type->id, (long) length), bytes);
+    if ((chunk = (char *) malloc(CHUNK_LENGTH * type->size)) == NULL) {
+        fprintf(stderr, "error on allocating space to the list\n");
+        exit(EXIT_FAILURE);
+    }
+    if (fwrite(bytes, 1, headerSize, fp) != (size_t) headerSize) {
+        fprintf(stderr, "Error while writing file %s\n", outpath);
+        exit(EXIT_FAILURE);
+    }
+    for (uint64_t first = 0; first < length; first += CHUNK_LENGTH) {
+        size_t n = (length - first < CHUNK_LENGTH) ? (size_t) (length - first) : CHUNK_LENGTH;
+        for (size_t i = 0; i < n; i++) {
+            set_element(type->id, chunk + i * type->size,
+                        get_key(distribution, first + i, length, nUnique, zipfTable), first + i);
+        }
+        if (fwrite(chunk, type->size, n, fp) != n) {
+            fprintf(stderr, "Error while writing file %s\n", outpath);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Error while writing file %s\n", outpath);
+        exit(EXIT_FAILURE);
+    }
+    free(chunk);
+    free(zipfTable);
+    exit(EXIT_SUCCESS);
+}
+
+/**
+ *  \brief Print command usage.
+ *
+ *  A message specifying how the program should be called is printed.
+ *
+ *  \param cmdName string with the name of the command
+ */
+static void printUsage(char *cmdName) {
+    fprintf(stderr, "\nSynopsis: %s OPTIONS [-n number of elements / -e exponent / -d distribution / -t type /\n"
+                    "         -u number of distinct keys / -z Zipf exponent / -r seed / -o output filename / -h help]\n"
+                    "  OPTIONS:\n"
+                    "  -n      --- number of elements of the list\n"
+                    "  -e      --- number of elements of the list, as a power of 2\n"
+                    "  -d      --- key distribution: uniform (default), sorted, reverse, equal, few, zipf or sawtooth\n"
+                    "  -t      --- element type: int32 (default), int64, float, double, rec16 or rec32\n"
+                    "  -u      --- number of distinct keys of the few, zipf and sawtooth distributions (default 16)\n"
+                    "  -z      --- exponent of the zipf distribution (default 1.0)\n"
+                    "  -r      --- seed of the pseudo-random keys\n"
+                    "  -o      --- file where the list is written\n"
+                    "  -h      --- print this help\n",
+            cmdName);
+}
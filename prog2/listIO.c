@@ -0,0 +1,451 @@
+/**
+ *  \file listIO.c (definition file)
+ *  \brief Loading and storing of the binary list files.
+ *
+ *  A legacy list file holds the number of elements as an int followed by the ints themselves. A typed list
+ *  file starts with TYPED_LIST_MARKER, the type identifier (int) and the number of elements (int64),
+ *  followed by the elements of that type.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "listIO.h"
+
+/**
+ * \brief Builds the header of a list file.
+ *
+ * Lists of ints keep the legacy header, so the files stay readable by the older tools, unless their length
+ * does not fit in it.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param listLength The number of elements of the list.
+ *
+ * \return the header of the list file.
+ */
+ListHeader make_list_header(int typeId, long listLength) {
+    ListHeader header;
+
+    header.typeId = typeId;
+    header.listLength = listLength;
+    header.size = (typeId == TYPE_INT32 && listLength <= INT32_MAX) ? LEGACY_HEADER_SIZE : TYPED_HEADER_SIZE;
+    return header;
+}
+
+/**
+ * \brief Reads the header of a list file.
+ *
+ * \param path The path to the list file.
+ * \param header The header that was read.
+ *
+ * \return true if the header is valid, false otherwise.
+ */
+bool read_list_header(char *path, ListHeader *header) {
+    FILE *fp;
+    int first;
+    int typeId = TYPE_INT32;
+    int64_t listLength;
+
+    if ((fp = fopen(path, "rb")) == NULL) {
+        fprintf(stderr, "Error while opening file %s\n", path);
+        return false;
+    }
+    if (fread(&first, sizeof(int), 1, fp) != 1 ||
+        (first == TYPED_LIST_MARKER &&
+         (fread(&typeId, sizeof(int), 1, fp) != 1 || fread(&listLength, sizeof(int64_t), 1, fp) != 1))) {
+        if (feof(fp)) {
+            fprintf(stderr, "Unexpected end of file while reading file\n");
+        } else if (ferror(fp)) {
+            fprintf(stderr, "Error while reading file\n");
+        }
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+    if (first != TYPED_LIST_MARKER) {
+        listLength = first;
+    }
+    if (get_sort_type(typeId) == NULL) {
+        fprintf(stderr, "Unknown element type %d in file %s\n", typeId, path);
+        return false;
+    }
+    if (listLength < 0) {
+        fprintf(stderr, "Invalid list length %lld in file %s\n", (long long) listLength, path);
+        return false;
+    }
+    *header = make_list_header(typeId, (long) listLength);
+    if (first != TYPED_LIST_MARKER) {
+        header->size = LEGACY_HEADER_SIZE;
+    }
+    return true;
+}
+
+/**
+ * \brief Encodes the header of a list file.
+ *
+ * \param header The header to encode.
+ * \param bytes Buffer of at least TYPED_HEADER_SIZE bytes where the header is encoded.
+ *
+ * \return number of bytes of the encoded header.
+ */
+int encode_list_header(ListHeader header, unsigned char *bytes) {
+    int marker = TYPED_LIST_MARKER;
+    int64_t listLength = header.listLength;
+
+    if (header.size == LEGACY_HEADER_SIZE) {
+        int legacyLength = (int) header.listLength;
+        memcpy(bytes, &legacyLength, sizeof(int));
+    } else {
+        memcpy(bytes, &marker, sizeof(int));
+        memcpy(bytes + sizeof(int), &header.typeId, sizeof(int));
+        memcpy(bytes + 2 * sizeof(int), &listLength, sizeof(int64_t));
+    }
+    return header.size;
+}
+
+/**
+ * \brief Allocates a buffer for a list or a block of a list.
+ *
+ * A buffer backed by huge pages is aligned to and padded to HUGE_PAGE_SIZE, and the kernel is asked to
+ * back it with transparent huge pages, which cuts the TLB misses of the sort on large lists. Either kind
+ * of buffer is released with free().
+ *
+ * \param bytes The size of the buffer, in bytes.
+ * \param hugePages Whether the buffer should be backed by huge pages.
+ *
+ * \return pointer to the buffer, or NULL if it cannot be allocated.
+ */
+void *alloc_list(size_t bytes, bool hugePages) {
+    void *buffer;
+
+    if (!hugePages) {
+        return malloc(bytes > 0 ? bytes : 1);
+    }
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (posix_memalign(&buffer, HUGE_PAGE_SIZE, bytes > 0 ? bytes : HUGE_PAGE_SIZE) != 0) {
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    (void) madvise(buffer, bytes, MADV_HUGEPAGE); /* only a hint: fall back to normal pages */
+#endif
+    return buffer;
+}
+
+/**
+ * \brief Gets a buffer of at least the given size, reusing the memory of the previous one when it is large
+ * enough.
+ *
+ * \param buffer The buffer, empty ({NULL, 0}) before its first use.
+ * \param bytes The size needed.
+ * \param hugePages Whether a new buffer is backed by huge pages.
+ *
+ * \return pointer to the buffer, or NULL if there was no memory for it.
+ */
+void *reserve_list(ListBuffer *buffer, size_t bytes, bool hugePages) {
+    if (buffer->data == NULL || buffer->capacity < bytes) {
+        free(buffer->data);
+        buffer->capacity = 0;
+        if ((buffer->data = alloc_list(bytes, hugePages)) != NULL) {
+            buffer->capacity = bytes;
+        }
+    }
+    return buffer->data;
+}
+
+/**
+ * \brief Releases the memory of a reused buffer.
+ *
+ * \param buffer The buffer, left empty.
+ */
+void free_list_buffer(ListBuffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->capacity = 0;
+}
+
+/**
+ * \brief Reads the whole list of a list file, with a single fread(), into a buffer.
+ *
+ * \param path The path to the list file.
+ * \param header The header of the list file, as returned by read_list_header().
+ * \param list The buffer where the elements are read.
+ */
+void read_list(char *path, ListHeader header, void *list) {
+    size_t elementSize = get_sort_type(header.typeId)->size;
+    FILE *fp;
+
+    if ((fp = fopen(path, "rb")) == NULL || fseek(fp, (long) header.size, SEEK_SET) != 0) {
+        fprintf(stderr, "Error while opening file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    if (fread(list, elementSize, header.listLength, fp) != (size_t) header.listLength) {
+        if (feof(fp)) {
+            fprintf(stderr, "Unexpected end of file while reading file\n");
+        } else if (ferror(fp)) {
+            fprintf(stderr, "Error while reading file\n");
+        }
+        exit(EXIT_FAILURE);
+    }
+    fclose(fp);
+}
+
+/**
+ * \brief Loads the whole list of a list file into memory.
+ *
+ * In LOAD_BULK mode the elements are read into a new buffer with a single fread(). In LOAD_MMAP mode
+ * the file is mapped privately (copy-on-write), so the list can be sorted in place without touching the
+ * file. The list must be released with release_list() in the same mode.
+ *
+ * \param path The path to the list file.
+ * \param header The header of the list file, as returned by read_list_header().
+ * \param mode LOAD_BULK or LOAD_MMAP.
+ * \param hugePages Whether a bulk loaded list is placed in a buffer backed by huge pages.
+ *
+ * \return pointer to the first element of the list.
+ */
+void *load_list(char *path, ListHeader header, int mode, bool hugePages) {
+    size_t elementSize = get_sort_type(header.typeId)->size;
+    size_t payload = (size_t) header.listLength * elementSize;
+    void *list;
+
+    if (mode == LOAD_MMAP) {
+        struct stat st;
+        int fd;
+        void *map;
+
+        if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) != 0) {
+            perror("load_list(): open");
+            exit(EXIT_FAILURE);
+        }
+        if ((size_t) st.st_size < header.size + payload) {
+            fprintf(stderr, "Unexpected end of file while reading file\n");
+            exit(EXIT_FAILURE);
+        }
+        map = mmap(NULL, header.size + payload, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            perror("load_list(): mmap");
+            exit(EXIT_FAILURE);
+        }
+        return (char *) map + header.size;
+    }
+
+    if ((list = alloc_list(payload, hugePages)) == NULL) {
+        fprintf(stderr, "load_list(): error while allocating memory for the list\n");
+        exit(EXIT_FAILURE);
+    }
+    read_list(path, header, list);
+    return list;
+}
+
+/**
+ * \brief Releases a list returned by load_list().
+ *
+ * \param list The list to release.
+ * \param header The header of the list file.
+ * \param mode The mode used to load the list.
+ */
+void release_list(void *list, ListHeader header, int mode) {
+    if (mode == LOAD_MMAP) {
+        munmap((char *) list - header.size,
+               header.size + (size_t) header.listLength * get_sort_type(header.typeId)->size);
+    } else {
+        free(list);
+    }
+}
+
+/**
+ * \brief Writes a whole list to a list file, from a single process.
+ *
+ * \param path The path to the list file.
+ * \param header The header of the list file.
+ * \param list The elements.
+ */
+void store_list(char *path, ListHeader header, void *list) {
+    size_t elementSize = get_sort_type(header.typeId)->size;
+    unsigned char bytes[TYPED_HEADER_SIZE];
+    int headerSize = encode_list_header(header, bytes);
+    FILE *fp;
+
+    if ((fp = fopen(path, "wb")) == NULL) {
+        fprintf(stderr, "Error while opening file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    if (fwrite(bytes, 1, headerSize, fp) != (size_t) headerSize ||
+        fwrite(list, elementSize, header.listLength, fp) != (size_t) header.listLength || fclose(fp) != 0) {
+        fprintf(stderr, "Error while writing file %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+#ifndef THREADS_ONLY /* the MPI-IO of the blocks is left out of the threads-only build */
+/**
+ * \brief Reads a block of a list file with a collective MPI-IO read.
+ *
+ * Every process of the communicator must call this function with its own block.
+ *
+ * \param path The path to the list file.
+ * \param header The header of the list file.
+ * \param block The buffer where the block is stored.
+ * \param offset The position of the first element of the block in the list.
+ * \param count The number of elements of the block.
+ * \param comm The communicator of the processes reading the file.
+ */
+void load_list_block(char *path, ListHeader header, void *block, int offset, int count, MPI_Comm comm) {
+    MPI_Datatype datatype = get_mpi_datatype(header.typeId);
+    size_t elementSize = get_sort_type(header.typeId)->size;
+    MPI_File fh;
+    MPI_Status status;
+    int nRead;
+
+    if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        fprintf(stderr, "Error while opening file %s\n", path);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    MPI_File_read_at_all(fh, (MPI_Offset) header.size + (MPI_Offset) offset * elementSize,
+                         block, count, datatype, &status);
+    MPI_Get_count(&status, datatype, &nRead);
+    if (nRead != count) {
+        fprintf(stderr, "Unexpected end of file while reading file\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    MPI_File_close(&fh);
+}
+
+/**
+ * \brief Writes the blocks of a list distributed by the processes of a communicator to a list file.
+ *
+ * Every process of the communicator must call this function with its own block, which is stored at its
+ * position in the list, so no process ever needs to hold the whole list. The root process of the
+ * communicator writes the header. In STORE_MPIIO mode the blocks are written with a collective MPI-IO
+ * write. In STORE_MMAP mode every process copies its block into a shared mapping of the file, which
+ * requires all the processes to run in the same node.
+ *
+ * \param path The path to the list file.
+ * \param header The header of the list file (see make_list_header()).
+ * \param block The block of the list held by this process.
+ * \param offset The position of the first element of the block in the list.
+ * \param count The number of elements of the block.
+ * \param mode STORE_MPIIO or STORE_MMAP.
+ * \param comm The communicator of the processes writing the file.
+ */
+void store_list_block(char *path, ListHeader header, void *block, int offset, int count, int mode,
+                      MPI_Comm comm) {
+    size_t elementSize = get_sort_type(header.typeId)->size;
+    off_t fileSize = (off_t) header.size + (off_t) header.listLength * elementSize;
+    off_t start = (off_t) header.size + (off_t) offset * elementSize;
+    int rank, fd = -1;
+
+    MPI_Comm_rank(comm, &rank);
+    if (rank == 0) { /* create the file and write the header */
+        unsigned char bytes[TYPED_HEADER_SIZE];
+        int headerSize = encode_list_header(header, bytes);
+        if ((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0 || ftruncate(fd, fileSize) != 0 ||
+            pwrite(fd, bytes, headerSize, 0) != headerSize) {
+            perror("store_list_block(): open");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        if (mode != STORE_MMAP) {
+            close(fd);
+        }
+    }
+    MPI_Barrier(comm);
+
+    if (mode == STORE_MMAP) {
+        long pageSize = sysconf(_SC_PAGESIZE);
+        off_t end, mapStart;
+        char *map;
+
+        if (count > 0) {
+            if (fd < 0 && (fd = open(path, O_RDWR)) < 0) {
+                perror("store_list_block(): open");
+                MPI_Abort(comm, EXIT_FAILURE);
+            }
+            end = start + (off_t) count * elementSize;
+            mapStart = start - start % pageSize;
+            map = mmap(NULL, end - mapStart, PROT_READ | PROT_WRITE, MAP_SHARED, fd, mapStart);
+            if (map == MAP_FAILED) {
+                perror("store_list_block(): mmap");
+                MPI_Abort(comm, EXIT_FAILURE);
+            }
+            memcpy(map + (start - mapStart), block, (size_t) count * elementSize);
+            msync(map, end - mapStart, MS_SYNC);
+            munmap(map, end - mapStart);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        MPI_Barrier(comm);
+        return;
+    }
+
+    MPI_File fh;
+    if (MPI_File_open(comm, path, MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        fprintf(stderr, "Error while opening file %s\n", path);
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    MPI_File_write_at_all(fh, (MPI_Offset) start, block, count, get_mpi_datatype(header.typeId),
+                          MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+}
+
+#endif /* THREADS_ONLY */
+
+/**
+ * \brief Computes the block of a list assigned to a process.
+ *
+ * The first listLength % nProcesses processes get one extra element.
+ *
+ * \param listLength The number of elements of the list.
+ * \param nProcesses The number of processes sharing the list.
+ * \param rank The rank of the process.
+ * \param offset Position of the first element of the block in the list.
+ * \param count Number of elements of the block.
+ */
+void get_block_range(int listLength, int nProcesses, int rank, int *offset, int *count) {
+    int base = listLength / nProcesses;
+    int extra = listLength % nProcesses;
+
+    *count = base + (rank < extra ? 1 : 0);
+    *offset = rank * base + (rank < extra ? rank : extra);
+}
+
+#ifndef THREADS_ONLY
+/**
+ * \brief Gets the MPI datatype of the elements of a list.
+ *
+ * Records are sent as contiguous bytes. Their datatypes are committed on the first call.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ *
+ * \return the MPI datatype of one element.
+ */
+MPI_Datatype get_mpi_datatype(int typeId) {
+    static MPI_Datatype recordTypes[NUMBER_TYPES];
+    static bool committed[NUMBER_TYPES];
+
+    switch (typeId) {
+        case TYPE_INT32:
+            return MPI_INT32_T;
+        case TYPE_INT64:
+            return MPI_INT64_T;
+        case TYPE_FLOAT:
+            return MPI_FLOAT;
+        case TYPE_DOUBLE:
+            return MPI_DOUBLE;
+        default:
+            if (!committed[typeId]) {
+                MPI_Type_contiguous((int) get_sort_type(typeId)->size, MPI_BYTE, &recordTypes[typeId]);
+                MPI_Type_commit(&recordTypes[typeId]);
+                committed[typeId] = true;
+            }
+            return recordTypes[typeId];
+    }
+}
+#endif /* THREADS_ONLY */
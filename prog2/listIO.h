@@ -0,0 +1,71 @@
+/**
+ *  \file listIO.h (definition file)
+ *  \brief Header file containing the declarations for the functions used to load and store the binary list files.
+ */
+#ifndef LIST_IO_H
+#define LIST_IO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#ifndef THREADS_ONLY
+#include <mpi.h>
+#endif
+
+#include "sorting.h"
+
+/** \brief load the list with a single bulk read */
+#define LOAD_BULK  0
+/** \brief load the list by memory-mapping the file */
+#define LOAD_MMAP  1
+/** \brief every process reads its own block of the list with MPI-IO */
+#define LOAD_MPIIO 2
+
+/** \brief every process writes its own block of the list with MPI-IO */
+#define STORE_MPIIO 0
+/** \brief every process copies its own block of the list into a shared mapping of the file */
+#define STORE_MMAP  1
+
+/** \brief first int of a typed list file (a legacy list file starts with its non-negative length) */
+#define TYPED_LIST_MARKER (-1)
+/** \brief size of the header of a legacy list file of ints */
+#define LEGACY_HEADER_SIZE 4
+/** \brief size of the header of a typed list file: marker, type identifier and 64-bit length */
+#define TYPED_HEADER_SIZE  16
+
+/** \brief size and alignment of the buffers backed by transparent huge pages */
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+typedef struct ListHeader
+{
+    int typeId;      /* element type (one of TYPE_*) */
+    long listLength; /* number of elements */
+    int size;        /* number of bytes before the first element */
+} ListHeader;
+
+/** \brief buffer reused by the lists of consecutive runs, which only grows */
+typedef struct ListBuffer
+{
+    void *data;
+    size_t capacity; /* bytes */
+} ListBuffer;
+
+extern ListHeader make_list_header(int typeId, long listLength);
+extern bool read_list_header(char *path, ListHeader *header);
+extern int encode_list_header(ListHeader header, unsigned char *bytes);
+extern void *alloc_list(size_t bytes, bool hugePages);
+extern void *reserve_list(ListBuffer *buffer, size_t bytes, bool hugePages);
+extern void free_list_buffer(ListBuffer *buffer);
+extern void read_list(char *path, ListHeader header, void *list);
+extern void *load_list(char *path, ListHeader header, int mode, bool hugePages);
+extern void release_list(void *list, ListHeader header, int mode);
+extern void store_list(char *path, ListHeader header, void *list);
+extern void get_block_range(int listLength, int nProcesses, int rank, int *offset, int *count);
+#ifndef THREADS_ONLY
+extern void load_list_block(char *path, ListHeader header, void *block, int offset, int count, MPI_Comm comm);
+extern void store_list_block(char *path, ListHeader header, void *block, int offset, int count, int mode,
+                             MPI_Comm comm);
+extern MPI_Datatype get_mpi_datatype(int typeId);
+#endif
+
+#endif /* LIST_IO_H */
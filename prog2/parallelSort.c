@@ -0,0 +1,360 @@
+/**
+ *  \file parallelSort.c (definition file)
+ *  \brief Sort engines called in-process, as a library.
+ *
+ *  sort_buffer() sorts a buffer held by the caller with the threads of a pool created for the call, so a
+ *  service can sort in memory instead of writing a list file and launching prog2. The engines are those of
+ *  prog2: the bitonic network, the radix sort and the merge sort, whose runs are sorted by the threads and
+ *  merged with a loser tree. sort_buffer_distributed() is the entry point of an MPI application, whose
+ *  processes hold the blocks of a list.
+ *
+ *  The errors are returned as a status instead of ending the process, running out of memory in an engine,
+ *  the pool or a bucket included; the processes of a distributed sort agree on it before every collective step.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "parallelSort.h"
+#include "threadPool.h"
+#ifndef THREADS_ONLY
+#include "bitonicSort.h"
+#include "sampleSort.h"
+#endif
+
+/** \brief runs of a list sorted by the threads of the pool, before they are merged */
+typedef struct RunTask
+{
+    const SortType *type;
+    char *list;
+    unsigned int length;
+    bool *sorted;       /* the run of every thread could be sorted */
+} RunTask;
+
+/**
+ * \brief Reverses the order of the elements of a list.
+ *
+ * \param list The list.
+ * \param length The number of elements of the list.
+ * \param size The size of an element.
+ */
+static void reverse_elements(void *list, unsigned int length, size_t size) {
+    unsigned char tmp[sizeof(Record32)]; /* the largest element type */
+    char *front = (char *) list, *back = (char *) list + (length > 0 ? (size_t) (length - 1) * size : 0);
+
+    while (front < back) {
+        memcpy(tmp, front, size);
+        memcpy(front, back, size);
+        memcpy(back, tmp, size);
+        front += size;
+        back -= size;
+    }
+}
+
+/**
+ * \brief Sort the run of a list assigned to a thread of the pool.
+ *
+ * \param arg The RunTask of the list.
+ * \param threadId The index of the thread, which sorts the run of the same index.
+ * \param nThreads The number of threads, and of runs.
+ */
+static void sort_run_task(void *arg, int threadId, int nThreads) {
+    RunTask *task = (RunTask *) arg;
+    unsigned int first = (unsigned int) ((unsigned long) task->length * threadId / nThreads);
+    unsigned int last = (unsigned int) ((unsigned long) task->length * (threadId + 1) / nThreads);
+
+    task->sorted[threadId] = task->type->merge_sort(task->list + (size_t) first * task->type->size, last - first);
+}
+
+/**
+ * \brief Sorts a list in ascending order with the merge engine: every thread of the pool sorts a run of the
+ *        list, and the runs are merged in a single pass.
+ *
+ * \param type The element type of the list.
+ * \param list The list.
+ * \param length The number of elements of the list.
+ * \param pool The pool of threads, or NULL.
+ *
+ * \return SORT_OK, or SORT_NO_MEMORY if the buffers of a run or of the merge cannot be allocated.
+ */
+static int merge_sort_runs(const SortType *type, void *list, unsigned int length, ThreadPool *pool) {
+    int nRuns;
+
+    if (pool == NULL || length < MIN_THREADED_LENGTH) {
+        return type->merge_sort(list, length) ? SORT_OK : SORT_NO_MEMORY;
+    }
+    nRuns = get_thread_pool_size(pool);
+    int runOffsets[nRuns];
+    bool sorted[nRuns];
+    RunTask task = {type, (char *) list, length, sorted};
+    run_thread_pool(pool, sort_run_task, &task);
+    for (int i = 0; i < nRuns; i++) {
+        if (!sorted[i]) {
+            return SORT_NO_MEMORY;
+        }
+        runOffsets[i] = (int) ((unsigned long) length * i / nRuns);
+    }
+    return type->merge_runs(list, length, runOffsets, nRuns) ? SORT_OK : SORT_NO_MEMORY;
+}
+
+/**
+ * \brief Sorts a list of any length with the bitonic network, which needs 2^k elements: the list is copied
+ *        into a buffer of the next power of 2, padded with copies of its last element in the given order.
+ *        As records of the same key may differ, as many copies of that element as pads are then left out
+ *        wherever they end up, rather than the end of the buffer.
+ *
+ * \param type The element type of the list.
+ * \param list The list.
+ * \param length The number of elements of the list.
+ * \param asc The order of the sort.
+ * \param pool The pool of threads, or NULL.
+ *
+ * \return SORT_OK, or SORT_NO_MEMORY if the padded buffer or the selection of the pad cannot be allocated.
+ */
+static int bitonic_sort_padded(const SortType *type, void *list, unsigned int length, bool asc,
+                               ThreadPool *pool) {
+    unsigned char pad[sizeof(Record32)]; /* the largest element type */
+    unsigned int width = 1, nPads, nElements = 0;
+    size_t size = type->size;
+    char *padded;
+
+    while (width < length) {
+        width <<= 1;
+    }
+    if ((padded = (char *) malloc((size_t) width * size)) == NULL) {
+        return SORT_NO_MEMORY;
+    }
+    if (type->select_first(list, length, 1, !asc, pad) < 0) {
+        free(padded);
+        return SORT_NO_MEMORY;
+    }
+    memcpy(padded, list, (size_t) length * size);
+    for (unsigned int i = length; i < width; i++) {
+        memcpy(padded + (size_t) i * size, pad, size);
+    }
+    type->bitonic_sort_mt(padded, width, asc, pool);
+    nPads = width - length;
+    for (unsigned int i = 0; i < width; i++) {
+        char *element = padded + (size_t) i * size;
+        if (nPads > 0 && memcmp(element, pad, size) == 0) {
+            nPads--;
+            continue;
+        }
+        memcpy((char *) list + (size_t) nElements++ * size, element, size);
+    }
+    free(padded);
+    return SORT_OK;
+}
+
+/**
+ * \brief Sorts a list held by this process with an engine.
+ *
+ * \param type The element type of the list.
+ * \param list The list.
+ * \param length The number of elements of the list.
+ * \param asc The order of the sort.
+ * \param engine The engine (one of ENGINE_*).
+ * \param pool The pool of threads, or NULL.
+ *
+ * \return SORT_OK, or SORT_NO_MEMORY.
+ */
+static int sort_local(const SortType *type, void *list, unsigned int length, bool asc, int engine,
+                      ThreadPool *pool) {
+    if (engine == ENGINE_BITONIC) {
+        if ((length & (length - 1)) != 0) {
+            return bitonic_sort_padded(type, list, length, asc, pool);
+        }
+        type->bitonic_sort_mt(list, length, asc, pool);
+        return SORT_OK;
+    }
+    if (engine == ENGINE_RADIX) {
+        if (!type->radix_sort_mt(list, length, pool)) {
+            return SORT_NO_MEMORY;
+        }
+    } else if (merge_sort_runs(type, list, length, pool) != SORT_OK) {
+        return SORT_NO_MEMORY;
+    }
+    if (!asc) { /* both engines sort in ascending order */
+        reverse_elements(list, length, type->size);
+    }
+    return SORT_OK;
+}
+
+/**
+ * \brief Sorts a buffer in memory.
+ *
+ * \param buffer The elements, sorted in place.
+ * \param length The number of elements, up to INT_MAX.
+ * \param typeId The element type (one of TYPE_*).
+ * \param asc true to sort in ascending order, false in descending order.
+ * \param engine The engine (one of ENGINE_*); the bitonic network pads a length that is not a power of 2.
+ * \param nThreads The number of threads sorting the buffer, the calling thread included.
+ *
+ * \return SORT_OK, the error of the arguments (one of SORT_*), or SORT_NO_MEMORY if the engine or the pool
+ *         cannot be allocated, the buffer then left in an unspecified order.
+ */
+int sort_buffer(void *buffer, size_t length, int typeId, bool asc, int engine, int nThreads) {
+    const SortType *type = get_sort_type(typeId);
+    ThreadPool *pool = NULL;
+    int status;
+
+    if (type == NULL) {
+        return SORT_INVALID_TYPE;
+    }
+    if (engine < 0 || engine >= NUMBER_ENGINES) {
+        return SORT_INVALID_ENGINE;
+    }
+    if (length > INT_MAX) { /* the engines index the list with ints */
+        return SORT_INVALID_LENGTH;
+    }
+    if (length < 2) {
+        return SORT_OK;
+    }
+    if (nThreads > 1 && (pool = create_thread_pool(nThreads)) == NULL) {
+        return SORT_NO_MEMORY;
+    }
+    status = sort_local(type, buffer, (unsigned int) length, asc, engine, pool);
+    if (pool != NULL) {
+        destroy_thread_pool(pool);
+    }
+    return status;
+}
+
+#ifndef THREADS_ONLY /* the distributed engines are left out of the threads-only build */
+/**
+ * \brief Reverses a list sorted over the processes of a communicator, in rank order: every process reverses
+ *        its bucket and swaps it with the process of the opposite rank.
+ *
+ * \param type The element type of the list.
+ * \param sorted The bucket of this process, replaced by the reversed bucket of the opposite process.
+ * \param sortedLength The number of elements of the bucket, replaced as well.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return SORT_OK, or SORT_NO_MEMORY if a process cannot allocate the bucket it receives, the same for every
+ *         process.
+ */
+static int reverse_distributed(const SortType *type, void **sorted, int *sortedLength, MPI_Comm comm) {
+    int rank, nProcesses, partner, length = 0, status = SORT_OK;
+    void *reversed = NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    reverse_elements(*sorted, *sortedLength, type->size);
+    partner = nProcesses - 1 - rank;
+    if (partner != rank) {
+        MPI_Sendrecv(sortedLength, 1, MPI_INT, partner, 0, &length, 1, MPI_INT, partner, 0, comm,
+                     MPI_STATUS_IGNORE);
+        if ((reversed = malloc((length > 0) ? (size_t) length * type->size : 1)) == NULL) {
+            status = SORT_NO_MEMORY;
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, comm);
+    if (status != SORT_OK || partner == rank) {
+        free(reversed);
+        return status;
+    }
+    MPI_Sendrecv(*sorted, *sortedLength * (int) type->size, MPI_BYTE, partner, 1,
+                 reversed, length * (int) type->size, MPI_BYTE, partner, 1, comm, MPI_STATUS_IGNORE);
+    free(*sorted);
+    *sorted = reversed;
+    *sortedLength = length;
+    return SORT_OK;
+}
+
+/**
+ * \brief Sorts a list distributed in blocks over the processes of a communicator.
+ *
+ * Every process of the communicator must call this function, with the same arguments but the block. The
+ * bitonic engine runs the network over the processes, and needs blocks of the same power of 2 length over
+ * a power of 2 number of processes; the radix and merge engines sort the blocks locally and redistribute
+ * them with the sample sort, for any lengths.
+ *
+ * The bitonic engine sorts the blocks in place; its bucket is a copy of the sorted block, made so that every
+ * engine returns a bucket owned and freed by the caller.
+ *
+ * \param block The block of the list held by this process, sorted in place on the way.
+ * \param blockLength The number of elements of the block.
+ * \param typeId The element type (one of TYPE_*).
+ * \param asc true to sort in ascending order, false in descending order.
+ * \param engine The engine (one of ENGINE_*).
+ * \param nThreads The number of threads of every process.
+ * \param sorted Where the sorted bucket of this process is written, to be freed by the caller. The buckets
+ *        of the processes, taken in rank order, form the sorted list.
+ * \param sortedLength Where the number of elements of the bucket is written.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return SORT_OK, the error of the arguments (one of SORT_*), or SORT_NO_MEMORY if a process cannot allocate
+ *         its engine, its pool, its bucket or the partner block of the network; the same for every process, and
+ *         no bucket is returned on error. The bookkeeping of the exchanges, a few integers per process, still
+ *         ends the job if it cannot be allocated.
+ */
+int sort_buffer_distributed(void *block, int blockLength, int typeId, bool asc, int engine, int nThreads,
+                            void **sorted, int *sortedLength, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    ThreadPool *pool = NULL;
+    int nProcesses, status = SORT_OK;
+
+    *sorted = NULL;
+    *sortedLength = 0;
+    if (type == NULL) {
+        return SORT_INVALID_TYPE;
+    }
+    if (engine < 0 || engine >= NUMBER_ENGINES) {
+        return SORT_INVALID_ENGINE;
+    }
+    if (blockLength < 0) { /* the other processes learn it when they agree on the status */
+        status = SORT_INVALID_LENGTH;
+    }
+    MPI_Comm_size(comm, &nProcesses);
+    if (engine == ENGINE_BITONIC) { /* the network needs the same 2^k elements in 2^k processes */
+        int bounds[2] = {-blockLength, blockLength}, globalBounds[2];
+        MPI_Allreduce(bounds, globalBounds, 2, MPI_INT, MPI_MAX, comm);
+        if (-globalBounds[0] != globalBounds[1] || blockLength <= 0 || (blockLength & (blockLength - 1)) != 0 ||
+            (nProcesses & (nProcesses - 1)) != 0) {
+            return SORT_INVALID_LENGTH;
+        }
+    }
+
+    /* every allocation of this process is done before the processes agree to go on with the collective steps */
+    if (status == SORT_OK && nThreads > 1 && (pool = create_thread_pool(nThreads)) == NULL) {
+        status = SORT_NO_MEMORY;
+    }
+    if (status == SORT_OK && engine == ENGINE_BITONIC) {
+        if ((*sorted = malloc((size_t) blockLength * type->size)) == NULL) {
+            status = SORT_NO_MEMORY;
+        }
+    } else if (status == SORT_OK) {
+        status = sort_local(type, block, (unsigned int) blockLength, true, engine, pool);
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MIN, comm);
+    if (status == SORT_OK && engine == ENGINE_BITONIC) {
+        if (bitonic_sort_distributed(typeId, block, blockLength, 1, 0, pool, comm)) {
+            memcpy(*sorted, block, (size_t) blockLength * type->size);
+            *sortedLength = blockLength;
+        } else {
+            status = SORT_NO_MEMORY;
+        }
+    } else if (status == SORT_OK) {
+        if ((*sorted = sample_sort_sorted(typeId, block, blockLength, 0, sortedLength, comm)) == NULL) {
+            status = SORT_NO_MEMORY;
+        }
+    }
+    if (status == SORT_OK && !asc) {
+        status = reverse_distributed(type, sorted, sortedLength, comm);
+    }
+    if (status != SORT_OK) {
+        free(*sorted);
+        *sorted = NULL;
+        *sortedLength = 0;
+    }
+    if (pool != NULL) {
+        destroy_thread_pool(pool);
+    }
+    return status;
+}
+#endif /* THREADS_ONLY */
@@ -0,0 +1,35 @@
+/**
+ *  \file parallelSort.h (definition file)
+ *  \brief Header file containing the declarations for the sort engines called in-process, as a library.
+ */
+#ifndef PARALLEL_SORT_H
+#define PARALLEL_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#ifndef THREADS_ONLY
+#include <mpi.h>
+#endif
+
+#include "sorting.h"
+
+/** \brief sort engines */
+#define ENGINE_BITONIC 0
+#define ENGINE_RADIX   1
+#define ENGINE_MERGE   2
+#define NUMBER_ENGINES 3
+
+/** \brief status of a sort, the errors are returned instead of ending the process */
+#define SORT_OK              0
+#define SORT_INVALID_TYPE   -1   /* not one of TYPE_* */
+#define SORT_INVALID_ENGINE -2   /* not one of ENGINE_* */
+#define SORT_INVALID_LENGTH -3   /* too long for the engines, or blocks the distributed engine cannot sort */
+#define SORT_NO_MEMORY      -4   /* an engine, the pool or a bucket cannot be allocated */
+
+extern int sort_buffer(void *buffer, size_t length, int typeId, bool asc, int engine, int nThreads);
+#ifndef THREADS_ONLY
+extern int sort_buffer_distributed(void *block, int blockLength, int typeId, bool asc, int engine, int nThreads,
+                                   void **sorted, int *sortedLength, MPI_Comm comm);
+#endif
+
+#endif /* PARALLEL_SORT_H */
@@ -5,42 +5,109 @@
 #include <math.h>
 #include <string.h>
 #include <libgen.h>
+#include <limits.h>
 
 #include "sorting.h"
+#include "bitonicSort.h"
+#include "sampleSort.h"
+#include "listIO.h"
+#include "externalSort.h"
+#include "verifyList.h"
+#include "trace.h"
+#include "selectList.h"
+#include "argsort.h"
+#include "wireCodec.h"
 
 #define MAX_NUMBER_PROCESSES 8 /* maximum number of processes */
 
+/** \brief sorting algorithms */
+#define BITONIC_SORT 0
+#define SAMPLE_SORT  1
+#define EXTERNAL_SORT 2
+
+/** \brief phases of a run timed by the -v option */
+#define PHASE_LOAD    0
+#define PHASE_SORT    1
+#define PHASE_STORE   2
+#define PHASE_VERIFY  3
+#define NUMBER_PHASES 4
+
+
+/** \brief default memory budget per process of the external sort, in MiB */
+#define DEFAULT_MEMORY_MB 512
+
+/** \brief maximum number of percentiles selected in a run */
+#define MAX_PERCENTILES 64
+
+/** \brief outcome of the run on a list file */
+#define FILE_SORTED  0   /* sorted and verified, or keys selected */
+#define FILE_FAILED  1   /* the verification failed */
+#define FILE_INVALID 2   /* the file could not be processed with the given options */
+
+/** \brief settings of a run, shared by every list file of a batch */
+typedef struct SortOptions
+{
+    char *cmdName;
+    int algorithm;
+    int loadMode;
+    int storeMode;
+    long memoryMB;
+    char *scratchDir;
+    bool hugePages;
+    int nSegments;
+    size_t compressThreshold;
+    bool verbose;
+    int topK;
+    bool greatest;
+    double percentiles[MAX_PERCENTILES];
+    int nPercentiles;
+} SortOptions;
+
+/** \brief buffers of a process, reused by the list files of a batch */
+typedef struct ListBuffers
+{
+    ListBuffer list;    /* whole list at the root */
+    ListBuffer block;   /* block of the other processes, or of every process with MPI-IO */
+    ListBuffer pairs;   /* (key, index) pairs of the whole list at the root */
+} ListBuffers;
+
+/** \brief list file of a batch, in the order of the manifest */
+typedef struct BatchEntry
+{
+    char *filepath;
+    char *outpath;      /* NULL if the sorted list is not written */
+    char *permpath;     /* NULL if the permutation is not written */
+    long bytes;         /* size of the list, -1 if its header cannot be read */
+    int group;          /* group of processes sorting a small list, -1 for the whole communicator */
+} BatchEntry;
+
+/** \brief small list file of a batch, ordered by decreasing size to be assigned to the groups */
+typedef struct BatchLoad
+{
+    long bytes;
+    int index;
+} BatchLoad;
+
 /** \brief print proper use of the program parameters and arguments */
 static void printUsage(char *cmdName);
 
+/** \brief sort (or select the keys of) one list file */
+static int process_file(char *filepath, char *outpath, char *permpath, const SortOptions *options,
+                        ListBuffers *buffers, ThreadPool *pool, MPI_Comm comm);
+
+/** \brief sort the list files of a manifest */
+static bool run_batch(char *manifest, const SortOptions *options, ListBuffers *buffers, ThreadPool *pool,
+                      size_t smallBytes, int groupSize, MPI_Comm comm);
+
 /**
  *  \brief Process execution.
  *
- *  Design and flow of the dispatcher:
- *
  *  1 - Process the arguments from the command line.
  *
- *  2 - Initialize the shared region with the necessary structures.
- *
- *  3 - Create tasks.
- *
- *  4 - Send tasks to worker process and wait to receive results.
- *
- *  5 - Sign workers the execution finished.
- *
- *  6 - Print final results.
- *
- *  Design and flow of the worker:
- *
- *  1 - Wait for work status from dispatcher.
- *
- *  2 - If there is work to do, wait to receive task.
+ *  2 - Sort the list file given with -f, or every list file of the manifest given with -b, back to back
+ *  in the same MPI job with the same thread pool and buffers.
  *
- *  3 - Process task.
- *
- *  4 - Send results.
- *
- *  5 - Do 2-4, until there is no more work to do.
+ *  3 - Print the results of every list file.
  *
  *  \param argc number of arguments in the command line
  *  \param argv list of arguments in the command line
@@ -48,28 +115,38 @@ static void printUsage(char *cmdName);
  *  \return status of operation
  */
 int main(int argc, char *argv[]) {
-    int rank, nProcesses, nProcessesNow;
-
-    MPI_Comm presentComm, nextComm;
-    MPI_Group presentGroup, nextGroup;
-    int gMembersId[MAX_NUMBER_PROCESSES];
-
-    int seq_length;
-    int nIter;
-
-    int *recListSeq;
-
-    /* dispatcher variables */
-    int listLength;
-    int *sendListSeq = NULL;
+    int rank, nProcesses;
     char *filepath = NULL;
+    int algorithm = BITONIC_SORT;
+    int loadMode = LOAD_BULK;
+    char *outpath = NULL;
+    char *permpath = NULL;
+    int storeMode = STORE_MPIIO;
+    int nThreads = 1;
+    long memoryMB = DEFAULT_MEMORY_MB;
+    char *scratchDir = "/tmp";
+    bool hugePages = false;
+    int nSegments = 1;
+    size_t compressThreshold = 0;
+    bool verbose = false;
+    char *tracePath = NULL;
+    int topK = 0;
+    bool greatest = false;
+    double percentiles[MAX_PERCENTILES];
+    int nPercentiles = 0;
+    bool selecting;
+    char *manifest = NULL;
+    size_t smallBytes = 0;
+    int groupSize = 1;
+    int status;
+    SortOptions options;
+    ListBuffers buffers = {{NULL, 0}, {NULL, 0}, {NULL, 0}};
+    ThreadPool *pool = NULL;
+
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &nProcesses);
-    for (int j = 0; j < nProcesses; j++) {
-        gMembersId[j] = j;
-    }
 
     /* process command line options */
     int opt; /* selected option */
@@ -81,7 +158,7 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
     do {
-        switch ((opt = getopt(argc, argv, "f:h"))) {
+        switch ((opt = getopt(argc, argv, "f:a:l:o:i:w:t:m:s:pn:c:vr:k:gq:b:j:u:h"))) {
             case 'f':                 /* file */
                 if (optarg[0] == '-') /* filename is missing */
                 {
@@ -101,6 +178,189 @@ int main(int argc, char *argv[]) {
                 }
                 filepath = optarg;
                 break;
+            case 'a': /* sorting algorithm */
+                if (strcmp(optarg, "bitonic") == 0) {
+                    algorithm = BITONIC_SORT;
+                } else if (strcmp(optarg, "sample") == 0) {
+                    algorithm = SAMPLE_SORT;
+                } else if (strcmp(optarg, "external") == 0) {
+                    algorithm = EXTERNAL_SORT;
+                } else {
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: unknown algorithm %s\n", basename(argv[0]), optarg);
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'l': /* loading mode */
+                if (strcmp(optarg, "bulk") == 0) {
+                    loadMode = LOAD_BULK;
+                } else if (strcmp(optarg, "mmap") == 0) {
+                    loadMode = LOAD_MMAP;
+                } else if (strcmp(optarg, "mpiio") == 0) {
+                    loadMode = LOAD_MPIIO;
+                } else {
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: unknown loading mode %s\n", basename(argv[0]), optarg);
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'o': /* output file */
+                if (optarg[0] == '-') /* filename is missing */
+                {
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: output file name is missing\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                outpath = optarg;
+                break;
+            case 'i': /* permutation file */
+                if (optarg[0] == '-') /* filename is missing */
+                {
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: permutation file name is missing\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                permpath = optarg;
+                break;
+            case 'w': /* storing mode */
+                if (strcmp(optarg, "mpiio") == 0) {
+                    storeMode = STORE_MPIIO;
+                } else if (strcmp(optarg, "mmap") == 0) {
+                    storeMode = STORE_MMAP;
+                } else {
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: unknown storing mode %s\n", basename(argv[0]), optarg);
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 't': /* number of threads per process */
+                if (atoi(optarg) <= 0) { /* non-positive number */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                nThreads = atoi(optarg);
+                break;
+            case 'm': /* memory budget of the external sort */
+                if (atol(optarg) <= 0) { /* non-positive number */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                memoryMB = atol(optarg);
+                break;
+            case 's': /* scratch directory of the external sort */
+                scratchDir = optarg;
+                break;
+            case 'p': /* huge pages */
+                hugePages = true;
+                break;
+            case 'n': /* number of pipeline segments */
+                if (atoi(optarg) <= 0 || (atoi(optarg) & (atoi(optarg) - 1)) != 0) { /* not a power of 2 */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: the number of segments should be a power of 2\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                nSegments = atoi(optarg);
+                break;
+            case 'c': /* compression of the transfers of sorted runs */
+                if (atol(optarg) <= 0) { /* non-positive number */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                compressThreshold = (size_t) atol(optarg) << 10;
+                break;
+            case 'v': /* time every phase */
+                verbose = true;
+                break;
+            case 'r': /* timeline of the processes */
+                tracePath = optarg;
+                break;
+            case 'k': /* select the first keys */
+                if (atoi(optarg) <= 0) { /* non-positive number */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                topK = atoi(optarg);
+                break;
+            case 'g': /* select the largest keys */
+                greatest = true;
+                break;
+            case 'q': /* select percentiles */
+                for (char *item = strtok(optarg, ","); item != NULL; item = strtok(NULL, ",")) {
+                    char *end;
+                    double percentile = strtod(item, &end);
+                    if (end == item || *end != '\0' || percentile < 0.0 || percentile > 100.0 ||
+                        nPercentiles == MAX_PERCENTILES) {
+                        if (rank == 0) {
+                            fprintf(stderr, "%s: percentiles should be up to %d numbers between 0 and 100\n",
+                                    basename(argv[0]), MAX_PERCENTILES);
+                            printUsage(basename(argv[0]));
+                        }
+                        MPI_Finalize();
+                        exit(EXIT_FAILURE);
+                    }
+                    percentiles[nPercentiles++] = percentile;
+                }
+                break;
+            case 'b': /* batch manifest */
+                manifest = optarg;
+                break;
+            case 'j': /* largest small file of a batch */
+                if (atol(optarg) <= 0) { /* non-positive number */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                smallBytes = (size_t) atol(optarg) << 10;
+                break;
+            case 'u': /* processes per group sorting the small files of a batch */
+                if (atoi(optarg) <= 0 || (atoi(optarg) & (atoi(optarg) - 1)) != 0) { /* not a power of 2 */
+                    if (rank == 0) {
+                        fprintf(stderr, "%s: the number of processes per group should be a power of 2\n",
+                                basename(argv[0]));
+                        printUsage(basename(argv[0]));
+                    }
+                    MPI_Finalize();
+                    exit(EXIT_FAILURE);
+                }
+                groupSize = atoi(optarg);
+                break;
             case 'h': /* help mode */
                 if (rank == 0) {
                     printUsage(basename(argv[0]));
@@ -127,118 +387,691 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    FILE *fp;
+    selecting = (topK > 0 || nPercentiles > 0);
+    if ((filepath == NULL) == (manifest == NULL)) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: either a file name or a manifest is required\n", basename(argv[0]));
+            printUsage(basename(argv[0]));
+        }
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    if (manifest != NULL && (outpath != NULL || permpath != NULL)) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: the output files of a batch are given in its manifest\n", basename(argv[0]));
+            printUsage(basename(argv[0]));
+        }
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    if (manifest != NULL && nProcesses % groupSize != 0) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: the number of processes should be a multiple of the processes per group\n",
+                    basename(argv[0]));
+        }
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    if (selecting && algorithm == EXTERNAL_SORT) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: the selection of keys is not available with the external sort\n", basename(argv[0]));
+        }
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    if (algorithm == BITONIC_SORT && !selecting && (nProcesses & (nProcesses - 1)) != 0) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: the bitonic sort requires a power of 2 number of processes\n", basename(argv[0]));
+        }
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+
+    options.cmdName = basename(argv[0]);
+    options.algorithm = algorithm;
+    options.loadMode = loadMode;
+    options.storeMode = storeMode;
+    options.memoryMB = memoryMB;
+    options.scratchDir = scratchDir;
+    options.hugePages = hugePages;
+    options.nSegments = nSegments;
+    options.compressThreshold = compressThreshold;
+    options.verbose = verbose;
+    options.topK = topK;
+    options.greatest = greatest;
+    memcpy(options.percentiles, percentiles, nPercentiles * sizeof(double));
+    options.nPercentiles = nPercentiles;
+
+    trace_init(tracePath != NULL, MPI_COMM_WORLD);
+    if (nThreads > 1) { /* one pool for every list file */
+        if ((pool = create_thread_pool(nThreads)) == NULL) {
+            fprintf(stderr, "error on creating the thread pool\n");
+            MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+        }
+    }
+    if (manifest != NULL) {
+        status = run_batch(manifest, &options, &buffers, pool, smallBytes, groupSize, MPI_COMM_WORLD)
+                 ? EXIT_SUCCESS : EXIT_FAILURE;
+    } else {
+        status = (process_file(filepath, outpath, permpath, &options, &buffers, pool, MPI_COMM_WORLD) ==
+                  FILE_INVALID) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    trace_write(tracePath, MPI_COMM_WORLD);
+
+    if (pool != NULL) {
+        destroy_thread_pool(pool);
+    }
+    free_list_buffer(&buffers.pairs);
+    free_list_buffer(&buffers.block);
+    free_list_buffer(&buffers.list);
+    MPI_Finalize();
+    exit(status);
+}
+
+/**
+ *  \brief Sort (or select the keys of) one list file.
+ *
+ *  Every process of the communicator must call this function with the same arguments. The root (rank 0)
+ *  reads the header of the list file and prints the results.
+ *
+ *  \param filepath path to the list file
+ *  \param outpath file where the sorted list (or the selected keys) is written, or NULL
+ *  \param permpath file where the sorting permutation is written, or NULL
+ *  \param options settings of the run
+ *  \param buffers buffers of this process, grown as needed and kept for the next list file
+ *  \param pool thread pool of the bitonic sort, or NULL
+ *  \param comm communicator of the processes sorting the list
+ *
+ *  \return FILE_SORTED, FILE_FAILED or FILE_INVALID
+ */
+static int process_file(char *filepath, char *outpath, char *permpath, const SortOptions *options,
+                        ListBuffers *buffers, ThreadPool *pool, MPI_Comm comm) {
+    int rank, nProcesses;
+
+    char *block;
+    char *sortedBlock;
+    int sortedOffset, sortedLength;
+    ListChecksum inputChecksum = {0, 0}, outputChecksum = {0, 0};
+
+    int listLength;
+    char *sendListSeq = NULL;
+    ListHeader header;
+    const SortType *type;
+    int sortTypeId;
+    MPI_Datatype datatype;
+    size_t elementSize, bufferSize;
+    int blockOffset, blockLength;
+    bool selecting = (options->topK > 0 || options->nPercentiles > 0);
+    int event;
+    double phaseTimes[NUMBER_PHASES] = {0.0}, phaseStart;
+    long long codecBytes[2], codecStart[2]; /* bytes of the encoded transfers, before and after encoding */
+    static const char *phaseNames[NUMBER_PHASES] = {"load", "sort", "store", "verify"};
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+
     /* initialise data */
-    if (rank == 0) {  /* initialise list */
-        fp = fopen(filepath, "rb");
-        if (fread(&listLength, sizeof(int), 1, fp) != 1) {
-            if (feof(fp)) {
-                fprintf(stderr, "Unexpected end of file while reading file\n");
-                exit(EXIT_FAILURE);
-            } else if (ferror(fp)) {
-                fprintf(stderr, "Error while reading file\n");
-                exit(EXIT_FAILURE);
+    if (rank == 0 && !read_list_header(filepath, &header)) {
+        header.listLength = -1;
+    }
+    MPI_Bcast(&header, sizeof(ListHeader), MPI_BYTE, 0, comm);
+    if (header.listLength < 0) {
+        return FILE_INVALID;
+    }
+    type = get_sort_type(header.typeId);
+    if (permpath != NULL && (selecting || options->algorithm == EXTERNAL_SORT)) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: the permutation is only computed by the bitonic and sample sorts\n",
+                    options->cmdName);
+        }
+        return FILE_INVALID;
+    }
+    if (permpath != NULL && outpath != NULL && (header.typeId == TYPE_REC16 || header.typeId == TYPE_REC32)) {
+        if (rank == 0) { /* the pairs carry the index instead of the payload */
+            fprintf(stderr, "%s: the sorted records cannot be written along with their permutation\n",
+                    options->cmdName);
+        }
+        return FILE_INVALID;
+    }
+    sortTypeId = (permpath != NULL) ? TYPE_PAIR : header.typeId; /* argsort: sort (key, index) pairs */
+    datatype = get_mpi_datatype(sortTypeId);
+    elementSize = get_sort_type(sortTypeId)->size;
+    bufferSize = (type->size > elementSize) ? type->size : elementSize; /* the buffers first hold the input */
+
+    if (options->algorithm == EXTERNAL_SORT) { /* the list never fits in memory: sort file to file */
+        if (outpath == NULL) {
+            if (rank == 0) {
+                fprintf(stderr, "%s: the external sort requires an output file\n", options->cmdName);
             }
+            return FILE_INVALID;
         }
-        // Allocate memory for the sequence of integers in the list
-        sendListSeq = (int*)malloc(listLength * sizeof(int));
-        // Read the sequence of integers from the binary file
-        for (int i = 0; i < listLength; i++) {
-            int* pos = (sendListSeq + i);
-            if (fread(pos, sizeof(int), 1, fp) != 1) {
-                if (feof(fp)) {
-                    fprintf(stderr, "Unexpected end of file while reading file\n");
-                    exit(EXIT_FAILURE);
-                } else if (ferror(fp)) {
-                    fprintf(stderr, "Error while reading file\n");
-                    exit(EXIT_FAILURE);
-                }
+        if (rank == 0) {
+            (void) get_delta_time();
+        }
+        bool sorted = external_sort(filepath, header, outpath, (size_t) options->memoryMB << 20,
+                                    options->scratchDir, options->compressThreshold, comm);
+        if (rank == 0) {
+            printf("\nElapsed time multi process = %.6f s\n", get_delta_time());
+            printf("file: %s\n", filepath);
+            printf("type: %s\n", type->name);
+            if (sorted) {
+                printf("Everything is ok!\n");
+            } else {
+                printf("Fail to sort list\n");
             }
+            printf("\n");
+        }
+        return sorted ? FILE_SORTED : FILE_FAILED;
+    }
+
+    if (header.listLength > INT_MAX) { /* in-memory algorithms index the list with ints */
+        if (rank == 0) {
+            fprintf(stderr, "%s: list too long to be sorted in memory, use the external sort\n", options->cmdName);
+        }
+        return FILE_INVALID;
+    }
+    listLength = (int) header.listLength;
+    if (options->nPercentiles > 0 && listLength == 0) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: there are no percentiles of an empty list\n", options->cmdName);
+        }
+        return FILE_INVALID;
+    }
+    /* the network needs 2^k elements */
+    if (options->algorithm == BITONIC_SORT && !selecting && (listLength & (listLength - 1)) != 0) {
+        if (rank == 0) {
+            fprintf(stderr, "%s: the bitonic sort requires a power of 2 list length, use the sample sort\n",
+                    options->cmdName);
         }
-        fclose(fp);
+        return FILE_INVALID;
+    }
+    get_codec_totals(&codecStart[0], &codecStart[1]);
+    phaseStart = MPI_Wtime();
+    event = trace_begin("load");
+    if (rank == 0 && options->loadMode == LOAD_BULK) {  /* initialise list */
+        if ((sendListSeq = (char *) reserve_list(&buffers->list, (size_t) listLength * type->size,
+                                                 options->hugePages)) == NULL) {
+            fprintf(stderr, "error on allocating space to the list\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        read_list(filepath, header, sendListSeq);
+    } else if (rank == 0 && options->loadMode == LOAD_MMAP) {
+        sendListSeq = (char *) load_list(filepath, header, LOAD_MMAP, options->hugePages);
+    }
+
+    if (options->algorithm == SAMPLE_SORT || selecting) {
+        get_block_range(listLength, nProcesses, rank, &blockOffset, &blockLength);
     } else {
-        fp = fopen(filepath, "rb");
-        if (fread(&listLength, sizeof(int), 1, fp) != 1) {
-            if (feof(fp)) {
-                fprintf(stderr, "Unexpected end of file while reading file\n");
-                exit(EXIT_FAILURE);
-            } else if (ferror(fp)) {
-                fprintf(stderr, "Error while reading file\n");
-                exit(EXIT_FAILURE);
+        blockLength = listLength / nProcesses;
+        blockOffset = rank * blockLength;
+    }
+    if (rank == 0 && options->loadMode != LOAD_MPIIO) { /* the share of the root is the head of the list */
+        block = sendListSeq;
+    } else {
+        if ((block = (char *) reserve_list(&buffers->block, (size_t) blockLength * bufferSize,
+                                           options->hugePages)) == NULL) {
+            fprintf(stderr, "error on allocating space to the list\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    if (options->loadMode == LOAD_MPIIO) { /* every process reads its own block, no initial scatter */
+        load_list_block(filepath, header, block, blockOffset, blockLength, comm);
+    }
+    if (permpath != NULL) { /* pack every element with its position, the pairs are sorted instead */
+        if (options->loadMode == LOAD_MPIIO) {
+            make_index_pairs(header.typeId, block, blockLength, blockOffset, (Record16 *) block);
+        } else if (rank == 0) {
+            char *pairs;
+            if ((pairs = (char *) reserve_list(&buffers->pairs, (size_t) listLength * elementSize,
+                                               options->hugePages)) == NULL) {
+                fprintf(stderr, "error on allocating space to the list\n");
+                MPI_Abort(comm, EXIT_FAILURE);
+            }
+            make_index_pairs(header.typeId, sendListSeq, listLength, 0, (Record16 *) pairs);
+            if (options->loadMode == LOAD_MMAP) {
+                release_list(sendListSeq, header, LOAD_MMAP);
+            }
+            sendListSeq = pairs;
+            block = sendListSeq;
+        }
+    }
+    phaseTimes[PHASE_LOAD] = MPI_Wtime() - phaseStart;
+    trace_end(event);
+
+    if (selecting) { /* selection of keys: the list is never sorted */
+        char *selected = NULL, *quantiles;
+        int selectedLength = 0;
+        FILE *fp = stdout;
+
+        if ((quantiles = (char *) malloc((options->nPercentiles > 0 ? options->nPercentiles : 1) *
+                                         elementSize)) == NULL) {
+            fprintf(stderr, "error on allocating space to the percentiles\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        if (rank == 0) {
+            (void) get_delta_time();
+        }
+        event = trace_begin("select");
+        if (options->loadMode != LOAD_MPIIO) {
+            int scatterEvent = trace_begin("scatter");
+            int counts[nProcesses], displs[nProcesses];
+            for (int i = 0; i < nProcesses; i++) {
+                get_block_range(listLength, nProcesses, i, &displs[i], &counts[i]);
             }
+            MPI_Scatterv(sendListSeq, counts, displs, datatype, (rank == 0) ? MPI_IN_PLACE : block,
+                         blockLength, datatype, 0, comm);
+            trace_end(scatterEvent);
         }
-        fclose(fp);
+        if (options->topK > 0) {
+            selected = (char *) select_first_distributed(header.typeId, block, blockLength, options->topK,
+                                                         !options->greatest, &selectedLength, comm);
+        }
+        for (int i = 0; i < options->nPercentiles; i++) {
+            select_position_distributed(header.typeId, block, blockLength,
+                                        get_percentile_position(options->percentiles[i], listLength),
+                                        quantiles + i * elementSize, comm);
+        }
+        trace_end(event);
+
+        if (rank == 0) {
+            double elapsed = get_delta_time();
+            if (outpath != NULL && (fp = fopen(outpath, "w")) == NULL) {
+                fprintf(stderr, "Error while opening file %s\n", outpath);
+                fp = stdout;
+            }
+            for (int i = 0; i < selectedLength; i++) {
+                type->print_key(fp, selected + i * elementSize);
+                fprintf(fp, "\n");
+            }
+            for (int i = 0; i < options->nPercentiles; i++) {
+                fprintf(fp, "p%g = ", options->percentiles[i]);
+                type->print_key(fp, quantiles + i * elementSize);
+                fprintf(fp, "\n");
+            }
+            if (fp != stdout) {
+                fclose(fp);
+            }
+            printf("\nElapsed time multi process = %.6f s\n", elapsed);
+            printf("file: %s\n", filepath);
+            printf("type: %s\n", type->name);
+            printf("\n");
+            if (options->loadMode == LOAD_MMAP) {
+                release_list(sendListSeq, header, LOAD_MMAP);
+            }
+        }
+        free(selected);
+        free(quantiles);
+        return FILE_SORTED;
     }
 
-    recListSeq = (int *) malloc(listLength * sizeof(int));
+    /* checksum of the input list, wherever it is held before the sort */
+    event = trace_begin("input checksum");
+    if (options->loadMode == LOAD_MPIIO) {
+        add_to_checksum(sortTypeId, block, blockLength, &inputChecksum);
+    } else if (rank == 0) {
+        add_to_checksum(sortTypeId, sendListSeq, listLength, &inputChecksum);
+    }
+    reduce_checksum(&inputChecksum, comm);
+    trace_end(event);
 
     /* start sorting process */
     if(rank == 0) {
         (void) get_delta_time();
     }
+    phaseStart = MPI_Wtime();
+    event = trace_begin("sort");
 
-    nProcessesNow = nProcesses;
-    presentComm = MPI_COMM_WORLD;
-    MPI_Comm_group(presentComm, &presentGroup);
-
-    nIter = (int) (log2(nProcessesNow) + 1.1);
-    for (int iter = 0; iter < nIter; iter++) {
-        seq_length = listLength / nProcessesNow;
-        if (iter > 0) {
-            MPI_Group_incl(presentGroup, nProcessesNow, gMembersId, &nextGroup);
-            MPI_Comm_create(presentComm, nextGroup, &nextComm);
-            presentGroup = nextGroup;
-            presentComm = nextComm;
-            if (rank >= nProcessesNow) {
-                free(recListSeq);
-                MPI_Finalize();
-                exit(EXIT_SUCCESS);
+    if (options->algorithm == SAMPLE_SORT) {
+        if (options->loadMode != LOAD_MPIIO) {
+            int scatterEvent = trace_begin("scatter");
+            int counts[nProcesses], displs[nProcesses];
+            for (int i = 0; i < nProcesses; i++) {
+                get_block_range(listLength, nProcesses, i, &displs[i], &counts[i]);
             }
+            MPI_Scatterv(sendListSeq, counts, displs, datatype, (rank == 0) ? MPI_IN_PLACE : block,
+                         blockLength, datatype, 0, comm);
+            trace_end(scatterEvent);
+        }
+        if ((sortedBlock = (char *) sample_sort(sortTypeId, block, blockLength, options->compressThreshold,
+                                                &sortedLength, comm)) == NULL) {
+            fprintf(stderr, "error on allocating space to the buckets\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        sortedOffset = 0;
+        MPI_Exscan(&sortedLength, &sortedOffset, 1, MPI_INT, MPI_SUM, comm);
+        if (rank == 0) {
+            sortedOffset = 0;
         }
-        MPI_Comm_size(presentComm, &nProcesses);
-        /* send: Scatter */
-        MPI_Scatter(sendListSeq, seq_length, MPI_INT,
-                    recListSeq, seq_length, MPI_INT, 0, presentComm);
-        /* sorting process */
-        bool dir = (rank % 2 == 0);
-        if (iter > 0) {
-            bitonic_merge(recListSeq, seq_length, dir);
+    } else {
+        bool merged;
+        if (options->loadMode == LOAD_MPIIO) {
+            merged = bitonic_sort_distributed(sortTypeId, block, blockLength, options->nSegments,
+                                              options->compressThreshold, pool, comm);
+        } else if (options->nSegments > 1) { /* sort the segments of the block as they arrive */
+            scatter_sorted_blocks(sortTypeId, sendListSeq, block, blockLength, options->nSegments, pool, comm);
+            merged = bitonic_merge_distributed(sortTypeId, block, blockLength, options->nSegments,
+                                               options->compressThreshold, comm);
         } else {
-            bitonic_sort(recListSeq, seq_length, dir);
+            int scatterEvent = trace_begin("scatter");
+            MPI_Scatter(sendListSeq, blockLength, datatype, (rank == 0) ? MPI_IN_PLACE : block,
+                        blockLength, datatype, 0, comm);
+            trace_end(scatterEvent);
+            merged = bitonic_sort_distributed(sortTypeId, block, blockLength, options->nSegments,
+                                              options->compressThreshold, pool, comm);
+        }
+        if (!merged) {
+            fprintf(stderr, "error on allocating space to the partner block\n");
+            MPI_Abort(comm, EXIT_FAILURE);
         }
-        /*receive: Gather */
-        MPI_Gather(recListSeq, seq_length, MPI_INT,
-                   sendListSeq, seq_length, MPI_INT, 0, presentComm);
-        nProcessesNow = nProcessesNow >> 1;
+        sortedBlock = block;
+        sortedOffset = blockOffset;
+        sortedLength = blockLength;
     }
+    phaseTimes[PHASE_SORT] = MPI_Wtime() - phaseStart;
+    trace_end(event);
+    phaseStart = MPI_Wtime();
+    event = trace_begin("store");
+    if (permpath != NULL) { /* the permutation and the sorted keys are unpacked from the pairs */
+        size_t count = (sortedLength > 0) ? sortedLength : 1;
+        char *keys = NULL;
+        int64_t *indices;
+        if (((indices = (int64_t *) malloc(count * sizeof(int64_t))) == NULL) ||
+            (outpath != NULL && (keys = (char *) malloc(count * type->size)) == NULL)) {
+            fprintf(stderr, "error on allocating space to the permutation\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        split_index_pairs(header.typeId, (Record16 *) sortedBlock, sortedLength, keys, indices);
+        store_list_block(permpath, make_list_header(TYPE_INT64, listLength), indices, sortedOffset, sortedLength,
+                         options->storeMode, comm);
+        if (outpath != NULL) {
+            store_list_block(outpath, header, keys, sortedOffset, sortedLength, options->storeMode, comm);
+        }
+        free(keys);
+        free(indices);
+    } else if (outpath != NULL) {
+        store_list_block(outpath, header, sortedBlock, sortedOffset, sortedLength, options->storeMode, comm);
+    }
+    phaseTimes[PHASE_STORE] = MPI_Wtime() - phaseStart;
+    trace_end(event);
+    MPI_Barrier(comm); /* the sort ends when the last process is done */
+    double elapsed = (rank == 0) ? get_delta_time() : 0.0;
+    phaseStart = MPI_Wtime();
+    event = trace_begin("verify");
+
+    /* every process verifies its own block of the sorted list, which is never gathered */
+    bool sorted = check_sorted_blocks(sortTypeId, sortedBlock, sortedLength, sortedOffset, comm);
+    add_to_checksum(sortTypeId, sortedBlock, sortedLength, &outputChecksum);
+    reduce_checksum(&outputChecksum, comm);
+    bool permutation = (outputChecksum.sum == inputChecksum.sum) && (outputChecksum.xor == inputChecksum.xor);
+    phaseTimes[PHASE_VERIFY] = MPI_Wtime() - phaseStart;
+    trace_end(event);
+    /* a phase lasts as long as its slowest process */
+    MPI_Reduce((rank == 0) ? MPI_IN_PLACE : phaseTimes, phaseTimes, NUMBER_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+    get_codec_totals(&codecBytes[0], &codecBytes[1]);
+    codecBytes[0] -= codecStart[0];
+    codecBytes[1] -= codecStart[1];
+    MPI_Reduce((rank == 0) ? MPI_IN_PLACE : codecBytes, codecBytes, 2, MPI_LONG_LONG, MPI_SUM, 0, comm);
 
-    free(recListSeq);
+    if (options->algorithm == SAMPLE_SORT) { /* the buckets differ in size from a list file to the next */
+        free(sortedBlock);
+    }
 
     if (rank == 0) {
-        printf("\nElapsed time multi process = %.6f s\n", get_delta_time());
+        printf("\nElapsed time multi process = %.6f s\n", elapsed);
         printf("file: %s\n", filepath);
-        bool sorted = true;
-        for (int i = 0; i < listLength - 1; i++) {
-            int num01 = sendListSeq[i];
-            int num02 = sendListSeq[i + 1];
-            if (num01 > num02) {
-                fprintf(stderr, "Error in position %d between element %d and %d\n", i, num01, num02);
-                sorted = false;
-                break;
+        printf("type: %s\n", type->name);
+        if (options->verbose) {
+            for (int i = 0; i < NUMBER_PHASES; i++) {
+                printf("phase %s = %.6f s\n", phaseNames[i], phaseTimes[i]);
+            }
+            if (codecBytes[1] > 0) {
+                printf("encoded transfers = %lld bytes instead of %lld (%.2fx)\n", codecBytes[1], codecBytes[0],
+                       (double) codecBytes[0] / (double) codecBytes[1]);
             }
         }
-        if (sorted) {
+        if (!permutation) {
+            fprintf(stderr, "The sorted list is not a permutation of the input list\n");
+        }
+        if (sorted && permutation) {
             printf("Everything is ok!\n");
         } else {
             printf("Fail to sort list\n");
         }
         printf("\n");
-        free(sendListSeq);
+        if (options->loadMode == LOAD_MMAP && permpath == NULL) {
+            release_list(sendListSeq, header, LOAD_MMAP);
+        }
+    }
+    return (sorted && permutation) ? FILE_SORTED : FILE_FAILED;
+}
+
+/**
+ *  \brief Orders the small list files of a batch by decreasing size, then by position in the manifest.
+ */
+static int compare_loads(const void *a, const void *b) {
+    const BatchLoad *x = (const BatchLoad *) a, *y = (const BatchLoad *) b;
+
+    if (x->bytes != y->bytes) {
+        return (x->bytes < y->bytes) ? 1 : -1;
     }
+    return x->index - y->index;
+}
 
+/**
+ *  \brief Reads the manifest of a batch at the root and shares its text with every process.
+ *
+ *  \param manifest path to the manifest
+ *  \param comm communicator of the processes running the batch
+ *
+ *  \return the text of the manifest, to be freed by the caller, or NULL if it cannot be read
+ */
+static char *read_manifest(char *manifest, MPI_Comm comm) {
+    int rank;
+    long length = -1;
+    char *text = NULL;
 
-    MPI_Finalize();
-    exit(EXIT_SUCCESS);
+    MPI_Comm_rank(comm, &rank);
+    if (rank == 0) {
+        FILE *fp;
+        if ((fp = fopen(manifest, "r")) == NULL || fseek(fp, 0, SEEK_END) != 0 || (length = ftell(fp)) < 0 ||
+            fseek(fp, 0, SEEK_SET) != 0 || (text = (char *) malloc(length + 1)) == NULL ||
+            fread(text, 1, length, fp) != (size_t) length) {
+            fprintf(stderr, "Error while reading manifest %s\n", manifest);
+            free(text);
+            length = -1;
+        }
+        if (fp != NULL) {
+            fclose(fp);
+        }
+    }
+    MPI_Bcast(&length, 1, MPI_LONG, 0, comm);
+    if (length < 0) {
+        return NULL;
+    }
+    if (rank != 0 && (text = (char *) malloc(length + 1)) == NULL) {
+        fprintf(stderr, "error on allocating space to the manifest\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    MPI_Bcast(text, (int) length, MPI_CHAR, 0, comm);
+    text[length] = '\0';
+    return text;
+}
+
+/**
+ *  \brief Splits the text of a manifest in list files.
+ *
+ *  Every line holds the path to a list file, optionally followed by the paths where its sorted list and
+ *  its permutation are written ("-" for none). Empty lines and lines starting with # are skipped.
+ *
+ *  \param text text of the manifest, split in place
+ *  \param nEntries number of list files found
+ *
+ *  \return the list files, to be freed by the caller
+ */
+static BatchEntry *parse_manifest(char *text, int *nEntries) {
+    int capacity = 16, n = 0;
+    char *line, *lineState;
+    BatchEntry *entries;
+
+    if ((entries = (BatchEntry *) malloc(capacity * sizeof(BatchEntry))) == NULL) {
+        fprintf(stderr, "error on allocating space to the manifest\n");
+        exit(EXIT_FAILURE);
+    }
+    for (line = strtok_r(text, "\n", &lineState); line != NULL; line = strtok_r(NULL, "\n", &lineState)) {
+        char *fields[3] = {NULL, NULL, NULL}, *fieldState;
+        int nFields = 0;
+
+        for (char *field = strtok_r(line, " \t\r", &fieldState); field != NULL && nFields < 3;
+             field = strtok_r(NULL, " \t\r", &fieldState)) {
+            fields[nFields++] = (strcmp(field, "-") == 0) ? NULL : field;
+        }
+        if (nFields == 0 || fields[0] == NULL || fields[0][0] == '#') {
+            continue;
+        }
+        if (n == capacity) {
+            capacity *= 2;
+            if ((entries = (BatchEntry *) realloc(entries, capacity * sizeof(BatchEntry))) == NULL) {
+                fprintf(stderr, "error on allocating space to the manifest\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        entries[n].filepath = fields[0];
+        entries[n].outpath = fields[1];
+        entries[n].permpath = fields[2];
+        entries[n].bytes = -1;
+        entries[n].group = -1;
+        n++;
+    }
+    *nEntries = n;
+    return entries;
+}
+
+/**
+ *  \brief Sort the list files of a manifest, in the same MPI job.
+ *
+ *  Every process of the communicator must call this function. The lists larger than smallBytes are sorted
+ *  one after the other by every process. The smaller ones are spread over groups of groupSize processes,
+ *  split from the communicator once, which sort their share concurrently: a small list gains little from
+ *  more processes, and several of them keep every process busy. Each list goes to the least loaded group,
+ *  in decreasing order of size. The thread pool and the buffers are shared by every list of a process.
+ *
+ *  \param manifest path to the manifest
+ *  \param options settings of the run, applied to every list file
+ *  \param buffers buffers of this process
+ *  \param pool thread pool of the bitonic sort, or NULL
+ *  \param smallBytes size of the largest list sorted by a group (0 to sort every list with every process)
+ *  \param groupSize number of processes of a group
+ *  \param comm communicator of the processes running the batch
+ *
+ *  \return true if every list file was sorted (or had its keys selected), false otherwise
+ */
+static bool run_batch(char *manifest, const SortOptions *options, ListBuffers *buffers, ThreadPool *pool,
+                      size_t smallBytes, int groupSize, MPI_Comm comm) {
+    int rank, nProcesses, nEntries, nGroups, groupRank;
+    int counts[3] = {0, 0, 0}; /* list files per outcome, FILE_* */
+    double start = MPI_Wtime();
+    char *text;
+    BatchEntry *entries;
+    MPI_Comm group = MPI_COMM_NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    if ((text = read_manifest(manifest, comm)) == NULL) {
+        return false;
+    }
+    entries = parse_manifest(text, &nEntries);
+
+    /* the sizes of the lists are read once, by the root */
+    long bytes[nEntries > 0 ? nEntries : 1];
+    for (int i = 0; i < nEntries; i++) {
+        ListHeader header;
+        bytes[i] = -1;
+        if (rank == 0 && is_file_open(entries[i].filepath) && read_list_header(entries[i].filepath, &header)) {
+            bytes[i] = header.listLength * (long) get_sort_type(header.typeId)->size;
+        }
+    }
+    MPI_Bcast(bytes, nEntries, MPI_LONG, 0, comm);
+
+    /* every process assigns the small lists to the groups in the same way */
+    nGroups = nProcesses / groupSize;
+    if (smallBytes > 0) {
+        BatchLoad loads[nEntries > 0 ? nEntries : 1];
+        long groupLoads[nGroups];
+        int nLoads = 0;
+
+        for (int i = 0; i < nEntries; i++) {
+            entries[i].bytes = bytes[i];
+            if (bytes[i] >= 0 && (size_t) bytes[i] <= smallBytes) {
+                loads[nLoads].bytes = bytes[i];
+                loads[nLoads++].index = i;
+            }
+        }
+        qsort(loads, nLoads, sizeof(BatchLoad), compare_loads);
+        memset(groupLoads, 0, sizeof(groupLoads));
+        for (int i = 0; i < nLoads; i++) {
+            int lightest = 0;
+            for (int g = 1; g < nGroups; g++) {
+                if (groupLoads[g] < groupLoads[lightest]) {
+                    lightest = g;
+                }
+            }
+            entries[loads[i].index].group = lightest;
+            groupLoads[lightest] += loads[i].bytes;
+        }
+        MPI_Comm_split(comm, rank / groupSize, rank, &group);
+    } else {
+        for (int i = 0; i < nEntries; i++) {
+            entries[i].bytes = bytes[i];
+        }
+    }
+
+    /* the large lists, with every process */
+    for (int i = 0; i < nEntries; i++) {
+        int outcome;
+        if (entries[i].bytes < 0) {
+            if (rank == 0) {
+                fprintf(stderr, "%s: file %s cannot be open.\n", options->cmdName, entries[i].filepath);
+                counts[FILE_INVALID]++;
+            }
+            continue;
+        }
+        if (entries[i].group >= 0) {
+            continue;
+        }
+        outcome = process_file(entries[i].filepath, entries[i].outpath, entries[i].permpath, options, buffers,
+                               pool, comm);
+        if (rank == 0) {
+            counts[outcome]++;
+        }
+    }
+
+    /* the small lists, every group with its own share */
+    if (group != MPI_COMM_NULL) {
+        MPI_Comm_rank(group, &groupRank);
+        for (int i = 0; i < nEntries; i++) {
+            int outcome;
+            if (entries[i].group != rank / groupSize) {
+                continue;
+            }
+            outcome = process_file(entries[i].filepath, entries[i].outpath, entries[i].permpath, options,
+                                   buffers, pool, group);
+            if (groupRank == 0) {
+                counts[outcome]++;
+            }
+        }
+        MPI_Comm_free(&group);
+    }
+
+    fflush(stdout); /* the reports of the groups come before the summary */
+    MPI_Allreduce(MPI_IN_PLACE, counts, 3, MPI_INT, MPI_SUM, comm);
+    if (rank == 0) {
+        printf("Batch of %d files: %d sorted, %d failed, %d invalid\n", nEntries, counts[FILE_SORTED],
+               counts[FILE_FAILED], counts[FILE_INVALID]);
+        printf("Elapsed time of the batch = %.6f s\n", MPI_Wtime() - start);
+    }
+    free(entries);
+    free(text);
+    return counts[FILE_FAILED] == 0 && counts[FILE_INVALID] == 0;
 }
 
 /**
@@ -249,10 +1082,36 @@ int main(int argc, char *argv[]) {
  *  \param cmdName string with the name of the command
  */
 static void printUsage(char *cmdName) {
-    fprintf(stderr, "\nSynopsis: %s OPTIONS [-f filename / -w number of workers / -h help]\n"
+    fprintf(stderr, "\nSynopsis: %s OPTIONS [-f filename / -a algorithm / -l loading mode / -o output filename /\n"
+                    "         -i permutation filename / -w storing mode / -t number of threads / -m memory /\n"
+                    "         -s scratch directory / -p huge pages / -n number of segments /\n"
+                    "         -c compression threshold / -v verbose / -r trace filename / -k number of keys /\n"
+                    "         -g greatest keys / -q percentiles / -b manifest / -j small file size /\n"
+                    "         -u processes per group / -h help]\n"
                     "  OPTIONS:\n"
                     "  -f      --- filename to process\n"
-                    "  -w      --- number of workers\n"
+                    "  -a      --- sorting algorithm: bitonic (default), sample or external (out-of-core)\n"
+                    "  -l      --- loading mode: bulk (default), mmap or mpiio\n"
+                    "  -o      --- file where the sorted list (or the selected keys, as text) is written\n"
+                    "  -i      --- file where the sorting permutation (64-bit positions in the input list) is written\n"
+                    "  -w      --- storing mode: mpiio (default) or mmap (single node only)\n"
+                    "  -t      --- number of threads per process for the bitonic sort (default 1)\n"
+                    "  -m      --- memory budget per process of the external sort, in MiB (default 512)\n"
+                    "  -s      --- scratch directory of the external sort (default /tmp)\n"
+                    "  -p      --- place the lists in buffers backed by huge pages\n"
+                    "  -n      --- number of segments in which the bitonic sort pipelines its transfers (default 1)\n"
+                    "  -c      --- send the sorted runs of integer keys of at least the given KiB delta encoded and\n"
+                    "              bit-packed (default: never)\n"
+                    "  -v      --- print the time of every phase (load, sort, store and verify)\n"
+                    "  -r      --- file where the timeline of the processes is written (Chrome trace JSON)\n"
+                    "  -k      --- select the given number of smallest keys instead of sorting the list\n"
+                    "  -g      --- select the largest keys instead of the smallest ones\n"
+                    "  -q      --- select the given comma-separated percentiles instead of sorting the list\n"
+                    "  -b      --- manifest of list files sorted in the same run, one per line: input file,\n"
+                    "              optionally followed by the output and permutation files (- for none)\n"
+                    "  -j      --- size in KiB of the largest list of a batch sorted by a group of processes\n"
+                    "              (default: every list is sorted by every process)\n"
+                    "  -u      --- number of processes of a group sorting the small lists of a batch (default 1)\n"
                     "  -h      --- print this help\n",
             cmdName);
 }
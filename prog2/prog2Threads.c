@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <string.h>
+#include <libgen.h>
+#include <limits.h>
+#include <time.h>
+
+#include "sorting.h"
+#include "listIO.h"
+#include "verifyList.h"
+#include "threadPool.h"
+
+/** \brief sorting algorithms */
+#define BITONIC_SORT 0
+#define SAMPLE_SORT  1
+
+/** \brief phases of a run timed by the -v option */
+#define PHASE_LOAD    0
+#define PHASE_SORT    1
+#define PHASE_STORE   2
+#define PHASE_VERIFY  3
+#define NUMBER_PHASES 4
+
+/** \brief runs of a list sorted by the threads of the pool, before they are merged */
+typedef struct RunTask
+{
+    const SortType *type;
+    char *list;
+    int length;
+} RunTask;
+
+/** \brief print proper use of the program parameters and arguments */
+static void printUsage(char *cmdName);
+
+/** \brief sort the run of a list assigned to a thread of the pool */
+static void sort_run_task(void *arg, int threadId, int nThreads);
+
+/**
+ *  \brief Get the wall clock time, in seconds.
+ *
+ *  \return time elapsed since an arbitrary point
+ */
+static double get_wall_time(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + 1.0e-9 * (double) now.tv_nsec;
+}
+
+/**
+ *  \brief Process execution, with the threads of a single process instead of MPI processes.
+ *
+ *  Same command line and output as prog2, for the options that do not need several processes, so the
+ *  times of both builds can be compared. The whole list stays in one buffer shared by the threads:
+ *
+ *  1 - Process the arguments from the command line.
+ *
+ *  2 - Load the list.
+ *
+ *  3 - Sort it: the bitonic sort runs the network over the whole list with the thread pool; the sample
+ *  sort has every thread sort a run of the list, and the runs are merged with a loser tree.
+ *
+ *  4 - Store, verify and print the results.
+ *
+ *  \param argc number of arguments in the command line
+ *  \param argv list of arguments in the command line
+ *
+ *  \return status of operation
+ */
+int main(int argc, char *argv[]) {
+    int listLength;
+    char *list;
+    ListHeader header;
+    const SortType *type;
+    ListChecksum inputChecksum = {0, 0}, outputChecksum = {0, 0};
+    char *filepath = NULL;
+    int algorithm = BITONIC_SORT;
+    int loadMode = LOAD_BULK;
+    char *outpath = NULL;
+    int nThreads = 1;
+    bool hugePages = false;
+    bool verbose = false;
+    double phaseTimes[NUMBER_PHASES] = {0.0}, phaseStart;
+    static const char *phaseNames[NUMBER_PHASES] = {"load", "sort", "store", "verify"};
+    ThreadPool *pool = NULL;
+
+    /* process command line options */
+    int opt; /* selected option */
+    do {
+        switch ((opt = getopt(argc, argv, "f:a:l:o:i:w:t:m:s:pn:c:vr:k:gq:b:j:u:h"))) {
+            case 'f':                 /* file */
+                if (optarg[0] == '-') /* filename is missing */
+                {
+                    fprintf(stderr, "%s: file name is missing\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                if (!is_file_open(optarg)) {
+                    fprintf(stderr, "%s: file %s cannot be open.\n", basename(argv[0]), optarg);
+                    exit(EXIT_FAILURE);
+                }
+                filepath = optarg;
+                break;
+            case 'a': /* sorting algorithm */
+                if (strcmp(optarg, "bitonic") == 0) {
+                    algorithm = BITONIC_SORT;
+                } else if (strcmp(optarg, "sample") == 0) {
+                    algorithm = SAMPLE_SORT;
+                } else if (strcmp(optarg, "external") == 0) {
+                    fprintf(stderr, "%s: the external sort is only available in the MPI build\n", basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                } else {
+                    fprintf(stderr, "%s: unknown algorithm %s\n", basename(argv[0]), optarg);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'l': /* loading mode */
+                if (strcmp(optarg, "bulk") == 0) {
+                    loadMode = LOAD_BULK;
+                } else if (strcmp(optarg, "mmap") == 0) {
+                    loadMode = LOAD_MMAP;
+                } else if (strcmp(optarg, "mpiio") == 0) {
+                    fprintf(stderr, "%s: MPI-IO is only available in the MPI build\n", basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                } else {
+                    fprintf(stderr, "%s: unknown loading mode %s\n", basename(argv[0]), optarg);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'o': /* output file */
+                if (optarg[0] == '-') /* filename is missing */
+                {
+                    fprintf(stderr, "%s: output file name is missing\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                outpath = optarg;
+                break;
+            case 'w': /* storing mode: a single process always writes the whole list */
+                if (strcmp(optarg, "mpiio") != 0 && strcmp(optarg, "mmap") != 0) {
+                    fprintf(stderr, "%s: unknown storing mode %s\n", basename(argv[0]), optarg);
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 't': /* number of threads */
+                if (atoi(optarg) <= 0) { /* non-positive number */
+                    fprintf(stderr, "%s: non positive number\n", basename(argv[0]));
+                    printUsage(basename(argv[0]));
+                    exit(EXIT_FAILURE);
+                }
+                nThreads = atoi(optarg);
+                break;
+            case 'p': /* huge pages */
+                hugePages = true;
+                break;
+            case 'v': /* time every phase */
+                verbose = true;
+                break;
+            case 'h': /* help mode */
+                printUsage(basename(argv[0]));
+                exit(EXIT_SUCCESS);
+            case '?': /* invalid option */
+                fprintf(stderr, "%s: invalid option\n", basename(argv[0]));
+                printUsage(basename(argv[0]));
+                exit(EXIT_FAILURE);
+            case -1:
+                break;
+            default: /* options of the MPI build only */
+                fprintf(stderr, "%s: option -%c is only available in the MPI build\n", basename(argv[0]), opt);
+                exit(EXIT_FAILURE);
+        }
+    } while (opt != -1);
+    if (optind < argc || filepath == NULL) {
+        fprintf(stderr, "%s: invalid format\n", basename(argv[0]));
+        printUsage(basename(argv[0]));
+        exit(EXIT_FAILURE);
+    }
+
+    /* initialise data */
+    if (!read_list_header(filepath, &header)) {
+        exit(EXIT_FAILURE);
+    }
+    type = get_sort_type(header.typeId);
+    if (header.listLength > INT_MAX) { /* the engine indexes the list with ints */
+        fprintf(stderr, "%s: list too long to be sorted in memory\n", basename(argv[0]));
+        exit(EXIT_FAILURE);
+    }
+    listLength = (int) header.listLength;
+    /* the network needs 2^k elements */
+    if (algorithm == BITONIC_SORT && (listLength & (listLength - 1)) != 0) {
+        fprintf(stderr, "%s: the bitonic sort requires a power of 2 list length, use the sample sort\n",
+                basename(argv[0]));
+        exit(EXIT_FAILURE);
+    }
+    phaseStart = get_wall_time();
+    if (loadMode == LOAD_MMAP) {
+        list = (char *) load_list(filepath, header, LOAD_MMAP, hugePages);
+    } else {
+        if ((list = (char *) alloc_list((size_t) listLength * type->size, hugePages)) == NULL) {
+            fprintf(stderr, "error on allocating space to the list\n");
+            exit(EXIT_FAILURE);
+        }
+        read_list(filepath, header, list);
+    }
+    phaseTimes[PHASE_LOAD] = get_wall_time() - phaseStart;
+    if (nThreads > 1 && (pool = create_thread_pool(nThreads)) == NULL) {
+        fprintf(stderr, "error on creating the thread pool\n");
+        exit(EXIT_FAILURE);
+    }
+    add_to_checksum(header.typeId, list, listLength, &inputChecksum);
+
+    /* start sorting process */
+    (void) get_delta_time();
+    phaseStart = get_wall_time();
+    if (algorithm == SAMPLE_SORT) {
+        RunTask task = {type, list, listLength};
+        int nRuns = (pool != NULL) ? nThreads : 1;
+        int runOffsets[nRuns], runLength;
+        if (pool != NULL) {
+            run_thread_pool(pool, sort_run_task, &task);
+        } else {
+            sort_run_task(&task, 0, 1);
+        }
+        for (int i = 0; i < nRuns; i++) {
+            get_block_range(listLength, nRuns, i, &runOffsets[i], &runLength);
+        }
+        if (!type->merge_runs(list, listLength, runOffsets, nRuns)) {
+            fprintf(stderr, "error on allocating space to merge the runs\n");
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        type->bitonic_sort_mt(list, listLength, true, pool);
+    }
+    phaseTimes[PHASE_SORT] = get_wall_time() - phaseStart;
+    phaseStart = get_wall_time();
+    if (outpath != NULL) {
+        store_list(outpath, header, list);
+    }
+    phaseTimes[PHASE_STORE] = get_wall_time() - phaseStart;
+    double elapsed = get_delta_time();
+    phaseStart = get_wall_time();
+
+    bool sorted = check_sorted_list(header.typeId, list, listLength, 0);
+    add_to_checksum(header.typeId, list, listLength, &outputChecksum);
+    bool permutation = (outputChecksum.sum == inputChecksum.sum) && (outputChecksum.xor == inputChecksum.xor);
+    phaseTimes[PHASE_VERIFY] = get_wall_time() - phaseStart;
+
+    printf("\nElapsed time multi process = %.6f s\n", elapsed);
+    printf("file: %s\n", filepath);
+    printf("type: %s\n", type->name);
+    if (verbose) {
+        for (int i = 0; i < NUMBER_PHASES; i++) {
+            printf("phase %s = %.6f s\n", phaseNames[i], phaseTimes[i]);
+        }
+    }
+    if (!permutation) {
+        fprintf(stderr, "The sorted list is not a permutation of the input list\n");
+    }
+    if (sorted && permutation) {
+        printf("Everything is ok!\n");
+    } else {
+        printf("Fail to sort list\n");
+    }
+    printf("\n");
+
+    if (pool != NULL) {
+        destroy_thread_pool(pool);
+    }
+    if (loadMode == LOAD_MMAP) {
+        release_list(list, header, LOAD_MMAP);
+    } else {
+        free(list);
+    }
+    exit(EXIT_SUCCESS);
+}
+
+/**
+ *  \brief Sort the run of a list assigned to a thread of the pool.
+ *
+ *  \param arg the RunTask of the list
+ *  \param threadId index of the thread, which sorts the run of the same index
+ *  \param nThreads number of threads, and of runs
+ */
+static void sort_run_task(void *arg, int threadId, int nThreads) {
+    RunTask *task = (RunTask *) arg;
+    int offset, length;
+
+    get_block_range(task->length, nThreads, threadId, &offset, &length);
+    if (!task->type->merge_sort(task->list + (size_t) offset * task->type->size, length)) {
+        fprintf(stderr, "error on allocating space to sort a run\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ *  \brief Print command usage.
+ *
+ *  A message specifying how the program should be called is printed.
+ *
+ *  \param cmdName string with the name of the command
+ */
+static void printUsage(char *cmdName) {
+    fprintf(stderr, "\nSynopsis: %s OPTIONS [-f filename / -a algorithm / -l loading mode / -o output filename /\n"
+                    "         -w storing mode / -t number of threads / -p huge pages / -v verbose / -h help]\n"
+                    "  OPTIONS:\n"
+                    "  -f      --- filename to process\n"
+                    "  -a      --- sorting algorithm: bitonic (default) or sample (runs sorted by the threads and\n"
+                    "              merged)\n"
+                    "  -l      --- loading mode: bulk (default) or mmap\n"
+                    "  -o      --- file where the sorted list is written\n"
+                    "  -w      --- storing mode, accepted for compatibility: the list is written by one thread\n"
+                    "  -t      --- number of threads (default 1)\n"
+                    "  -p      --- place the list in a buffer backed by huge pages\n"
+                    "  -v      --- print the time of every phase (load, sort, store and verify)\n"
+                    "  -h      --- print this help\n"
+                    "  The other options of prog2 need several processes and are only available in the MPI build.\n",
+            cmdName);
+}
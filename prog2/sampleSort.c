@@ -0,0 +1,444 @@
+/**
+ *  \file sampleSort.c (definition file)
+ *  \brief Sample Sort Algorithm Implementation.
+ *
+ *  Regular sampling sort (PSRS): every process sorts its block, contributes regular samples from which
+ *  the splitters are chosen, redistributes its block with a single all-to-all exchange and merges the
+ *  sorted runs it received. Runs of integer keys above a size threshold are exchanged delta encoded and
+ *  bit-packed (see wireCodec.c).
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+#include <limits.h>
+
+#include "sampleSort.h"
+#include "listIO.h"
+#include "trace.h"
+#include "wireCodec.h"
+
+/**
+ * \brief Chooses the splitters of a distributed list from the samples contributed by every process.
+ *
+ * The samples are gathered and sorted at the root process, which picks nProcesses - 1 regularly spaced
+ * splitters and broadcasts them.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param samples The samples contributed by this process.
+ * \param nLocalSamples The number of samples contributed by this process.
+ * \param splitters Buffer for the nProcesses - 1 splitters.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return number of splitters chosen (nProcesses - 1, or 0 if no process contributed samples).
+ */
+int select_splitters(int typeId, const void *samples, int nLocalSamples, void *splitters, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    MPI_Datatype datatype = get_mpi_datatype(typeId);
+    size_t size = type->size;
+    int rank, nProcesses, root = 0;
+    int nAllSamples = 0, nSplitters;
+    int *counts, *displs;
+    char *allSamples = NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    if ((counts = (int *) malloc(2 * nProcesses * sizeof(int))) == NULL) {
+        fprintf(stderr, "select_splitters(): error while allocating memory for the sample counts\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    displs = counts + nProcesses;
+
+    MPI_Gather(&nLocalSamples, 1, MPI_INT, counts, 1, MPI_INT, root, comm);
+    if (rank == root) {
+        for (int i = 0; i < nProcesses; i++) {
+            displs[i] = nAllSamples;
+            nAllSamples += counts[i];
+        }
+        if ((allSamples = (char *) malloc((nAllSamples + 1) * size)) == NULL) {
+            fprintf(stderr, "select_splitters(): error while allocating memory for the samples\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    MPI_Gatherv(samples, nLocalSamples, datatype, allSamples, counts, displs, datatype, root, comm);
+
+    if (rank == root) {
+        if (!type->merge_sort(allSamples, nAllSamples)) {
+            fprintf(stderr, "select_splitters(): error while allocating memory for the sort of the samples\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        for (int i = 0; i < nProcesses - 1 && nAllSamples > 0; i++) {
+            long pos = (long) (i + 1) * nAllSamples / nProcesses;
+            memcpy((char *) splitters + i * size, allSamples + pos * size, size);
+        }
+        free(allSamples);
+    }
+    MPI_Bcast(&nAllSamples, 1, MPI_INT, root, comm);
+    nSplitters = (nAllSamples > 0) ? nProcesses - 1 : 0;
+    MPI_Bcast(splitters, nSplitters, datatype, root, comm);
+
+    free(counts);
+    return nSplitters;
+}
+
+/**
+ * \brief Exchanges the sorted runs of every pair of processes as bytes, the runs above the threshold encoded.
+ *
+ * Every process of the communicator must call this function, with the element counts of the exchange.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param sorted The sorted list held by this process.
+ * \param sendCounts The number of elements sent to every process.
+ * \param sendDispls The position in the list of the elements sent to every process.
+ * \param bucket Where the runs received from every process are decoded.
+ * \param recCounts The number of elements received from every process.
+ * \param recDispls The position in the bucket of the elements received from every process.
+ * \param compressThreshold The size of a run from which it is sent encoded, in bytes.
+ * \param comm The communicator of the processes taking part in the exchange.
+ */
+static void exchange_encoded_runs(int typeId, const char *sorted, const int *sendCounts, const int *sendDispls,
+                                  char *bucket, const int *recCounts, const int *recDispls,
+                                  size_t compressThreshold, MPI_Comm comm) {
+    size_t size = get_sort_type(typeId)->size;
+    int nProcesses;
+    int *sendBytes, *sendOffsets, *recBytes, *recOffsets;
+    size_t sendTotal = 0, recTotal = 0;
+    unsigned char *sendBuffer, *recBuffer;
+
+    MPI_Comm_size(comm, &nProcesses);
+    if ((sendBytes = (int *) malloc(4 * nProcesses * sizeof(int))) == NULL) {
+        fprintf(stderr, "exchange_encoded_runs(): error while allocating memory for the exchange structures\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    sendOffsets = sendBytes + nProcesses;
+    recBytes = sendOffsets + nProcesses;
+    recOffsets = recBytes + nProcesses;
+    for (int i = 0; i < nProcesses; i++) {
+        sendTotal += use_codec(typeId, sendCounts[i], compressThreshold) ? get_codec_bound(sendCounts[i])
+                                                                          : (size_t) sendCounts[i] * size;
+    }
+    if ((sendBuffer = (unsigned char *) malloc(sendTotal > 0 ? sendTotal : 1)) == NULL) {
+        fprintf(stderr, "exchange_encoded_runs(): error while allocating memory for the encoded runs\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    sendTotal = 0;
+    for (int i = 0; i < nProcesses; i++) {
+        const char *run = sorted + (size_t) sendDispls[i] * size;
+        sendOffsets[i] = (int) sendTotal;
+        if (use_codec(typeId, sendCounts[i], compressThreshold)) {
+            sendBytes[i] = (int) encode_sorted_run(typeId, run, sendCounts[i], sendBuffer + sendTotal);
+        } else {
+            sendBytes[i] = (int) ((size_t) sendCounts[i] * size);
+            memcpy(sendBuffer + sendTotal, run, sendBytes[i]);
+        }
+        sendTotal += sendBytes[i];
+    }
+    MPI_Alltoall(sendBytes, 1, MPI_INT, recBytes, 1, MPI_INT, comm);
+    for (int i = 0; i < nProcesses; i++) {
+        recOffsets[i] = (int) recTotal;
+        recTotal += recBytes[i];
+    }
+    if ((recBuffer = (unsigned char *) malloc(recTotal > 0 ? recTotal : 1)) == NULL) {
+        fprintf(stderr, "exchange_encoded_runs(): error while allocating memory for the encoded runs\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    MPI_Alltoallv(sendBuffer, sendBytes, sendOffsets, MPI_BYTE, recBuffer, recBytes, recOffsets, MPI_BYTE, comm);
+    for (int i = 0; i < nProcesses; i++) {
+        char *run = bucket + (size_t) recDispls[i] * size;
+        if (use_codec(typeId, recCounts[i], compressThreshold)) {
+            decode_sorted_run(typeId, recBuffer + recOffsets[i], recCounts[i], run);
+        } else {
+            memcpy(run, recBuffer + recOffsets[i], recBytes[i]);
+        }
+    }
+    free(recBuffer);
+    free(sendBuffer);
+    free(sendBytes);
+}
+
+/**
+ * \brief Tells whether two sorted splitters have the same key.
+ *
+ * \param type The element type of the splitters.
+ * \param splitter The first splitter.
+ * \param next The next splitter, not lower than the first one.
+ *
+ * \return true if both splitters have the same key.
+ */
+static bool same_splitter(const SortType *type, const char *splitter, const char *next) {
+    return type->lower_bound(splitter, 1, next) == 0;   /* the first splitter is not lower than the next one */
+}
+
+/**
+ * \brief Computes the range of a sorted list sent to every process.
+ *
+ * The elements not greater than the i-th splitter and greater than the previous one go to process i. The
+ * elements equal to a splitter are shared evenly by the processes whose ranges it bounds, the next one
+ * included, so that a key repeated over several ranges does not fill a single bucket.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param sorted The sorted list held by this process.
+ * \param length The number of elements of the list.
+ * \param splitters The splitters, as returned by select_splitters().
+ * \param nSplitters The number of splitters (if 0, every process keeps its own list).
+ * \param sendCounts Where the number of elements sent to every process is written.
+ * \param sendDispls Where the position of the first element sent to every process is written.
+ * \param comm The communicator of the processes taking part in the exchange.
+ */
+void get_bucket_ranges(int typeId, const void *sorted, int length, const void *splitters, int nSplitters,
+                       int *sendCounts, int *sendDispls, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    size_t size = type->size;
+    int rank, nProcesses;
+    int first = 0, last = 0, lo = 0, hi = 0;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    for (int i = 0, offset = 0; i < nProcesses; i++) {
+        int end;
+        if (nSplitters == 0) {
+            end = (i == rank) ? length : offset;
+        } else if (i < nSplitters) {
+            const char *splitter = (const char *) splitters + i * size;
+            if (i == 0 || !same_splitter(type, splitter - size, splitter)) { /* first of the equal splitters */
+                first = i;
+                last = i;
+                while (last + 1 < nSplitters &&
+                       same_splitter(type, splitter, (const char *) splitters + (last + 1) * size)) {
+                    last++;
+                }
+                lo = type->lower_bound(sorted, length, splitter);
+                hi = type->upper_bound(sorted, length, splitter);
+            }
+            end = lo + (int) ((long) (hi - lo) * (i - first + 1) / (last - first + 2));
+        } else {
+            end = length;
+        }
+        if (end < offset) {
+            end = offset;
+        }
+        sendDispls[i] = offset;
+        sendCounts[i] = end - offset;
+        offset = end;
+    }
+}
+
+/**
+ * \brief Sends the elements of the ranges of a sorted list to their processes and merges what was received.
+ *
+ * A process receives at most capacity elements: it takes them from the lowest ranks first, and the other
+ * elements are left in the ranges for the next call.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param sorted The sorted list held by this process.
+ * \param sendCounts The number of elements left to send to every process, as computed by get_bucket_ranges();
+ *        decreased by the elements sent.
+ * \param sendDispls The position of the first element left to send to every process; advanced past the
+ *        elements sent.
+ * \param capacity The number of elements a process receives at most (0 for no bound).
+ * \param compressThreshold The size of a run from which it is sent encoded, in bytes (0 to never encode).
+ * \param bucketLength Number of elements of the returned bucket.
+ * \param comm The communicator of the processes taking part in the exchange.
+ *
+ * \return the sorted bucket of this process, which must be freed by the caller, or NULL on every process if
+ *         any of them cannot allocate its bucket or merge it.
+ */
+void *exchange_bucket_ranges(int typeId, const void *sorted, int *sendCounts, int *sendDispls, int capacity,
+                             size_t compressThreshold, int *bucketLength, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    MPI_Datatype datatype = get_mpi_datatype(typeId);
+    size_t size = type->size;
+    int nProcesses, length, recLength;
+    bool encoded;
+    int *counts, *recCounts, *recDispls;
+    char *bucket;
+
+    MPI_Comm_size(comm, &nProcesses);
+    if ((counts = (int *) malloc(3 * nProcesses * sizeof(int))) == NULL) {
+        fprintf(stderr, "exchange_bucket_ranges(): error while allocating memory for the exchange structures\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    recCounts = counts + nProcesses;
+    recDispls = recCounts + nProcesses;
+
+    int event = trace_begin("exchange buckets");
+    MPI_Alltoall(sendCounts, 1, MPI_INT, recCounts, 1, MPI_INT, comm);
+    if (capacity > 0) { /* every process tells the others how many elements it takes from them */
+        int room = capacity;
+        for (int i = 0; i < nProcesses; i++) {
+            if (recCounts[i] > room) {
+                recCounts[i] = room;
+            }
+            room -= recCounts[i];
+        }
+        MPI_Alltoall(recCounts, 1, MPI_INT, counts, 1, MPI_INT, comm);
+    } else {
+        memcpy(counts, sendCounts, nProcesses * sizeof(int));
+    }
+    length = 0;
+    recLength = 0;
+    for (int i = 0; i < nProcesses; i++) {
+        length += counts[i];
+        recDispls[i] = recLength;
+        recLength += recCounts[i];
+    }
+    bucket = (char *) malloc((recLength > 0 ? recLength : 1) * size);
+    bool allocated = bucket != NULL;
+    MPI_Allreduce(MPI_IN_PLACE, &allocated, 1, MPI_C_BOOL, MPI_LAND, comm);
+    if (!allocated) {
+        trace_end(event);
+        free(bucket);
+        free(counts);
+        *bucketLength = 0;
+        return NULL;
+    }
+    encoded = compressThreshold > 0 && is_codec_type(typeId);
+    if (encoded) { /* the byte displacements of the encoded exchange are ints too */
+        encoded = get_codec_bound(length) <= INT_MAX && get_codec_bound(recLength) <= INT_MAX;
+        MPI_Allreduce(MPI_IN_PLACE, &encoded, 1, MPI_C_BOOL, MPI_LAND, comm);
+    }
+    if (encoded) {
+        exchange_encoded_runs(typeId, sorted, counts, sendDispls, bucket, recCounts, recDispls, compressThreshold,
+                              comm);
+    } else {
+        MPI_Alltoallv(sorted, counts, sendDispls, datatype, bucket, recCounts, recDispls, datatype, comm);
+    }
+    trace_end(event);
+    for (int i = 0; i < nProcesses; i++) {
+        sendCounts[i] -= counts[i];
+        sendDispls[i] += counts[i];
+    }
+
+    /* merge the sorted runs received from every process */
+    event = trace_begin("merge buckets");
+    bool merged = type->merge_runs(bucket, recLength, recDispls, nProcesses);
+    MPI_Allreduce(MPI_IN_PLACE, &merged, 1, MPI_C_BOOL, MPI_LAND, comm);
+    trace_end(event);
+
+    free(counts);
+    if (!merged) {
+        free(bucket);
+        *bucketLength = 0;
+        return NULL;
+    }
+    *bucketLength = recLength;
+    return bucket;
+}
+
+/**
+ * \brief Sends every element of a sorted list to the process owning its key range and merges what was received.
+ *
+ * The ranges are those of get_bucket_ranges().
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param sorted The sorted list held by this process.
+ * \param length The number of elements of the list.
+ * \param splitters The splitters, as returned by select_splitters().
+ * \param nSplitters The number of splitters (if 0, every process keeps its own list).
+ * \param compressThreshold The size of a run from which it is sent encoded, in bytes (0 to never encode).
+ * \param bucketLength Number of elements of the returned bucket.
+ * \param comm The communicator of the processes taking part in the exchange.
+ *
+ * \return the sorted bucket of this process, which must be freed by the caller, or NULL on every process if
+ *         any of them cannot allocate its bucket or merge it.
+ */
+void *exchange_buckets(int typeId, const void *sorted, int length, const void *splitters, int nSplitters,
+                       size_t compressThreshold, int *bucketLength, MPI_Comm comm) {
+    int nProcesses;
+    int *sendCounts, *sendDispls;
+    void *bucket;
+
+    MPI_Comm_size(comm, &nProcesses);
+    if ((sendCounts = (int *) malloc(2 * nProcesses * sizeof(int))) == NULL) {
+        fprintf(stderr, "exchange_buckets(): error while allocating memory for the exchange structures\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    sendDispls = sendCounts + nProcesses;
+    get_bucket_ranges(typeId, sorted, length, splitters, nSplitters, sendCounts, sendDispls, comm);
+    bucket = exchange_bucket_ranges(typeId, sorted, sendCounts, sendDispls, 0, compressThreshold, bucketLength,
+                                    comm);
+    free(sendCounts);
+    return bucket;
+}
+
+/**
+ * \brief Sorts a list distributed by the processes of a communicator with the sample sort algorithm.
+ *
+ * Every process contributes its block of the list (see get_block_range()) and gets back a sorted bucket.
+ * The buckets of the processes, taken in rank order, form the sorted list. The length of the list does
+ * not need to be a multiple of the number of processes.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The block of the list held by this process (sorted in place).
+ * \param blockLength The number of elements of the block.
+ * \param compressThreshold The size of a run from which it is sent encoded, in bytes (0 to never encode).
+ * \param sortedLength Number of elements of the returned bucket.
+ * \param comm The communicator of the processes taking part in the sort.
+ *
+ * \return the sorted bucket of this process, which must be freed by the caller, or NULL on every process if
+ *         any of them runs out of memory for its bucket.
+ */
+void *sample_sort(int typeId, void *block, int blockLength, size_t compressThreshold, int *sortedLength,
+                  MPI_Comm comm) {
+    /* local sort */
+    int event = trace_begin("local sort");
+    if (!get_sort_type(typeId)->merge_sort(block, blockLength)) {
+        fprintf(stderr, "sample_sort(): error while allocating memory for the local sort\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    trace_end(event);
+
+    return sample_sort_sorted(typeId, block, blockLength, compressThreshold, sortedLength, comm);
+}
+
+/**
+ * \brief Sorts a list distributed by the processes of a communicator with the sample sort algorithm, once
+ * every process has sorted its block, with any local sort.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The block of the list held by this process, sorted in ascending order.
+ * \param blockLength The number of elements of the block.
+ * \param compressThreshold The size of a run from which it is sent encoded, in bytes (0 to never encode).
+ * \param sortedLength Number of elements of the returned bucket.
+ * \param comm The communicator of the processes taking part in the sort.
+ *
+ * \return the sorted bucket of this process, which must be freed by the caller, or NULL on every process if
+ *         any of them runs out of memory for its bucket.
+ */
+void *sample_sort_sorted(int typeId, const void *block, int blockLength, size_t compressThreshold,
+                         int *sortedLength, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    size_t size = type->size;
+    int nProcesses, nSamples, nLocalSamples, nSplitters, event;
+    char *samples, *splitters;
+    void *bucket;
+
+    MPI_Comm_size(comm, &nProcesses);
+    nSamples = nProcesses - 1;
+    if (((splitters = (char *) malloc((nSamples + 1) * size)) == NULL) ||
+        ((samples = (char *) malloc((nSamples + 1) * size)) == NULL)) {
+        fprintf(stderr, "sample_sort(): error while allocating memory for the samples\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+
+    /* regular sampling */
+    nLocalSamples = (blockLength > 0) ? nSamples : 0;
+    for (int i = 0; i < nLocalSamples; i++) {
+        memcpy(samples + i * size, (const char *) block + ((long) (i + 1) * blockLength / nProcesses) * size,
+               size);
+    }
+
+    /* splitter selection */
+    event = trace_begin("select splitters");
+    nSplitters = select_splitters(typeId, samples, nLocalSamples, splitters, comm);
+    trace_end(event);
+
+    /* redistribution: All to all */
+    bucket = exchange_buckets(typeId, block, blockLength, splitters, nSplitters, compressThreshold, sortedLength,
+                              comm);
+
+    free(samples);
+    free(splitters);
+    return bucket;
+}
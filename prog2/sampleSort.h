@@ -0,0 +1,24 @@
+/**
+ *  \file sampleSort.h (definition file)
+ *  \brief Header file containing the declarations for the splitter-based sample sort algorithm.
+ */
+#ifndef SAMPLE_SORT_H
+#define SAMPLE_SORT_H
+
+#include <mpi.h>
+
+#include "sorting.h"
+
+extern int select_splitters(int typeId, const void *samples, int nLocalSamples, void *splitters, MPI_Comm comm);
+extern void get_bucket_ranges(int typeId, const void *sorted, int length, const void *splitters, int nSplitters,
+                              int *sendCounts, int *sendDispls, MPI_Comm comm);
+extern void *exchange_bucket_ranges(int typeId, const void *sorted, int *sendCounts, int *sendDispls, int capacity,
+                                    size_t compressThreshold, int *bucketLength, MPI_Comm comm);
+extern void *exchange_buckets(int typeId, const void *sorted, int length, const void *splitters, int nSplitters,
+                              size_t compressThreshold, int *bucketLength, MPI_Comm comm);
+extern void *sample_sort(int typeId, void *block, int blockLength, size_t compressThreshold, int *sortedLength,
+                         MPI_Comm comm);
+extern void *sample_sort_sorted(int typeId, const void *block, int blockLength, size_t compressThreshold,
+                                int *sortedLength, MPI_Comm comm);
+
+#endif /* SAMPLE_SORT_H */
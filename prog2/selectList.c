@@ -0,0 +1,249 @@
+/**
+ *  \file selectList.c (definition file)
+ *  \brief Distributed selection of elements of a list, without sorting it.
+ *
+ *  The k smallest (or largest) elements are found by every process in its own block with a partial
+ *  bitonic network, and the root keeps the k first of the candidates of every process.
+ *
+ *  The element at a given position of the sorted list (a percentile) is found with a distributed
+ *  quickselect: the pivot is the median of the medians of three of every process, every process partitions
+ *  its block around it and the counts of lower and equal elements tell which part holds the position.
+ *  Once few elements are left, they are gathered and sorted by the root.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "selectList.h"
+#include "listIO.h"
+
+/** \brief size of the flag in front of the candidate pivot exchanged by select_position_distributed() */
+#define CANDIDATE_FLAG_SIZE 8
+
+/**
+ * \brief Selects the k smallest or largest elements of a list distributed in blocks.
+ *
+ * Every process of the communicator must call this function with its block.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The block of the list held by this process.
+ * \param blockLength The number of elements of the block.
+ * \param k The number of elements to select.
+ * \param smallest Whether the smallest elements are selected (the largest ones otherwise).
+ * \param selectedLength Number of elements selected (min(k, list length)), set at the root.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return at the root (rank 0), the selected elements in ascending order (descending for the largest), to
+ * be freed by the caller; NULL at the other processes.
+ */
+void *select_first_distributed(int typeId, const void *block, int blockLength, int k, bool smallest,
+                               int *selectedLength, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    MPI_Datatype datatype = get_mpi_datatype(typeId);
+    size_t size = type->size;
+    int rank, nProcesses, nCandidates, total = 0;
+    int *counts = NULL, *displs = NULL;
+    char *candidates, *all = NULL, *selected = NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    nCandidates = (k < blockLength) ? k : blockLength;
+    if ((candidates = (char *) malloc(nCandidates > 0 ? nCandidates * size : 1)) == NULL) {
+        fprintf(stderr, "select_first_distributed(): error while allocating memory for the candidates\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    if ((nCandidates = (int) type->select_first(block, blockLength, k, smallest, candidates)) < 0) {
+        fprintf(stderr, "select_first_distributed(): error while allocating memory for the candidates\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+
+    if (rank == 0) {
+        if ((counts = (int *) malloc(2 * nProcesses * sizeof(int))) == NULL) {
+            fprintf(stderr, "select_first_distributed(): error while allocating memory for the candidates\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        displs = counts + nProcesses;
+    }
+    MPI_Gather(&nCandidates, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (rank == 0) {
+        for (int i = 0; i < nProcesses; i++) {
+            displs[i] = total;
+            total += counts[i];
+        }
+        if (((all = (char *) malloc(total > 0 ? total * size : 1)) == NULL) ||
+            ((selected = (char *) malloc(k * size)) == NULL)) {
+            fprintf(stderr, "select_first_distributed(): error while allocating memory for the candidates\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    MPI_Gatherv(candidates, nCandidates, datatype, all, counts, displs, datatype, 0, comm);
+
+    if (rank == 0) {
+        *selectedLength = (int) type->select_first(all, total, k, smallest, selected);
+        free(all);
+        free(counts);
+    }
+    free(candidates);
+    return selected;
+}
+
+/**
+ * \brief Gathers the elements left to select from at the root, which picks the one at the given position.
+ *
+ * \param type The element type of the list.
+ * \param datatype The MPI datatype of the elements.
+ * \param elements The elements left to select from in this process.
+ * \param length The number of elements left in this process.
+ * \param position The position of the element among the elements left in every process.
+ * \param element The selected element, set at the root.
+ * \param comm The communicator of the processes sharing the list.
+ */
+static void select_gathered(const SortType *type, MPI_Datatype datatype, const char *elements, int length,
+                            long position, void *element, MPI_Comm comm) {
+    size_t size = type->size;
+    int rank, nProcesses, total = 0;
+    int *counts = NULL, *displs = NULL;
+    char *all = NULL;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    if (rank == 0) {
+        if ((counts = (int *) malloc(2 * nProcesses * sizeof(int))) == NULL) {
+            fprintf(stderr, "select_position_distributed(): error while allocating memory for the elements\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        displs = counts + nProcesses;
+    }
+    MPI_Gather(&length, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (rank == 0) {
+        for (int i = 0; i < nProcesses; i++) {
+            displs[i] = total;
+            total += counts[i];
+        }
+        if ((all = (char *) malloc(total > 0 ? total * size : 1)) == NULL) {
+            fprintf(stderr, "select_position_distributed(): error while allocating memory for the elements\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    MPI_Gatherv(elements, length, datatype, all, counts, displs, datatype, 0, comm);
+    if (rank == 0) {
+        if (!type->merge_sort(all, total)) {
+            fprintf(stderr, "select_position_distributed(): error while allocating memory for the elements\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        memcpy(element, all + position * size, size);
+        free(all);
+        free(counts);
+    }
+}
+
+/**
+ * \brief Selects the element at a given position of the sorted list, from a list distributed in blocks.
+ *
+ * Every process of the communicator must call this function with its block. The blocks are reordered.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The block of the list held by this process, partitioned in place.
+ * \param blockLength The number of elements of the block.
+ * \param position The position of the element in the sorted list (0 for the smallest).
+ * \param element The selected element, set at every process.
+ * \param comm The communicator of the processes sharing the list.
+ */
+void select_position_distributed(int typeId, void *block, int blockLength, long position, void *element,
+                                 MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    MPI_Datatype datatype = get_mpi_datatype(typeId);
+    size_t size = type->size;
+    size_t candidateSize = CANDIDATE_FLAG_SIZE + size;
+    int nProcesses;
+    unsigned int lo = 0, hi = (unsigned int) blockLength;
+    char *elements = (char *) block, *mine, *candidates, *pivot;
+
+    MPI_Comm_size(comm, &nProcesses);
+    if (((mine = (char *) malloc(candidateSize)) == NULL) ||
+        ((candidates = (char *) malloc(nProcesses * candidateSize)) == NULL) ||
+        ((pivot = (char *) malloc((nProcesses > 3 ? nProcesses : 3) * size)) == NULL)) {
+        fprintf(stderr, "select_position_distributed(): error while allocating memory for the pivots\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+
+    while (true) {
+        long active = hi - lo, total, counts[2];
+        unsigned int nLess, nEqual;
+        int nPresent = 0;
+
+        MPI_Allreduce(&active, &total, 1, MPI_LONG, MPI_SUM, comm);
+        if (total <= SELECT_GATHER_LENGTH) {
+            select_gathered(type, datatype, elements + (size_t) lo * size, (int) active, position, element, comm);
+            MPI_Bcast(element, (int) size, MPI_BYTE, 0, comm);
+            break;
+        }
+
+        /* candidate of this process: median of the first, middle and last elements left */
+        memset(mine, 0, candidateSize);
+        if (active > 0) {
+            unsigned int picks[3] = {lo, lo + (hi - lo) / 2, hi - 1};
+            for (int i = 0; i < 3; i++) {
+                memcpy(pivot + i * size, elements + (size_t) picks[i] * size, size);
+            }
+            if (!type->merge_sort(pivot, 3)) {
+                fprintf(stderr, "select_position_distributed(): error while allocating memory for the pivots\n");
+                MPI_Abort(comm, EXIT_FAILURE);
+            }
+            mine[0] = 1;
+            memcpy(mine + CANDIDATE_FLAG_SIZE, pivot + size, size);
+        }
+        MPI_Allgather(mine, (int) candidateSize, MPI_BYTE, candidates, (int) candidateSize, MPI_BYTE, comm);
+        for (int i = 0; i < nProcesses; i++) {
+            if (candidates[i * candidateSize] != 0) {
+                memcpy(pivot + nPresent++ * size, candidates + i * candidateSize + CANDIDATE_FLAG_SIZE, size);
+            }
+        }
+        if (!type->merge_sort(pivot, nPresent)) {
+            fprintf(stderr, "select_position_distributed(): error while allocating memory for the pivots\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        memmove(pivot, pivot + (nPresent / 2) * size, size);
+
+        /* the pivot is an element of the list, so every round drops at least one element */
+        type->partition(elements + (size_t) lo * size, hi - lo, pivot, &nLess, &nEqual);
+        counts[0] = nLess;
+        counts[1] = nEqual;
+        MPI_Allreduce(MPI_IN_PLACE, counts, 2, MPI_LONG, MPI_SUM, comm);
+        if (position < counts[0]) {
+            hi = lo + nLess;
+        } else if (position < counts[0] + counts[1]) {
+            memcpy(element, pivot, size);
+            break;
+        } else {
+            position -= counts[0] + counts[1];
+            lo += nLess + nEqual;
+        }
+    }
+    free(pivot);
+    free(candidates);
+    free(mine);
+}
+
+/**
+ * \brief Gets the position in the sorted list of a percentile (nearest rank).
+ *
+ * \param percentile The percentile, between 0 and 100.
+ * \param listLength The number of elements of the list (positive).
+ *
+ * \return the position of the smallest element not lower than the given percent of the list.
+ */
+long get_percentile_position(double percentile, long listLength) {
+    long position = (long) ceil(percentile / 100.0 * (double) listLength) - 1;
+
+    if (position < 0) {
+        position = 0;
+    }
+    if (position >= listLength) {
+        position = listLength - 1;
+    }
+    return position;
+}
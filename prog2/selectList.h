@@ -0,0 +1,22 @@
+/**
+ *  \file selectList.h (definition file)
+ *  \brief Header file containing the declarations for the distributed selection of elements of a list.
+ */
+#ifndef SELECT_LIST_H
+#define SELECT_LIST_H
+
+#include <stdbool.h>
+#include <mpi.h>
+
+#include "sorting.h"
+
+/** \brief number of elements left to select from below which they are gathered by the root */
+#define SELECT_GATHER_LENGTH (1 << 16)
+
+extern void *select_first_distributed(int typeId, const void *block, int blockLength, int k, bool smallest,
+                                      int *selectedLength, MPI_Comm comm);
+extern void select_position_distributed(int typeId, void *block, int blockLength, long position, void *element,
+                                        MPI_Comm comm);
+extern long get_percentile_position(double percentile, long listLength);
+
+#endif /* SELECT_LIST_H */
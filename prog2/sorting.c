@@ -7,6 +7,8 @@
  *          João Reis
  */
 
+#include <string.h>
+
 #include "sorting.h"
 
 /**
@@ -61,44 +63,740 @@ bool is_file_open(char *path)
     return true;
 }
 
-void bitonic_merge(int *list, unsigned int length, bool asc) {
-    unsigned int half_len, n_pair_subseqs, m, cur_pair_subseq, inner_offset, t;
-    unsigned int idx01, idx02;
-
-    half_len = length >> 1; // length / 2
-    n_pair_subseqs = 1;
-    for (m = 0; m < (int)log2f((float)length); m++) { // for each subsequence size, such as sub_size=2^m
-        cur_pair_subseq = 0;
-        inner_offset = 0;
-        while (cur_pair_subseq < n_pair_subseqs) {
-            for (t = 0; t < half_len; t++) {
-
-                idx01 = inner_offset + t;
-                idx02 = idx01 + half_len;
-
-                // CAPS
-                if ((asc && list[idx01] > list[idx02]) || (!(asc) && list[idx01] < list[idx02])) {
-                    int tmp = list[idx01];
-                    list[idx01] = list[idx02];
-                    list[idx02] = tmp;
-                }
-            }
-            inner_offset += (half_len << 1); // offset = offset + (half_len * 2)
-            cur_pair_subseq += 1;
+/** \brief a slice of the bitonic network run by the threads of a pool */
+typedef struct NetworkTask
+{
+    void *list;
+    unsigned int length;
+    unsigned int halfLen;  /* distance between the elements compared at the current level */
+    unsigned int chunk;    /* length of the independent subsequences handed to each thread */
+    bool asc;
+} NetworkTask;
+
+/**
+ * \brief Number of independent chunks a list is split into for the threads of a pool.
+ *
+ * \param length The length of the list (a power of 2).
+ * \param pool The pool of threads, or NULL.
+ *
+ * \return largest power of 2 not greater than the number of threads, or 1 if the list is too short.
+ */
+static unsigned int get_network_chunks(unsigned int length, ThreadPool *pool) {
+    unsigned int nChunks = 1;
+
+    if (pool == NULL || length < MIN_THREADED_LENGTH) {
+        return 1;
+    }
+    while ((int) (nChunks << 1) <= get_thread_pool_size(pool) && (nChunks << 1) <= length) {
+        nChunks <<= 1;
+    }
+    return nChunks;
+}
+
+/** \brief bits of the key sorted by every pass of the radix sort */
+#define RADIX_BITS 8
+/** \brief number of buckets of a pass of the radix sort */
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/** \brief a pass of the radix sort run by the threads of a pool, each one over its own range of the list */
+typedef struct RadixTask
+{
+    const void *src;
+    void *dst;
+    unsigned int length;
+    int shift;          /* position of the digit of the pass in the key */
+    size_t *counts;     /* RADIX_BUCKETS counters per thread, then the position of their bucket in dst */
+} RadixTask;
+
+/**
+ * \brief Maps a key to an unsigned integer with the same order, for the radix sort: the sign bit of the
+ *        integers is flipped, and the negative floating point numbers have every bit flipped.
+ */
+static inline uint64_t radix_key_int32(int32_t key) {
+    return (uint32_t) key ^ 0x80000000u;
+}
+
+static inline uint64_t radix_key_int64(int64_t key) {
+    return (uint64_t) key ^ 0x8000000000000000ull;
+}
+
+static inline uint64_t radix_key_float(float key) {
+    uint32_t bits;
+    memcpy(&bits, &key, sizeof(bits));
+    return (bits & 0x80000000u) ? (uint32_t) ~bits : bits ^ 0x80000000u;
+}
+
+static inline uint64_t radix_key_double(double key) {
+    uint64_t bits;
+    memcpy(&bits, &key, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : bits ^ 0x8000000000000000ull;
+}
+
+#define RADIX_KEY(key) _Generic((key), int32_t: radix_key_int32, int64_t: radix_key_int64,              \
+                                       float: radix_key_float, double: radix_key_double)(key)
+
+/**
+ * \brief Runs a pass of the radix sort with the threads of a pool, or with the calling thread only.
+ *
+ * \param pool The pool of threads, or NULL.
+ * \param task The step of the pass.
+ * \param arg The RadixTask of the pass.
+ */
+static void run_radix_step(ThreadPool *pool, PoolTask task, RadixTask *arg) {
+    if (pool != NULL) {
+        run_thread_pool(pool, task, arg);
+    } else {
+        task(arg, 0, 1);
+    }
+}
+
+/**
+ * \brief Turns the counters of a pass of the radix sort into the position where every thread writes each
+ *        bucket, the buckets in order and, within a bucket, the threads in order, so the sort is stable.
+ *
+ * \param counts The counters, RADIX_BUCKETS per thread.
+ * \param nThreads The number of threads.
+ * \param length The length of the list.
+ *
+ * \return false if every key has the same digit, so the pass would not move any element.
+ */
+static bool prefix_radix_counts(size_t *counts, int nThreads, unsigned int length) {
+    size_t position = 0;
+
+    for (int digit = 0; digit < RADIX_BUCKETS; digit++) {
+        size_t total = 0;
+        for (int t = 0; t < nThreads; t++) {
+            total += counts[(size_t) t * RADIX_BUCKETS + digit];
+        }
+        if (total == length) {
+            return false;
+        }
+    }
+    for (int digit = 0; digit < RADIX_BUCKETS; digit++) {
+        for (int t = 0; t < nThreads; t++) {
+            size_t count = counts[(size_t) t * RADIX_BUCKETS + digit];
+            counts[(size_t) t * RADIX_BUCKETS + digit] = position;
+            position += count;
         }
-        half_len >>= 1; // half_len = half_len / 2
-        n_pair_subseqs <<= 1; // nL = nL * 2
     }
+    return true;
+}
+
+/**
+ * \brief Specialisation of the sort engine for one element type.
+ *
+ * The compare-exchange is written with selects instead of a conditional swap, so that for scalar keys it
+ * compiles to branch-free code.
+ *
+ * bitonic_merge_*() and bitonic_sort_*() require the length to be a power of 2. Their *_mt_*() variants
+ * split the network across the threads of a pool: every level of a merge is divided among the threads
+ * with a barrier between levels, until the subsequences fit in one chunk per thread and the remaining
+ * levels run without synchronisation.
+ *
+ * merge_sort_*() sorts a list of any length in ascending order (bottom-up merge sort with an auxiliary
+ * buffer of the same size). radix_sort_mt_*() does the same with a least significant digit radix sort of
+ * the keys, one byte per pass; with a pool, every thread counts and then scatters its own range of the
+ * list. merge_runs_*() merges adjacent sorted runs in a single pass, and merge_cursors_*() merges runs
+ * streamed through RunCursor windows: it stops when the output is full or a window is used up, so the
+ * caller can refill it. Both pick the next element with a loser tree of the
+ * runs, which replays a single leaf-to-root path of log2(nRuns) comparisons per element, every run being
+ * read sequentially; used up runs compare greater than any element.
+ *
+ * select_first_*() copies the k first elements of a list, in the given order, without sorting the whole
+ * list: the candidates are kept in a bitonic network of the next power of 2, and every chunk of that size
+ * is sorted in the opposite order and folded into them with one half-cleaner and one merge. partition_*()
+ * splits a list in place into the elements lower than, equal to and greater than a pivot.
+ *
+ * The functions that allocate memory do not end the process when it runs out, so a library can report it:
+ * merge_sort_*(), radix_sort_mt_*() and merge_runs_*() return false, merge_cursors_*() and select_first_*()
+ * return -1, with the list left unchanged.
+ */
+#define DEFINE_SORT_ENGINE(ID, SUFFIX, TYPE, KEY, FMT, CAST)                                             \
+    static inline void compare_exchange_##SUFFIX(TYPE *list, unsigned int idx01, unsigned int idx02,     \
+                                                 bool asc) {                                             \
+        TYPE num01 = list[idx01];                                                                        \
+        TYPE num02 = list[idx02];                                                                        \
+        bool swap = asc ? (KEY(num02) < KEY(num01)) : (KEY(num01) < KEY(num02));                         \
+        list[idx01] = swap ? num02 : num01;                                                              \
+        list[idx02] = swap ? num01 : num02;                                                              \
+    }                                                                                                    \
+                                                                                                         \
+    void bitonic_merge_##SUFFIX(TYPE *list, unsigned int length, bool asc) {                             \
+        unsigned int half_len, n_pair_subseqs, m, cur_pair_subseq, inner_offset, t;                      \
+                                                                                                         \
+        half_len = length >> 1;                                                                          \
+        n_pair_subseqs = 1;                                                                              \
+        for (m = 0; m < (unsigned int) log2f((float) length); m++) {                                     \
+            cur_pair_subseq = 0;                                                                         \
+            inner_offset = 0;                                                                            \
+            while (cur_pair_subseq < n_pair_subseqs) {                                                   \
+                for (t = 0; t < half_len; t++) {                                                         \
+                    compare_exchange_##SUFFIX(list, inner_offset + t, inner_offset + t + half_len, asc); \
+                }                                                                                        \
+                inner_offset += (half_len << 1);                                                         \
+                cur_pair_subseq += 1;                                                                    \
+            }                                                                                            \
+            half_len >>= 1;                                                                              \
+            n_pair_subseqs <<= 1;                                                                        \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    void bitonic_sort_##SUFFIX(TYPE *list, unsigned int length, bool asc) {                              \
+        unsigned int sub_size, sub_offset;                                                               \
+        bool inner_asc;                                                                                  \
+        for (sub_size = 2; sub_size < length; sub_size <<= 1) {                                          \
+            for (sub_offset = 0; sub_offset < length; sub_offset += sub_size) {                          \
+                inner_asc = (sub_offset / sub_size) % 2 == 0;                                            \
+                bitonic_merge_##SUFFIX(list + sub_offset, sub_size, inner_asc);                          \
+            }                                                                                            \
+        }                                                                                                \
+        bitonic_merge_##SUFFIX(list, length, asc);                                                       \
+    }                                                                                                    \
+                                                                                                         \
+    static void merge_level_task_##SUFFIX(void *arg, int threadId, int nThreads) {                       \
+        NetworkTask *task = (NetworkTask *) arg;                                                         \
+        TYPE *list = (TYPE *) task->list;                                                                \
+        unsigned int half_len = task->halfLen;                                                           \
+        unsigned int n_pairs = task->length >> 1;                                                        \
+        unsigned int first = (unsigned int) ((unsigned long) n_pairs * threadId / nThreads);             \
+        unsigned int last = (unsigned int) ((unsigned long) n_pairs * (threadId + 1) / nThreads);        \
+        unsigned int cur_pair_subseq = first / half_len, t = first % half_len;                           \
+                                                                                                         \
+        for (unsigned int p = first; p < last; p++) {                                                    \
+            unsigned int idx01 = cur_pair_subseq * (half_len << 1) + t;                                  \
+            compare_exchange_##SUFFIX(list, idx01, idx01 + half_len, task->asc);                         \
+            if (++t == half_len) {                                                                       \
+                t = 0;                                                                                   \
+                cur_pair_subseq++;                                                                       \
+            }                                                                                            \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    static void merge_chunks_task_##SUFFIX(void *arg, int threadId, int nThreads) {                      \
+        NetworkTask *task = (NetworkTask *) arg;                                                         \
+        TYPE *list = (TYPE *) task->list;                                                                \
+                                                                                                         \
+        for (unsigned long offset = (unsigned long) threadId * task->chunk; offset < task->length;       \
+             offset += (unsigned long) nThreads * task->chunk) {                                         \
+            bitonic_merge_##SUFFIX(list + offset, task->chunk, task->asc);                               \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    static void sort_chunks_task_##SUFFIX(void *arg, int threadId, int nThreads) {                       \
+        NetworkTask *task = (NetworkTask *) arg;                                                         \
+        TYPE *list = (TYPE *) task->list;                                                                \
+                                                                                                         \
+        for (unsigned long offset = (unsigned long) threadId * task->chunk; offset < task->length;       \
+             offset += (unsigned long) nThreads * task->chunk) {                                         \
+            bitonic_sort_##SUFFIX(list + offset, task->chunk, (offset / task->chunk) % 2 == 0);          \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    void bitonic_merge_mt_##SUFFIX(TYPE *list, unsigned int length, bool asc, ThreadPool *pool) {        \
+        NetworkTask task;                                                                                \
+        unsigned int nChunks = get_network_chunks(length, pool);                                         \
+                                                                                                         \
+        if (nChunks < 2) {                                                                               \
+            bitonic_merge_##SUFFIX(list, length, asc);                                                   \
+            return;                                                                                      \
+        }                                                                                                \
+        task.list = list;                                                                                \
+        task.length = length;                                                                            \
+        task.chunk = length / nChunks;                                                                   \
+        task.asc = asc;                                                                                  \
+        for (task.halfLen = length >> 1; (task.halfLen << 1) > task.chunk; task.halfLen >>= 1) {         \
+            run_thread_pool(pool, merge_level_task_##SUFFIX, &task);                                     \
+        }                                                                                                \
+        run_thread_pool(pool, merge_chunks_task_##SUFFIX, &task);                                        \
+    }                                                                                                    \
+                                                                                                         \
+    void bitonic_sort_mt_##SUFFIX(TYPE *list, unsigned int length, bool asc, ThreadPool *pool) {         \
+        NetworkTask task;                                                                                \
+        unsigned int nChunks = get_network_chunks(length, pool);                                         \
+        unsigned int sub_size, sub_offset;                                                               \
+                                                                                                         \
+        if (nChunks < 2) {                                                                               \
+            bitonic_sort_##SUFFIX(list, length, asc);                                                    \
+            return;                                                                                      \
+        }                                                                                                \
+        task.list = list;                                                                                \
+        task.length = length;                                                                            \
+        task.chunk = length / nChunks;                                                                   \
+        run_thread_pool(pool, sort_chunks_task_##SUFFIX, &task);                                         \
+        for (sub_size = task.chunk << 1; sub_size < length; sub_size <<= 1) {                            \
+            for (sub_offset = 0; sub_offset < length; sub_offset += sub_size) {                          \
+                bitonic_merge_mt_##SUFFIX(list + sub_offset, sub_size, (sub_offset / sub_size) % 2 == 0, \
+                                          pool);                                                         \
+            }                                                                                            \
+        }                                                                                                \
+        bitonic_merge_mt_##SUFFIX(list, length, asc, pool);                                              \
+    }                                                                                                    \
+                                                                                                         \
+    static void merge_two_##SUFFIX(const TYPE *src, TYPE *dst, unsigned int lo, unsigned int mid,        \
+                                   unsigned int hi) {                                                    \
+        unsigned int i = lo, j = mid, k = lo;                                                            \
+                                                                                                         \
+        while (i < mid && j < hi) {                                                                      \
+            dst[k++] = (KEY(src[j]) < KEY(src[i])) ? src[j++] : src[i++];                                \
+        }                                                                                                \
+        while (i < mid) {                                                                                \
+            dst[k++] = src[i++];                                                                         \
+        }                                                                                                \
+        while (j < hi) {                                                                                 \
+            dst[k++] = src[j++];                                                                         \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    bool merge_sort_##SUFFIX(TYPE *list, unsigned int length) {                                          \
+        unsigned int width, lo, mid, hi;                                                                 \
+        TYPE *src = list, *dst, *tmp, *swap;                                                             \
+                                                                                                         \
+        if (length < 2) {                                                                                \
+            return true;                                                                                 \
+        }                                                                                                \
+        if ((tmp = (TYPE *) malloc((size_t) length * sizeof(TYPE))) == NULL) {                           \
+            return false;                                                                                \
+        }                                                                                                \
+        dst = tmp;                                                                                       \
+        for (width = 1; width < length; width <<= 1) {                                                   \
+            for (lo = 0; lo < length; lo += (width << 1)) {                                              \
+                mid = (lo + width < length) ? lo + width : length;                                       \
+                hi = (lo + (width << 1) < length) ? lo + (width << 1) : length;                          \
+                merge_two_##SUFFIX(src, dst, lo, mid, hi);                                               \
+            }                                                                                            \
+            swap = src;                                                                                  \
+            src = dst;                                                                                   \
+            dst = swap;                                                                                  \
+        }                                                                                                \
+        if (src != list) {                                                                               \
+            for (lo = 0; lo < length; lo++) {                                                            \
+                list[lo] = src[lo];                                                                      \
+            }                                                                                            \
+        }                                                                                                \
+        free(tmp);                                                                                       \
+        return true;                                                                                     \
+    }                                                                                                    \
+                                                                                                         \
+    static void radix_count_task_##SUFFIX(void *arg, int threadId, int nThreads) {                       \
+        RadixTask *task = (RadixTask *) arg;                                                             \
+        const TYPE *src = (const TYPE *) task->src;                                                      \
+        size_t *counts = task->counts + (size_t) threadId * RADIX_BUCKETS;                               \
+        unsigned int first = (unsigned int) ((unsigned long) task->length * threadId / nThreads);        \
+        unsigned int last = (unsigned int) ((unsigned long) task->length * (threadId + 1) / nThreads);   \
+                                                                                                         \
+        memset(counts, 0, RADIX_BUCKETS * sizeof(size_t));                                               \
+        for (unsigned int i = first; i < last; i++) {                                                    \
+            counts[(RADIX_KEY(KEY(src[i])) >> task->shift) & (RADIX_BUCKETS - 1)]++;                     \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    static void radix_scatter_task_##SUFFIX(void *arg, int threadId, int nThreads) {                     \
+        RadixTask *task = (RadixTask *) arg;                                                             \
+        const TYPE *src = (const TYPE *) task->src;                                                      \
+        TYPE *dst = (TYPE *) task->dst;                                                                  \
+        size_t *positions = task->counts + (size_t) threadId * RADIX_BUCKETS;                            \
+        unsigned int first = (unsigned int) ((unsigned long) task->length * threadId / nThreads);        \
+        unsigned int last = (unsigned int) ((unsigned long) task->length * (threadId + 1) / nThreads);   \
+                                                                                                         \
+        for (unsigned int i = first; i < last; i++) {                                                    \
+            dst[positions[(RADIX_KEY(KEY(src[i])) >> task->shift) & (RADIX_BUCKETS - 1)]++] = src[i];    \
+        }                                                                                                \
+    }                                                                                                    \
+                                                                                                         \
+    bool radix_sort_mt_##SUFFIX(TYPE *list, unsigned int length, ThreadPool *pool) {                     \
+        RadixTask task;                                                                                  \
+        TYPE *tmp;                                                                                       \
+        const void *swap;                                                                                \
+        int nThreads;                                                                                    \
+                                                                                                         \
+        if (length < 2) {                                                                                \
+            return true;                                                                                 \
+        }                                                                                                \
+        if (length < MIN_THREADED_LENGTH) {                                                              \
+            pool = NULL;                                                                                 \
+        }                                                                                                \
+        nThreads = (pool != NULL) ? get_thread_pool_size(pool) : 1;                                      \
+        tmp = (TYPE *) malloc((size_t) length * sizeof(TYPE));                                           \
+        task.counts = (size_t *) malloc((size_t) nThreads * RADIX_BUCKETS * sizeof(size_t));             \
+        if (tmp == NULL || task.counts == NULL) {                                                        \
+            free(task.counts);                                                                           \
+            free(tmp);                                                                                   \
+            return false;                                                                                \
+        }                                                                                                \
+        task.src = list;                                                                                 \
+        task.dst = tmp;                                                                                  \
+        task.length = length;                                                                            \
+        for (task.shift = 0; task.shift < (int) (8 * sizeof(KEY(list[0]))); task.shift += RADIX_BITS) {  \
+            run_radix_step(pool, radix_count_task_##SUFFIX, &task);                                      \
+            if (!prefix_radix_counts(task.counts, nThreads, length)) {                                   \
+                continue;                                                                                \
+            }                                                                                            \
+            run_radix_step(pool, radix_scatter_task_##SUFFIX, &task);                                    \
+            swap = task.src;                                                                             \
+            task.src = task.dst;                                                                         \
+            task.dst = (void *) swap;                                                                    \
+        }                                                                                                \
+        if (task.src != list) {                                                                          \
+            memcpy(list, task.src, (size_t) length * sizeof(TYPE));                                      \
+        }                                                                                                \
+        free(task.counts);                                                                               \
+        free(tmp);                                                                                       \
+        return true;                                                                                     \
+    }                                                                                                    \
+                                                                                                         \
+    static inline bool loser_less_##SUFFIX(const RunCursor *cursors, int c01, int c02) {                 \
+        if (cursors[c01].position >= cursors[c01].length) {                                              \
+            return false;                                                                                \
+        }                                                                                                \
+        if (cursors[c02].position >= cursors[c02].length) {                                              \
+            return true;                                                                                 \
+        }                                                                                                \
+        TYPE num01 = ((const TYPE *) cursors[c01].buffer)[cursors[c01].position];                        \
+        TYPE num02 = ((const TYPE *) cursors[c02].buffer)[cursors[c02].position];                        \
+        return (KEY(num01) < KEY(num02)) || (!(KEY(num02) < KEY(num01)) && c01 < c02);                   \
+    }                                                                                                    \
+                                                                                                         \
+    static long loser_merge_##SUFFIX(RunCursor *cursors, int nCursors, TYPE *out, size_t capacity,       \
+                                     bool stopOnEmpty) {                                                 \
+        int *losers, *winners;                                                                           \
+        size_t n = 0;                                                                                    \
+                                                                                                         \
+        if (nCursors < 1) {                                                                              \
+            return 0;                                                                                    \
+        }                                                                                                \
+        if ((losers = (int *) malloc(3 * nCursors * sizeof(int))) == NULL) {                             \
+            return -1;                                                                                   \
+        }                                                                                                \
+        winners = losers + nCursors;                                                                     \
+        for (int c = 0; c < nCursors; c++) {                                                             \
+            winners[nCursors + c] = c;                                                                   \
+        }                                                                                                \
+        for (int node = nCursors - 1; node >= 1; node--) {                                               \
+            int c01 = winners[2 * node], c02 = winners[2 * node + 1];                                    \
+            bool first = loser_less_##SUFFIX(cursors, c01, c02);                                         \
+            winners[node] = first ? c01 : c02;                                                           \
+            losers[node] = first ? c02 : c01;                                                            \
+        }                                                                                                \
+        losers[0] = winners[1];                                                                          \
+        while (n < capacity) {                                                                           \
+            int winner = losers[0];                                                                      \
+            RunCursor *cursor = &cursors[winner];                                                        \
+            if (cursor->position >= cursor->length) {                                                    \
+                break;                                                                                   \
+            }                                                                                            \
+            out[n++] = ((TYPE *) cursor->buffer)[cursor->position++];                                    \
+            if (stopOnEmpty && cursor->position == cursor->length) {                                     \
+                break;                                                                                   \
+            }                                                                                            \
+            for (int node = (winner + nCursors) >> 1; node >= 1; node >>= 1) {                           \
+                if (loser_less_##SUFFIX(cursors, losers[node], winner)) {                                \
+                    int swap = losers[node];                                                             \
+                    losers[node] = winner;                                                               \
+                    winner = swap;                                                                       \
+                }                                                                                        \
+            }                                                                                            \
+            losers[0] = winner;                                                                          \
+        }                                                                                                \
+        free(losers);                                                                                    \
+        return (long) n;                                                                                 \
+    }                                                                                                    \
+                                                                                                         \
+    bool merge_runs_##SUFFIX(TYPE *list, unsigned int length, const int *runOffsets, int nRuns) {        \
+        TYPE *tmp = NULL;                                                                                \
+        RunCursor *runs;                                                                                 \
+                                                                                                         \
+        if (nRuns < 2 || length < 2) {                                                                   \
+            return true;                                                                                 \
+        }                                                                                                \
+        if (((runs = (RunCursor *) malloc(nRuns * sizeof(RunCursor))) == NULL) ||                        \
+            ((tmp = (TYPE *) malloc((size_t) length * sizeof(TYPE))) == NULL)) {                         \
+            free(runs);                                                                                  \
+            return false;                                                                                \
+        }                                                                                                \
+        for (int r = 0; r < nRuns; r++) {                                                                \
+            runs[r].buffer = list + runOffsets[r];                                                       \
+            int end = (r + 1 < nRuns) ? runOffsets[r + 1] : (int) length;                                \
+            runs[r].length = (size_t) (end - runOffsets[r]);                                             \
+            runs[r].position = 0;                                                                        \
+        }                                                                                                \
+        bool merged = loser_merge_##SUFFIX(runs, nRuns, tmp, length, false) >= 0;                        \
+        if (merged) {                                                                                    \
+            memcpy(list, tmp, (size_t) length * sizeof(TYPE));                                           \
+        }                                                                                                \
+        free(tmp);                                                                                       \
+        free(runs);                                                                                      \
+        return merged;                                                                                   \
+    }                                                                                                    \
+                                                                                                         \
+    void merge_split_##SUFFIX(const TYPE *mine, const TYPE *theirs, unsigned int length,                 \
+                              unsigned int available, TYPE *out, bool low, SplitCursor *cursor) {        \
+        unsigned int i = cursor->mine, j = cursor->theirs, k = cursor->merged;                           \
+                                                                                                         \
+        if (low) {                                                                                       \
+            while (k < length && j < available) {                                                        \
+                out[k++] = (KEY(theirs[j]) < KEY(mine[i])) ? theirs[j++] : mine[i++];                    \
+            }                                                                                            \
+        } else {                                                                                         \
+            unsigned int last = length - 1;                                                              \
+            while (k < length && j < available) {                                                        \
+                out[last - k++] = (KEY(mine[last - i]) < KEY(theirs[last - j])) ? theirs[last - j++]     \
+                                                                                 : mine[last - i++];     \
+            }                                                                                            \
+        }                                                                                                \
+        cursor->mine = i;                                                                                \
+        cursor->theirs = j;                                                                              \
+        cursor->merged = k;                                                                              \
+    }                                                                                                    \
+                                                                                                         \
+    static inline bool precedes_##SUFFIX(TYPE num01, TYPE num02, bool asc) {                             \
+        return asc ? (KEY(num01) < KEY(num02)) : (KEY(num02) < KEY(num01));                              \
+    }                                                                                                    \
+                                                                                                         \
+    long select_first_##SUFFIX(const TYPE *list, unsigned int length, unsigned int k, bool asc,          \
+                               TYPE *out) {                                                              \
+        unsigned int n = (k < length) ? k : length, width = 1, offset, i;                                \
+        TYPE *best, *chunk;                                                                              \
+                                                                                                         \
+        if (n == 0) {                                                                                    \
+            return 0;                                                                                    \
+        }                                                                                                \
+        while (width < n) {                                                                              \
+            width <<= 1;                                                                                 \
+        }                                                                                                \
+        best = (TYPE *) malloc((size_t) width * sizeof(TYPE));                                           \
+        chunk = (TYPE *) malloc((size_t) 2 * width * sizeof(TYPE));                                      \
+        if (best == NULL || chunk == NULL) {                                                             \
+            free(chunk);                                                                                 \
+            free(best);                                                                                  \
+            return -1;                                                                                   \
+        }                                                                                                \
+        if (width > length) { /* too short for a whole chunk: the list is its own candidate */           \
+            for (i = 0; i < length; i++) {                                                               \
+                chunk[i] = list[i];                                                                      \
+            }                                                                                            \
+            if (!merge_sort_##SUFFIX(chunk, length)) {                                                   \
+                free(chunk);                                                                             \
+                free(best);                                                                              \
+                return -1;                                                                               \
+            }                                                                                            \
+            for (i = 0; i < n; i++) {                                                                    \
+                out[i] = asc ? chunk[i] : chunk[length - 1 - i];                                         \
+            }                                                                                            \
+            free(chunk);                                                                                 \
+            free(best);                                                                                  \
+            return n;                                                                                    \
+        }                                                                                                \
+        for (i = 0; i < width; i++) {                                                                    \
+            best[i] = list[i];                                                                           \
+        }                                                                                                \
+        bitonic_sort_##SUFFIX(best, width, asc);                                                         \
+        /* the first half of the network of best and a reversed chunk keeps the width first of both */   \
+        for (offset = width; length - offset >= width; offset += width) {                                \
+            for (i = 0; i < width; i++) {                                                                \
+                chunk[i] = list[offset + i];                                                             \
+            }                                                                                            \
+            bitonic_sort_##SUFFIX(chunk, width, !asc);                                                   \
+            for (i = 0; i < width; i++) {                                                                \
+                best[i] = precedes_##SUFFIX(chunk[i], best[i], asc) ? chunk[i] : best[i];                \
+            }                                                                                            \
+            bitonic_merge_##SUFFIX(best, width, asc);                                                    \
+        }                                                                                                \
+        if (offset < length) { /* shorter last chunk: merge it with the candidates */                    \
+            unsigned int tail = length - offset, j = 0, b = 0;                                           \
+            TYPE *merged = chunk + width;                                                                \
+            for (i = 0; i < tail; i++) {                                                                 \
+                chunk[i] = list[offset + i];                                                             \
+            }                                                                                            \
+            if (!merge_sort_##SUFFIX(chunk, tail)) {                                                     \
+                free(chunk);                                                                             \
+                free(best);                                                                              \
+                return -1;                                                                               \
+            }                                                                                            \
+            for (i = 0; i < width; i++) {                                                                \
+                if (j < tail && precedes_##SUFFIX(asc ? chunk[j] : chunk[tail - 1 - j], best[b], asc)) { \
+                    merged[i] = asc ? chunk[j] : chunk[tail - 1 - j];                                    \
+                    j++;                                                                                 \
+                } else {                                                                                 \
+                    merged[i] = best[b++];                                                               \
+                }                                                                                        \
+            }                                                                                            \
+            for (i = 0; i < width; i++) {                                                                \
+                best[i] = merged[i];                                                                     \
+            }                                                                                            \
+        }                                                                                                \
+        for (i = 0; i < n; i++) {                                                                        \
+            out[i] = best[i];                                                                            \
+        }                                                                                                \
+        free(chunk);                                                                                     \
+        free(best);                                                                                      \
+        return n;                                                                                        \
+    }                                                                                                    \
+                                                                                                         \
+    void partition_##SUFFIX(TYPE *list, unsigned int length, const TYPE *pivot, unsigned int *nLess,     \
+                            unsigned int *nEqual) {                                                      \
+        unsigned int less = 0, i = 0, greater = length;                                                  \
+        TYPE value = *pivot, tmp;                                                                        \
+                                                                                                         \
+        while (i < greater) {                                                                            \
+            if (KEY(list[i]) < KEY(value)) {                                                             \
+                tmp = list[less];                                                                        \
+                list[less++] = list[i];                                                                  \
+                list[i++] = tmp;                                                                         \
+            } else if (KEY(value) < KEY(list[i])) {                                                      \
+                tmp = list[--greater];                                                                   \
+                list[greater] = list[i];                                                                 \
+                list[i] = tmp;                                                                           \
+            } else {                                                                                     \
+                i++;                                                                                     \
+            }                                                                                            \
+        }                                                                                                \
+        *nLess = less;                                                                                   \
+        *nEqual = greater - less;                                                                        \
+    }                                                                                                    \
+                                                                                                         \
+    long merge_cursors_##SUFFIX(RunCursor *cursors, int nCursors, TYPE *out, size_t capacity) {          \
+        return loser_merge_##SUFFIX(cursors, nCursors, out, capacity, true);                             \
+    }                                                                                                    \
+                                                                                                         \
+    static void bitonic_merge_any_##SUFFIX(void *list, unsigned int length, bool asc) {                  \
+        bitonic_merge_##SUFFIX((TYPE *) list, length, asc);                                              \
+    }                                                                                                    \
+                                                                                                         \
+    static void bitonic_sort_any_##SUFFIX(void *list, unsigned int length, bool asc) {                   \
+        bitonic_sort_##SUFFIX((TYPE *) list, length, asc);                                               \
+    }                                                                                                    \
+                                                                                                         \
+    static void bitonic_merge_mt_any_##SUFFIX(void *list, unsigned int length, bool asc,                 \
+                                              ThreadPool *pool) {                                        \
+        bitonic_merge_mt_##SUFFIX((TYPE *) list, length, asc, pool);                                     \
+    }                                                                                                    \
+                                                                                                         \
+    static void bitonic_sort_mt_any_##SUFFIX(void *list, unsigned int length, bool asc,                  \
+                                             ThreadPool *pool) {                                         \
+        bitonic_sort_mt_##SUFFIX((TYPE *) list, length, asc, pool);                                      \
+    }                                                                                                    \
+                                                                                                         \
+    static bool merge_sort_any_##SUFFIX(void *list, unsigned int length) {                               \
+        return merge_sort_##SUFFIX((TYPE *) list, length);                                               \
+    }                                                                                                    \
+                                                                                                         \
+    static bool radix_sort_mt_any_##SUFFIX(void *list, unsigned int length, ThreadPool *pool) {          \
+        return radix_sort_mt_##SUFFIX((TYPE *) list, length, pool);                                      \
+    }                                                                                                    \
+                                                                                                         \
+    static bool merge_runs_any_##SUFFIX(void *list, unsigned int length, const int *runOffsets,          \
+                                        int nRuns) {                                                     \
+        return merge_runs_##SUFFIX((TYPE *) list, length, runOffsets, nRuns);                            \
+    }                                                                                                    \
+                                                                                                         \
+    static long merge_cursors_any_##SUFFIX(RunCursor *cursors, int nCursors, void *out,                  \
+                                           size_t capacity) {                                            \
+        return merge_cursors_##SUFFIX(cursors, nCursors, (TYPE *) out, capacity);                        \
+    }                                                                                                    \
+                                                                                                         \
+    static void merge_split_any_##SUFFIX(const void *mine, const void *theirs, unsigned int length,      \
+                                         unsigned int available, void *out, bool low,                    \
+                                         SplitCursor *cursor) {                                          \
+        merge_split_##SUFFIX((const TYPE *) mine, (const TYPE *) theirs, length, available, (TYPE *) out,\
+                             low, cursor);                                                               \
+    }                                                                                                    \
+                                                                                                         \
+    static long select_first_any_##SUFFIX(const void *list, unsigned int length, unsigned int k,         \
+                                          bool asc, void *out) {                                         \
+        return select_first_##SUFFIX((const TYPE *) list, length, k, asc, (TYPE *) out);                 \
+    }                                                                                                    \
+                                                                                                         \
+    static void partition_any_##SUFFIX(void *list, unsigned int length, const void *pivot,               \
+                                       unsigned int *nLess, unsigned int *nEqual) {                      \
+        partition_##SUFFIX((TYPE *) list, length, (const TYPE *) pivot, nLess, nEqual);                  \
+    }                                                                                                    \
+                                                                                                         \
+    static int lower_bound_any_##SUFFIX(const void *list, int length, const void *key) {                 \
+        const TYPE *elements = (const TYPE *) list;                                                      \
+        int lo = 0, hi = length;                                                                         \
+                                                                                                         \
+        while (lo < hi) {                                                                                \
+            int mid = lo + ((hi - lo) >> 1);                                                             \
+            if (KEY(elements[mid]) < KEY(*(const TYPE *) key)) {                                         \
+                lo = mid + 1;                                                                            \
+            } else {                                                                                     \
+                hi = mid;                                                                                \
+            }                                                                                            \
+        }                                                                                                \
+        return lo;                                                                                       \
+    }                                                                                                    \
+                                                                                                         \
+    static int upper_bound_any_##SUFFIX(const void *list, int length, const void *key) {                 \
+        const TYPE *elements = (const TYPE *) list;                                                      \
+        int lo = 0, hi = length;                                                                         \
+                                                                                                         \
+        while (lo < hi) {                                                                                \
+            int mid = lo + ((hi - lo) >> 1);                                                             \
+            if (KEY(elements[mid]) <= KEY(*(const TYPE *) key)) {                                        \
+                lo = mid + 1;                                                                            \
+            } else {                                                                                     \
+                hi = mid;                                                                                \
+            }                                                                                            \
+        }                                                                                                \
+        return lo;                                                                                       \
+    }                                                                                                    \
+                                                                                                         \
+    static long find_unsorted_any_##SUFFIX(const void *list, long length) {                              \
+        const TYPE *elements = (const TYPE *) list;                                                      \
+                                                                                                         \
+        for (long i = 0; i < length - 1; i++) {                                                          \
+            if (KEY(elements[i + 1]) < KEY(elements[i])) {                                               \
+                return i;                                                                                \
+            }                                                                                            \
+        }                                                                                                \
+        return -1;                                                                                       \
+    }                                                                                                    \
+                                                                                                         \
+    static void print_key_any_##SUFFIX(FILE *fp, const void *element) {                                  \
+        fprintf(fp, FMT, (CAST) KEY(*(const TYPE *) element));                                           \
+    }
+
+SORT_TYPE_LIST(DEFINE_SORT_ENGINE)
+
+#define SORT_TYPE_ENTRY(ID, SUFFIX, TYPE, KEY, FMT, CAST)                                               \
+    {ID, #SUFFIX, sizeof(TYPE), bitonic_merge_any_##SUFFIX, bitonic_sort_any_##SUFFIX,                  \
+     bitonic_merge_mt_any_##SUFFIX, bitonic_sort_mt_any_##SUFFIX,                                       \
+     merge_sort_any_##SUFFIX, radix_sort_mt_any_##SUFFIX, merge_runs_any_##SUFFIX,                      \
+     merge_cursors_any_##SUFFIX, merge_split_any_##SUFFIX, select_first_any_##SUFFIX,                   \
+     partition_any_##SUFFIX, lower_bound_any_##SUFFIX, upper_bound_any_##SUFFIX,                        \
+     find_unsorted_any_##SUFFIX, print_key_any_##SUFFIX},
+
+/** \brief element types, in TYPE_* order */
+static const SortType sortTypes[NUMBER_TYPES] = {
+        SORT_TYPE_LIST(SORT_TYPE_ENTRY)
+};
+
+/**
+ * \brief Gets the description of an element type.
+ *
+ * \param typeId The identifier of the type (one of TYPE_*).
+ *
+ * \return the description of the type, or NULL if the identifier is not valid.
+ */
+const SortType *get_sort_type(int typeId) {
+    if (typeId < 0 || typeId >= NUMBER_TYPES) {
+        return NULL;
+    }
+    return &sortTypes[typeId];
 }
 
-void bitonic_sort(int *list, unsigned int length, bool asc) {
-    int sub_size, sub_offset;
-    bool inner_asc;
-    for (sub_size = 2; sub_size < length; sub_size <<= 1) { // for each subsequence size in the list
-        for (sub_offset = 0; sub_offset < length; sub_offset += sub_size) { // for each subsequence offset
-            inner_asc = (sub_offset / sub_size) % 2 == 0; // divide j by list length to discover its direction
-            bitonic_merge(list + sub_offset, sub_size, inner_asc);
+/**
+ * \brief Gets the description of an element type from its name (int32, int64, float, double, rec16, rec32).
+ *
+ * \param name The name of the type.
+ *
+ * \return the description of the type, or NULL if there is no type with that name.
+ */
+const SortType *find_sort_type(const char *name) {
+    for (int i = 0; i < NUMBER_TYPES; i++) {
+        if (strcmp(sortTypes[i].name, name) == 0) {
+            return &sortTypes[i];
         }
     }
-    bitonic_merge(list, length, asc);
+    return NULL;
 }
@@ -8,15 +8,135 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 #include <time.h>
 
-extern void bitonic_merge(int *list, unsigned int length, bool asc);
-extern void bitonic_sort(int *list, unsigned int length, bool asc);
+#include "threadPool.h"
+
+/** \brief minimum length of a list for the bitonic network to be split across threads */
+#define MIN_THREADED_LENGTH (1 << 14)
+
+/** \brief 32-bit signed integer keys (the element type of the legacy list files) */
+#define TYPE_INT32  0
+/** \brief 64-bit signed integer keys */
+#define TYPE_INT64  1
+/** \brief single precision floating point keys */
+#define TYPE_FLOAT  2
+/** \brief double precision floating point keys */
+#define TYPE_DOUBLE 3
+/** \brief 16-byte records: 64-bit key and 8-byte payload */
+#define TYPE_REC16  4
+/** \brief 32-byte records: 64-bit key and 24-byte payload */
+#define TYPE_REC32  5
+/** \brief number of element types */
+#define NUMBER_TYPES 6
+
+typedef struct Record16
+{
+    int64_t key;
+    unsigned char payload[8];
+} Record16;
+
+typedef struct Record32
+{
+    int64_t key;
+    unsigned char payload[24];
+} Record32;
+
+/** \brief window of a sorted run held in memory, for merging runs that are streamed from storage */
+typedef struct RunCursor
+{
+    void *buffer;      /* elements of the run currently in memory */
+    size_t length;     /* number of elements in the buffer */
+    size_t position;   /* next element of the buffer to be merged */
+} RunCursor;
+
+/**
+ *  \brief Progress of a compare-split merge, counted from the front of the blocks when keeping the lower
+ *  half and from their back when keeping the upper half.
+ */
+typedef struct SplitCursor
+{
+    unsigned int mine;     /* elements taken from the own block */
+    unsigned int theirs;   /* elements taken from the partner block */
+    unsigned int merged;   /* elements of the merged block produced so far */
+} SplitCursor;
+
+/** \brief key of a scalar element */
+#define KEY_SCALAR(x) (x)
+/** \brief key of a record element */
+#define KEY_RECORD(x) ((x).key)
+
+/**
+ *  \brief Element types of the sort engine.
+ *
+ *  X(identifier, suffix, C type, key accessor, printf format and cast of the key), in TYPE_* order.
+ *  Every entry gets its own specialisation of the engine, so the comparisons are inlined.
+ */
+#define SORT_TYPE_LIST(X) \
+    X(TYPE_INT32,  int32,  int32_t,  KEY_SCALAR, "%d",   int)       \
+    X(TYPE_INT64,  int64,  int64_t,  KEY_SCALAR, "%lld", long long) \
+    X(TYPE_FLOAT,  float,  float,    KEY_SCALAR, "%g",   double)    \
+    X(TYPE_DOUBLE, double, double,   KEY_SCALAR, "%g",   double)    \
+    X(TYPE_REC16,  rec16,  Record16, KEY_RECORD, "%lld", long long) \
+    X(TYPE_REC32,  rec32,  Record32, KEY_RECORD, "%lld", long long)
+
+/**
+ *  \brief Description of an element type and its specialisation of the sort engine.
+ *
+ *  The functions work on whole lists, so the indirect call happens once per list and never per
+ *  comparison.
+ */
+typedef struct SortType
+{
+    int id;
+    const char *name;
+    size_t size;
+
+    void (*bitonic_merge)(void *list, unsigned int length, bool asc);
+    void (*bitonic_sort)(void *list, unsigned int length, bool asc);
+    void (*bitonic_merge_mt)(void *list, unsigned int length, bool asc, ThreadPool *pool);
+    void (*bitonic_sort_mt)(void *list, unsigned int length, bool asc, ThreadPool *pool);
+    bool (*merge_sort)(void *list, unsigned int length);
+    bool (*radix_sort_mt)(void *list, unsigned int length, ThreadPool *pool);
+    bool (*merge_runs)(void *list, unsigned int length, const int *runOffsets, int nRuns);
+    long (*merge_cursors)(RunCursor *cursors, int nCursors, void *out, size_t capacity);
+    void (*merge_split)(const void *mine, const void *theirs, unsigned int length, unsigned int available,
+                        void *out, bool low, SplitCursor *cursor);
+    long (*select_first)(const void *list, unsigned int length, unsigned int k, bool asc, void *out);
+    void (*partition)(void *list, unsigned int length, const void *pivot, unsigned int *nLess,
+                      unsigned int *nEqual);
+    int (*lower_bound)(const void *list, int length, const void *key);
+    int (*upper_bound)(const void *list, int length, const void *key);
+    long (*find_unsorted)(const void *list, long length);
+    void (*print_key)(FILE *fp, const void *element);
+} SortType;
+
+#define DECLARE_SORT_ENGINE(ID, SUFFIX, TYPE, KEY, FMT, CAST)                                        \
+    extern void bitonic_merge_##SUFFIX(TYPE *list, unsigned int length, bool asc);                   \
+    extern void bitonic_sort_##SUFFIX(TYPE *list, unsigned int length, bool asc);                    \
+    extern void bitonic_merge_mt_##SUFFIX(TYPE *list, unsigned int length, bool asc, ThreadPool *pool); \
+    extern void bitonic_sort_mt_##SUFFIX(TYPE *list, unsigned int length, bool asc, ThreadPool *pool);  \
+    extern bool merge_sort_##SUFFIX(TYPE *list, unsigned int length);                                \
+    extern bool radix_sort_mt_##SUFFIX(TYPE *list, unsigned int length, ThreadPool *pool);           \
+    extern bool merge_runs_##SUFFIX(TYPE *list, unsigned int length, const int *runOffsets, int nRuns); \
+    extern long merge_cursors_##SUFFIX(RunCursor *cursors, int nCursors, TYPE *out, size_t capacity); \
+    extern void merge_split_##SUFFIX(const TYPE *mine, const TYPE *theirs, unsigned int length,       \
+                                     unsigned int available, TYPE *out, bool low, SplitCursor *cursor); \
+    extern long select_first_##SUFFIX(const TYPE *list, unsigned int length, unsigned int k,         \
+                                      bool asc, TYPE *out);                                          \
+    extern void partition_##SUFFIX(TYPE *list, unsigned int length, const TYPE *pivot,               \
+                                   unsigned int *nLess, unsigned int *nEqual);
+SORT_TYPE_LIST(DECLARE_SORT_ENGINE)
+#undef DECLARE_SORT_ENGINE
+
+extern const SortType *get_sort_type(int typeId);
+extern const SortType *find_sort_type(const char *name);
 
 extern void print_list(int *list, unsigned int length);
 
 extern bool is_file_open(char *path);
 extern double get_delta_time(void);
 
-#endif /* SORTING_H */
\ No newline at end of file
+#endif /* SORTING_H */
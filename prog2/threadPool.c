@@ -0,0 +1,179 @@
+/**
+ *  \file threadPool.c (definition file)
+ *  \brief Pool of worker threads of a process.
+ *
+ *  The threads are created once and kept waiting between tasks. A task is run by every thread of the
+ *  pool, including the calling thread, and run_thread_pool() returns only when all of them finished it,
+ *  so consecutive calls are separated by a barrier.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "threadPool.h"
+
+typedef struct PoolWorker
+{
+    ThreadPool *pool;
+    int id;
+} PoolWorker;
+
+struct ThreadPool
+{
+    int nThreads;
+    pthread_t *threads;
+    PoolWorker *workers;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;  /* number of tasks started so far */
+    int pending;               /* threads still running the current task */
+    bool shutdown;
+
+    PoolTask task;
+    void *arg;
+};
+
+/**
+ * \brief Life cycle of a worker thread: wait for a task, run it and signal its end.
+ *
+ * \param arg The PoolWorker of the thread.
+ */
+static void *worker_loop(void *arg) {
+    PoolWorker *worker = (PoolWorker *) arg;
+    ThreadPool *pool = worker->pool;
+    unsigned long seen = 0;
+    PoolTask task;
+    void *taskArg;
+
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        task = pool->task;
+        taskArg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        task(taskArg, worker->id, pool->nThreads);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+/**
+ * \brief Creates a pool of threads.
+ *
+ * \param nThreads The number of threads of the pool, counting the calling thread.
+ *
+ * \return the new pool, which must be released with destroy_thread_pool(), or NULL if the memory or the
+ *         threads of the pool cannot be allocated.
+ */
+ThreadPool *create_thread_pool(int nThreads) {
+    ThreadPool *pool;
+
+    if (nThreads < 1) {
+        nThreads = 1;
+    }
+    if ((pool = (ThreadPool *) calloc(1, sizeof(ThreadPool))) == NULL) {
+        return NULL;
+    }
+    pool->threads = (pthread_t *) malloc(nThreads * sizeof(pthread_t));
+    pool->workers = (PoolWorker *) malloc(nThreads * sizeof(PoolWorker));
+    if (pool->threads == NULL || pool->workers == NULL) {
+        free(pool->workers);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+    pool->nThreads = nThreads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (int i = 1; i < nThreads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_loop, &pool->workers[i]) != 0) {
+            pool->nThreads = i; /* stop the threads created so far */
+            destroy_thread_pool(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+/**
+ * \brief Runs a task on every thread of the pool and waits for all of them to finish it.
+ *
+ * \param pool The pool.
+ * \param task The task to run.
+ * \param arg The argument of the task.
+ */
+void run_thread_pool(ThreadPool *pool, PoolTask task, void *arg) {
+    if (pool->nThreads == 1) {
+        task(arg, 0, 1);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->nThreads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, 0, pool->nThreads);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * \brief Gets the number of threads of a pool.
+ *
+ * \param pool The pool.
+ *
+ * \return number of threads, counting the calling thread.
+ */
+int get_thread_pool_size(ThreadPool *pool) {
+    return pool->nThreads;
+}
+
+/**
+ * \brief Stops the threads of a pool and releases it.
+ *
+ * \param pool The pool.
+ */
+void destroy_thread_pool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->nThreads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
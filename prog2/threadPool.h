@@ -0,0 +1,20 @@
+/**
+ *  \file threadPool.h (definition file)
+ *  \brief Header file containing the declarations for the pool of worker threads of a process.
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+
+/** \brief work run by every thread of the pool: the argument, the thread index and the number of threads */
+typedef void (*PoolTask)(void *arg, int threadId, int nThreads);
+
+typedef struct ThreadPool ThreadPool;
+
+extern ThreadPool *create_thread_pool(int nThreads);
+extern void run_thread_pool(ThreadPool *pool, PoolTask task, void *arg);
+extern int get_thread_pool_size(ThreadPool *pool);
+extern void destroy_thread_pool(ThreadPool *pool);
+
+#endif /* THREAD_POOL_H */
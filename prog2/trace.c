@@ -0,0 +1,198 @@
+/**
+ *  \file trace.c (definition file)
+ *  \brief Timeline tracer of the processes.
+ *
+ *  Every process records the begin and end times of its phases, taken with MPI_Wtime() and shifted to the
+ *  clock of rank 0, in a ring of events allocated up front. At the end the events of every process are
+ *  gathered by rank 0, which writes them as a single Chrome trace (JSON), viewable in Perfetto or
+ *  chrome://tracing, with one track per rank. When tracing is disabled, recording an event costs a single
+ *  test of a flag.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+bool traceEnabled = false;
+
+/** \brief ring of events of this process */
+static TraceEvent *events;
+/** \brief number of events recorded so far (event i lives in events[i % TRACE_CAPACITY]) */
+static int nEvents;
+/** \brief difference between the clock of rank 0 and the clock of this process */
+static double clockOffset;
+
+/**
+ * \brief Enables or disables the tracer and aligns the clock of every process to the clock of rank 0.
+ *
+ * Every process of the communicator must call this function. The offset of every clock is estimated from
+ * a round trip to rank 0, unless the MPI clocks are already synchronised.
+ *
+ * \param enabled Whether the events are recorded.
+ * \param comm The communicator of the traced processes.
+ */
+void trace_init(bool enabled, MPI_Comm comm) {
+    int rank, nProcesses, flag, *isGlobal;
+
+    traceEnabled = enabled;
+    if (!enabled) {
+        return;
+    }
+    if ((events = (TraceEvent *) malloc(TRACE_CAPACITY * sizeof(TraceEvent))) == NULL) {
+        fprintf(stderr, "trace_init(): error while allocating memory for the events\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    nEvents = 0;
+    clockOffset = 0.0;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+    MPI_Comm_get_attr(MPI_COMM_WORLD, MPI_WTIME_IS_GLOBAL, &isGlobal, &flag);
+    if (flag && *isGlobal) {
+        return;
+    }
+    for (int i = 1; i < nProcesses; i++) {
+        if (rank == 0) {
+            double rootTime;
+            MPI_Recv(NULL, 0, MPI_BYTE, i, 0, comm, MPI_STATUS_IGNORE);
+            rootTime = MPI_Wtime();
+            MPI_Send(&rootTime, 1, MPI_DOUBLE, i, 0, comm);
+        } else if (rank == i) {
+            double sent = MPI_Wtime(), rootTime;
+            MPI_Send(NULL, 0, MPI_BYTE, 0, 0, comm);
+            MPI_Recv(&rootTime, 1, MPI_DOUBLE, 0, 0, comm, MPI_STATUS_IGNORE);
+            clockOffset = rootTime - (sent + MPI_Wtime()) / 2.0;
+        }
+    }
+}
+
+/**
+ * \brief Records the beginning of an event (use trace_begin()).
+ *
+ * \param name The name of the event.
+ *
+ * \return the identifier of the event.
+ */
+int trace_record_begin(const char *name) {
+    TraceEvent *event = &events[nEvents % TRACE_CAPACITY];
+
+    strncpy(event->name, name, TRACE_NAME_LENGTH - 1);
+    event->name[TRACE_NAME_LENGTH - 1] = '\0';
+    event->end = -1.0;
+    event->begin = MPI_Wtime() + clockOffset;
+    return nEvents++;
+}
+
+/**
+ * \brief Records the end of an event (use trace_end()).
+ *
+ * \param event The identifier of the event, ignored if the event was already overwritten.
+ */
+void trace_record_end(int event) {
+    if (event >= 0 && event >= nEvents - TRACE_CAPACITY) {
+        events[event % TRACE_CAPACITY].end = MPI_Wtime() + clockOffset;
+    }
+}
+
+/**
+ * \brief Writes the events of every process as a Chrome trace.
+ *
+ * Every process of the communicator must call this function. The events still open are left out. Times
+ * are written in microseconds from the earliest event.
+ *
+ * \param path The path to the trace file, written by rank 0.
+ * \param comm The communicator of the traced processes.
+ */
+void trace_write(const char *path, MPI_Comm comm) {
+    int rank, nProcesses, count, first;
+    int *counts = NULL, *displs = NULL;
+    TraceEvent *ordered, *all = NULL;
+
+    if (!traceEnabled) {
+        return;
+    }
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &nProcesses);
+
+    /* oldest event first */
+    count = (nEvents < TRACE_CAPACITY) ? nEvents : TRACE_CAPACITY;
+    first = nEvents - count;
+    if ((ordered = (TraceEvent *) malloc((count > 0 ? count : 1) * sizeof(TraceEvent))) == NULL) {
+        fprintf(stderr, "trace_write(): error while allocating memory for the events\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    for (int i = 0; i < count; i++) {
+        ordered[i] = events[(first + i) % TRACE_CAPACITY];
+    }
+    count *= (int) sizeof(TraceEvent);
+
+    if (rank == 0) {
+        if (((counts = (int *) malloc(2 * nProcesses * sizeof(int))) == NULL)) {
+            fprintf(stderr, "trace_write(): error while allocating memory for the events\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+        displs = counts + nProcesses;
+    }
+    MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (rank == 0) {
+        int total = 0;
+        for (int i = 0; i < nProcesses; i++) {
+            displs[i] = total;
+            total += counts[i];
+        }
+        if ((all = (TraceEvent *) malloc(total > 0 ? total : 1)) == NULL) {
+            fprintf(stderr, "trace_write(): error while allocating memory for the events\n");
+            MPI_Abort(comm, EXIT_FAILURE);
+        }
+    }
+    MPI_Gatherv(ordered, count, MPI_BYTE, all, counts, displs, MPI_BYTE, 0, comm);
+
+    if (rank == 0) {
+        FILE *fp;
+        double origin = 0.0;
+        bool firstEvent = true;
+
+        for (int i = 0; i < nProcesses; i++) {
+            for (int e = 0; e < counts[i] / (int) sizeof(TraceEvent); e++) {
+                TraceEvent *event = (TraceEvent *) ((char *) all + displs[i]) + e;
+                if (firstEvent || event->begin < origin) {
+                    origin = event->begin;
+                    firstEvent = false;
+                }
+            }
+        }
+        if ((fp = fopen(path, "w")) == NULL) {
+            fprintf(stderr, "Error while opening file %s\n", path);
+        } else {
+            fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+            for (int i = 0; i < nProcesses; i++) { /* one track per rank */
+                fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+                            "\"args\": {\"name\": \"rank %d\"}}", (i == 0) ? "" : ",\n", i, i);
+            }
+            for (int i = 0; i < nProcesses; i++) {
+                for (int e = 0; e < counts[i] / (int) sizeof(TraceEvent); e++) {
+                    TraceEvent *event = (TraceEvent *) ((char *) all + displs[i]) + e;
+                    if (event->end < 0.0) {
+                        continue;
+                    }
+                    fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, "
+                                "\"dur\": %.3f}", event->name, i, (event->begin - origin) * 1.0e6,
+                            (event->end - event->begin) * 1.0e6);
+                }
+            }
+            fprintf(fp, "\n]}\n");
+            fclose(fp);
+        }
+        free(all);
+        free(counts);
+    }
+    free(ordered);
+    free(events);
+    events = NULL;
+    traceEnabled = false;
+}
@@ -0,0 +1,53 @@
+/**
+ *  \file trace.h (definition file)
+ *  \brief Header file containing the declarations for the timeline tracer of the processes.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <mpi.h>
+
+/** \brief number of events every process keeps (the oldest ones are overwritten) */
+#define TRACE_CAPACITY 4096
+/** \brief maximum length of the name of an event, including the terminator */
+#define TRACE_NAME_LENGTH 48
+
+typedef struct TraceEvent
+{
+    char name[TRACE_NAME_LENGTH];
+    double begin;   /* seconds, on the clock of rank 0 */
+    double end;     /* seconds, on the clock of rank 0 (negative while the event is open) */
+} TraceEvent;
+
+/** \brief whether the events are being recorded (set by trace_init()) */
+extern bool traceEnabled;
+
+extern void trace_init(bool enabled, MPI_Comm comm);
+extern int trace_record_begin(const char *name);
+extern void trace_record_end(int event);
+extern void trace_write(const char *path, MPI_Comm comm);
+
+/**
+ * \brief Opens an event of the timeline of this process.
+ *
+ * \param name The name of the event (phase).
+ *
+ * \return the identifier of the event, to be closed with trace_end().
+ */
+static inline int trace_begin(const char *name) {
+    return traceEnabled ? trace_record_begin(name) : -1;
+}
+
+/**
+ * \brief Closes an event of the timeline of this process.
+ *
+ * \param event The identifier returned by trace_begin().
+ */
+static inline void trace_end(int event) {
+    if (traceEnabled) {
+        trace_record_end(event);
+    }
+}
+
+#endif /* TRACE_H */
@@ -0,0 +1,205 @@
+/**
+ *  \file verifyList.c (definition file)
+ *  \brief Distributed verification of sorted lists.
+ *
+ *  Every process checks the order of its own block and the order between the last element of the
+ *  previous non-empty block and its first element, so the sorted list never needs to be gathered. An
+ *  order-independent checksum of the elements, computed before and after the sort, confirms that the
+ *  sorted list is a permutation of the input list.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+
+#include "verifyList.h"
+
+/** \brief size of the flag in front of the element exchanged by check_block_boundary() */
+#define BOUNDARY_FLAG_SIZE 8
+
+/**
+ * \brief Hashes the bytes of an element (FNV-1a followed by a 64-bit finaliser).
+ *
+ * \param element The element.
+ * \param size The size of the element.
+ *
+ * \return the hash of the element.
+ */
+static inline uint64_t hash_element(const unsigned char *element, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ element[i]) * 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * \brief Adds the elements of a list (or of a part of it) to a checksum.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param list The elements.
+ * \param length The number of elements.
+ * \param checksum The checksum to update.
+ */
+void add_to_checksum(int typeId, const void *list, long length, ListChecksum *checksum) {
+    size_t size = get_sort_type(typeId)->size;
+    const unsigned char *element = (const unsigned char *) list;
+
+    for (long i = 0; i < length; i++, element += size) {
+        uint64_t hash = hash_element(element, size);
+        checksum->sum += hash;
+        checksum->xor ^= hash;
+    }
+}
+
+/**
+ * \brief Checks that a list (or a block of a list) is sorted, reporting the first pair out of order.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param list The elements.
+ * \param length The number of elements.
+ * \param offset The position of the first element in the whole list, to report a failure.
+ *
+ * \return whether the elements are sorted.
+ */
+bool check_sorted_list(int typeId, const void *list, long length, long offset) {
+    const SortType *type = get_sort_type(typeId);
+    size_t size = type->size;
+    const char *elements = (const char *) list;
+    long position = type->find_unsorted(list, length);
+
+    if (position >= 0) {
+        fprintf(stderr, "Error in position %ld between element ", offset + position);
+        type->print_key(stderr, elements + position * size);
+        fprintf(stderr, " and ");
+        type->print_key(stderr, elements + (position + 1) * size);
+        fprintf(stderr, "\n");
+    }
+    return position < 0;
+}
+
+#ifndef THREADS_ONLY /* the verification across processes is left out of the threads-only build */
+/**
+ * \brief Combines the checksums of every process, so all of them get the checksum of the whole list.
+ *
+ * \param checksum The checksum of this process, replaced by the checksum of the whole list.
+ * \param comm The communicator of the processes sharing the list.
+ */
+void reduce_checksum(ListChecksum *checksum, MPI_Comm comm) {
+    MPI_Allreduce(MPI_IN_PLACE, &checksum->sum, 1, MPI_UINT64_T, MPI_SUM, comm);
+    MPI_Allreduce(MPI_IN_PLACE, &checksum->xor, 1, MPI_UINT64_T, MPI_BXOR, comm);
+}
+
+/**
+ * \brief Reduction keeping the right-most value that is flagged as present.
+ *
+ * \param in The values of the lower ranks.
+ * \param inout The values of the higher ranks, replaced by the result.
+ * \param len The number of values.
+ * \param datatype The datatype of a value: the flag followed by an element.
+ */
+static void keep_last_present(void *in, void *inout, int *len, MPI_Datatype *datatype) {
+    int bytes;
+
+    MPI_Type_size(*datatype, &bytes);
+    for (int i = 0; i < *len; i++) {
+        char *lower = (char *) in + (size_t) i * bytes, *higher = (char *) inout + (size_t) i * bytes;
+        if (higher[0] == 0) {
+            memcpy(higher, lower, bytes);
+        }
+    }
+}
+
+/**
+ * \brief Checks the order between the last element of the previous non-empty block and the first element
+ * of the block of this process.
+ *
+ * Every process of the communicator must call this function, in rank order of the blocks. The last
+ * element of the previous non-empty block is found with a single exclusive scan, so empty blocks are
+ * skipped.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param first The first element of the block, or NULL if the block is empty.
+ * \param last The last element of the block, or NULL if the block is empty.
+ * \param offset The position of the first element of the block in the list, to report a failure.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return whether the boundary of this block is in order (the verdict of this process only).
+ */
+bool check_block_boundary(int typeId, const void *first, const void *last, long offset, MPI_Comm comm) {
+    const SortType *type = get_sort_type(typeId);
+    size_t size = type->size;
+    int rank;
+    bool sorted = true;
+    char *mine, *previous, *pair;
+    MPI_Datatype boundaryType;
+    MPI_Op op;
+
+    MPI_Comm_rank(comm, &rank);
+    if (((mine = (char *) calloc(2, BOUNDARY_FLAG_SIZE + size)) == NULL) ||
+        ((pair = (char *) malloc(2 * size)) == NULL)) {
+        fprintf(stderr, "check_block_boundary(): error while allocating memory for the boundary\n");
+        MPI_Abort(comm, EXIT_FAILURE);
+    }
+    previous = mine + BOUNDARY_FLAG_SIZE + size;
+    if (last != NULL) {
+        mine[0] = 1;
+        memcpy(mine + BOUNDARY_FLAG_SIZE, last, size);
+    }
+    MPI_Type_contiguous((int) (BOUNDARY_FLAG_SIZE + size), MPI_BYTE, &boundaryType);
+    MPI_Type_commit(&boundaryType);
+    MPI_Op_create(keep_last_present, 0, &op);
+    MPI_Exscan(mine, previous, 1, boundaryType, op, comm);
+    MPI_Op_free(&op);
+    MPI_Type_free(&boundaryType);
+
+    if (rank > 0 && first != NULL && previous[0] != 0) {
+        memcpy(pair, previous + BOUNDARY_FLAG_SIZE, size);
+        memcpy(pair + size, first, size);
+        if (type->find_unsorted(pair, 2) >= 0) {
+            fprintf(stderr, "Error in position %ld between element ", offset - 1);
+            type->print_key(stderr, pair);
+            fprintf(stderr, " and ");
+            type->print_key(stderr, pair + size);
+            fprintf(stderr, "\n");
+            sorted = false;
+        }
+    }
+    free(pair);
+    free(mine);
+    return sorted;
+}
+
+/**
+ * \brief Checks that a list distributed in blocks is sorted.
+ *
+ * Every process of the communicator must call this function with its block, in rank order of the
+ * blocks. Every process checks its own block and its boundary with the previous non-empty block, and the
+ * verdicts are combined.
+ *
+ * \param typeId The element type of the list (one of TYPE_*).
+ * \param block The block of the list held by this process.
+ * \param length The number of elements of the block.
+ * \param offset The position of the first element of the block in the list, to report a failure.
+ * \param comm The communicator of the processes sharing the list.
+ *
+ * \return whether the whole list is sorted (the same verdict on every process).
+ */
+bool check_sorted_blocks(int typeId, const void *block, long length, long offset, MPI_Comm comm) {
+    size_t size = get_sort_type(typeId)->size;
+    const char *elements = (const char *) block;
+    bool sorted = check_sorted_list(typeId, block, length, offset);
+
+    if (!check_block_boundary(typeId, (length > 0) ? elements : NULL,
+                              (length > 0) ? elements + (length - 1) * size : NULL, offset, comm)) {
+        sorted = false;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &sorted, 1, MPI_C_BOOL, MPI_LAND, comm);
+    return sorted;
+}
+#endif /* THREADS_ONLY */
@@ -0,0 +1,31 @@
+/**
+ *  \file verifyList.h (definition file)
+ *  \brief Header file containing the declarations for the distributed verification of sorted lists.
+ */
+#ifndef VERIFY_LIST_H
+#define VERIFY_LIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#ifndef THREADS_ONLY
+#include <mpi.h>
+#endif
+
+#include "sorting.h"
+
+/** \brief order-independent checksum of the elements of a list, to check that a sort kept all of them */
+typedef struct ListChecksum
+{
+    uint64_t sum;   /* sum of the hashes of the elements */
+    uint64_t xor;   /* exclusive or of the hashes of the elements */
+} ListChecksum;
+
+extern void add_to_checksum(int typeId, const void *list, long length, ListChecksum *checksum);
+extern bool check_sorted_list(int typeId, const void *list, long length, long offset);
+#ifndef THREADS_ONLY
+extern void reduce_checksum(ListChecksum *checksum, MPI_Comm comm);
+extern bool check_block_boundary(int typeId, const void *first, const void *last, long offset, MPI_Comm comm);
+extern bool check_sorted_blocks(int typeId, const void *block, long length, long offset, MPI_Comm comm);
+#endif
+
+#endif /* VERIFY_LIST_H */
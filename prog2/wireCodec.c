@@ -0,0 +1,225 @@
+/**
+ *  \file wireCodec.c (definition file)
+ *  \brief Compression of the sorted runs sent between processes.
+ *
+ *  A run of integer keys is cut in frames of CODEC_FRAME_LENGTH elements. A frame stores its first
+ *  element and the differences between consecutive elements, bit-packed with the width of the largest one
+ *  (delta plus frame-of-reference encoding). In a sorted run the differences are small and non-negative,
+ *  so a frame takes a fraction of its raw size; any other run is still encoded losslessly, with wider
+ *  frames. Frames are byte aligned, and the differences and their width are computed in plain loops over
+ *  the frame, which the compiler vectorises.
+ *
+ *  Both ends of a transfer decide whether to use the codec from the number of elements alone, so the
+ *  receiver knows how to decode a message without any extra header.
+ *
+ * Author:  Renan Ferreira
+ *          João Reis
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "wireCodec.h"
+
+/** \brief bytes of the runs encoded by this process, before and after encoding */
+static long long totalRawBytes, totalWireBytes;
+
+/** \brief sink of a stream of bits, packed from the least significant bit of every byte */
+typedef struct BitWriter
+{
+    unsigned char *out;
+    uint64_t pending;   /* bits not yet written */
+    int nPending;       /* number of bits not yet written (less than 8 between calls) */
+} BitWriter;
+
+/** \brief source of a stream of bits, read in the order of BitWriter */
+typedef struct BitReader
+{
+    const unsigned char *in;
+    uint64_t available; /* bits read but not consumed */
+    int nAvailable;     /* number of bits read but not consumed */
+} BitReader;
+
+/**
+ * \brief Appends up to 32 bits to a stream.
+ *
+ * \param writer The stream.
+ * \param value The bits, in the least significant positions.
+ * \param nBits The number of bits (at most 32).
+ */
+static inline void put_bits(BitWriter *writer, uint64_t value, int nBits) {
+    writer->pending |= (value & ((1ULL << nBits) - 1)) << writer->nPending;
+    writer->nPending += nBits;
+    while (writer->nPending >= 8) {
+        *writer->out++ = (unsigned char) writer->pending;
+        writer->pending >>= 8;
+        writer->nPending -= 8;
+    }
+}
+
+/**
+ * \brief Consumes up to 32 bits of a stream.
+ *
+ * \param reader The stream.
+ * \param nBits The number of bits (at most 32).
+ *
+ * \return the bits, in the least significant positions.
+ */
+static inline uint64_t get_bits(BitReader *reader, int nBits) {
+    uint64_t value;
+
+    while (reader->nAvailable < nBits) {
+        reader->available |= (uint64_t) *reader->in++ << reader->nAvailable;
+        reader->nAvailable += 8;
+    }
+    value = reader->available & ((1ULL << nBits) - 1);
+    reader->available >>= nBits;
+    reader->nAvailable -= nBits;
+    return value;
+}
+
+/**
+ * \brief Checks whether the runs of an element type can be encoded (integer keys only).
+ *
+ * \param typeId The element type (one of TYPE_*).
+ *
+ * \return true if the type has integer keys, false otherwise.
+ */
+bool is_codec_type(int typeId) {
+    return typeId == TYPE_INT32 || typeId == TYPE_INT64;
+}
+
+/**
+ * \brief Decides whether a run is sent encoded. Both ends of a transfer must agree on it.
+ *
+ * \param typeId The element type of the run (one of TYPE_*).
+ * \param length The number of elements of the run.
+ * \param threshold The raw size from which runs are encoded, in bytes (0 to never encode them).
+ *
+ * \return true if the run is encoded, false if it is sent as it is.
+ */
+bool use_codec(int typeId, long length, size_t threshold) {
+    return threshold > 0 && is_codec_type(typeId) && length > 0 &&
+           (size_t) length * get_sort_type(typeId)->size >= threshold;
+}
+
+/**
+ * \brief Gets the largest size of an encoded run.
+ *
+ * \param length The number of elements of the run.
+ *
+ * \return the number of bytes to reserve for the encoded run.
+ */
+size_t get_codec_bound(long length) {
+    size_t nFrames = (size_t) (length + CODEC_FRAME_LENGTH - 1) / CODEC_FRAME_LENGTH;
+
+    return nFrames * CODEC_FRAME_HEADER + (size_t) length * sizeof(uint64_t);
+}
+
+/**
+ * \brief Encodes a run of integer keys.
+ *
+ * \param typeId The element type of the run (TYPE_INT32 or TYPE_INT64).
+ * \param list The elements, preferably sorted.
+ * \param length The number of elements.
+ * \param out Where the run is encoded, with room for get_codec_bound(length) bytes.
+ *
+ * \return the size of the encoded run, in bytes.
+ */
+size_t encode_sorted_run(int typeId, const void *list, long length, unsigned char *out) {
+    uint64_t values[CODEC_FRAME_LENGTH], deltas[CODEC_FRAME_LENGTH];
+    unsigned char *start = out;
+
+    for (long first = 0; first < length; first += CODEC_FRAME_LENGTH) {
+        int n = (length - first < CODEC_FRAME_LENGTH) ? (int) (length - first) : CODEC_FRAME_LENGTH;
+        uint64_t widest = 0;
+        int width = 0;
+        BitWriter writer = {out + CODEC_FRAME_HEADER, 0, 0};
+
+        if (typeId == TYPE_INT32) { /* sign-extended, so differences of sorted keys stay non-negative */
+            const int32_t *keys = (const int32_t *) list + first;
+            for (int i = 0; i < n; i++) {
+                values[i] = (uint64_t) (int64_t) keys[i];
+            }
+        } else {
+            memcpy(values, (const int64_t *) list + first, n * sizeof(uint64_t));
+        }
+        for (int i = 1; i < n; i++) {
+            deltas[i] = values[i] - values[i - 1];
+        }
+        for (int i = 1; i < n; i++) {
+            widest |= deltas[i];
+        }
+        while (width < 64 && (widest >> width) != 0) {
+            width++;
+        }
+
+        memcpy(out, &values[0], sizeof(uint64_t));
+        out[8] = (unsigned char) width;
+        for (int i = 1; i < n; i++) {
+            if (width > 32) {
+                put_bits(&writer, deltas[i], 32);
+                put_bits(&writer, deltas[i] >> 32, width - 32);
+            } else {
+                put_bits(&writer, deltas[i], width);
+            }
+        }
+        if (writer.nPending > 0) { /* frames are byte aligned */
+            *writer.out++ = (unsigned char) writer.pending;
+        }
+        out = writer.out;
+    }
+    totalRawBytes += (long long) length * get_sort_type(typeId)->size;
+    totalWireBytes += out - start;
+    return (size_t) (out - start);
+}
+
+/**
+ * \brief Decodes a run of integer keys.
+ *
+ * \param typeId The element type of the run (TYPE_INT32 or TYPE_INT64).
+ * \param in The encoded run.
+ * \param length The number of elements of the run.
+ * \param list Where the elements are decoded.
+ */
+void decode_sorted_run(int typeId, const unsigned char *in, long length, void *list) {
+    uint64_t values[CODEC_FRAME_LENGTH];
+
+    for (long first = 0; first < length; first += CODEC_FRAME_LENGTH) {
+        int n = (length - first < CODEC_FRAME_LENGTH) ? (int) (length - first) : CODEC_FRAME_LENGTH;
+        int width = in[8];
+        BitReader reader = {in + CODEC_FRAME_HEADER, 0, 0};
+
+        memcpy(&values[0], in, sizeof(uint64_t));
+        for (int i = 1; i < n; i++) {
+            uint64_t delta;
+            if (width > 32) {
+                delta = get_bits(&reader, 32);
+                delta |= get_bits(&reader, width - 32) << 32;
+            } else {
+                delta = get_bits(&reader, width);
+            }
+            values[i] = values[i - 1] + delta;
+        }
+        if (typeId == TYPE_INT32) {
+            int32_t *keys = (int32_t *) list + first;
+            for (int i = 0; i < n; i++) {
+                keys[i] = (int32_t) values[i];
+            }
+        } else {
+            memcpy((int64_t *) list + first, values, n * sizeof(uint64_t));
+        }
+        in = reader.in; /* the unread bits of the last byte are padding */
+    }
+}
+
+/**
+ * \brief Gets the bytes of the runs encoded by this process so far, before and after encoding.
+ *
+ * \param rawBytes The size of the runs before encoding.
+ * \param wireBytes The size of the encoded runs.
+ */
+void get_codec_totals(long long *rawBytes, long long *wireBytes) {
+    *rawBytes = totalRawBytes;
+    *wireBytes = totalWireBytes;
+}
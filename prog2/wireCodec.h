@@ -0,0 +1,26 @@
+/**
+ *  \file wireCodec.h (definition file)
+ *  \brief Header file containing the declarations for the compression of the sorted runs sent between
+ *  processes.
+ */
+#ifndef WIRE_CODEC_H
+#define WIRE_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sorting.h"
+
+/** \brief number of elements of a frame, which shares a base value and a bit width */
+#define CODEC_FRAME_LENGTH 128
+/** \brief size of the header of a frame: base value and bit width of the deltas */
+#define CODEC_FRAME_HEADER 9
+
+extern bool is_codec_type(int typeId);
+extern bool use_codec(int typeId, long length, size_t threshold);
+extern size_t get_codec_bound(long length);
+extern size_t encode_sorted_run(int typeId, const void *list, long length, unsigned char *out);
+extern void decode_sorted_run(int typeId, const unsigned char *in, long length, void *list);
+extern void get_codec_totals(long long *rawBytes, long long *wireBytes);
+
+#endif /* WIRE_CODEC_H */